@@ -0,0 +1,305 @@
+##
+# Analyze the memory allocation trace dumped by the MemoryProfileInfo application.
+#
+# The DXE core records page and pool allocate/free events in a ring buffer when
+# PcdMemoryAllocationTraceEntries is not 0. This tool decodes the dump of that
+# ring and attributes every event to the image that contains its caller, then
+# reports per driver usage, allocation rates and an outstanding memory and
+# fragmentation timeline.
+#
+# Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+##
+
+from __future__ import print_function
+import re
+import sys
+from optparse import OptionParser
+
+versionNumber = "1.0"
+__copyright__ = "Copyright (c) 2019, Intel Corporation. All rights reserved."
+
+EFI_PAGE_SIZE = 0x1000
+
+ALLOCATE_ACTIONS = ("AllocatePages", "AllocatePool")
+FREE_ACTIONS = ("FreePages", "FreePool")
+
+headerPattern = re.compile(r"^(EntryCount|NextSequence|TimerFrequency|TimerStart|TimerEnd|Lost)\s+- (0x[0-9a-fA-F]+)")
+entryPattern = re.compile(
+    r"^(0x[0-9a-fA-F]+) (\w+) Tpl (0x[0-9a-fA-F]+) Type (0x[0-9a-fA-F]+) Time (0x[0-9a-fA-F]+) "
+    r"Buffer (0x[0-9a-fA-F]+) Size (0x[0-9a-fA-F]+) Caller (0x[0-9a-fA-F]+) File ([0-9a-fA-F-]+)"
+    )
+
+UNKNOWN_DRIVER = "Unknown"
+ZERO_GUID = "00000000-0000-0000-0000-000000000000"
+
+class TraceEvent:
+    def __init__(self, match):
+        self.sequence = int(match.group(1), 16)
+        self.action = match.group(2)
+        self.tpl = int(match.group(3), 16)
+        self.memoryType = int(match.group(4), 16)
+        self.timeStamp = int(match.group(5), 16)
+        self.buffer = int(match.group(6), 16)
+        self.size = int(match.group(7), 16)
+        self.caller = int(match.group(8), 16)
+        self.fileName = match.group(9).upper()
+        # Filled in while the events are replayed.
+        self.time = 0.0
+        self.bytes = 0
+
+class DriverUsage:
+    def __init__(self, name):
+        self.name = name
+        self.allocateCount = 0
+        self.freeCount = 0
+        self.allocatedBytes = 0
+        self.outstandingBytes = 0
+        self.peakBytes = 0
+        self.peakTime = 0.0
+        self.firstTime = None
+        self.lastTime = 0.0
+
+    def allocate(self, size, time):
+        self.allocateCount += 1
+        self.allocatedBytes += size
+        self.outstandingBytes += size
+        if self.outstandingBytes > self.peakBytes:
+            self.peakBytes = self.outstandingBytes
+            self.peakTime = time
+        if self.firstTime is None:
+            self.firstTime = time
+        self.lastTime = time
+
+    def free(self, size, time):
+        self.freeCount += 1
+        self.outstandingBytes -= size
+        self.lastTime = time
+
+    def rate(self):
+        # Allocations per second over the time the driver was allocating.
+        if self.firstTime is None or self.lastTime <= self.firstTime:
+            return 0.0
+        return self.allocateCount / ((self.lastTime - self.firstTime) / 1000.0)
+
+class TraceAnalyzer:
+    def __init__(self, options):
+        self.options = options
+        self.header = {}
+        self.events = []
+        # Loaded images: list of (base, end, name), latest first.
+        self.images = []
+        # Outstanding allocations: buffer -> (bytes, driver, isPages)
+        self.outstanding = {}
+        self.drivers = {}
+        self.unmatchedFrees = 0
+        self.timeline = []
+
+    def parse(self, inputFile):
+        inTrace = False
+        for line in inputFile:
+            line = line.strip()
+            if line.startswith("======= MemoryAllocationTrace begin"):
+                inTrace = True
+                continue
+            if line.startswith("======= MemoryAllocationTrace end"):
+                break
+            if not inTrace:
+                continue
+            match = headerPattern.match(line)
+            if match:
+                self.header[match.group(1)] = int(match.group(2), 16)
+                continue
+            match = entryPattern.match(line)
+            if match:
+                self.events.append(TraceEvent(match))
+        self.events.sort(key=lambda event: event.sequence)
+        return inTrace
+
+    def toMilliseconds(self, start, timeStamp):
+        timerStart = self.header.get("TimerStart", 0)
+        timerEnd = self.header.get("TimerEnd", 0)
+        frequency = self.header.get("TimerFrequency", 0)
+        if timerStart > timerEnd:
+            ticks = start - timeStamp
+        else:
+            ticks = timeStamp - start
+        if ticks < 0:
+            # The counter wrapped around.
+            ticks += abs(timerEnd - timerStart) + 1
+        if frequency == 0:
+            return float(ticks)
+        return ticks * 1000.0 / frequency
+
+    def driverName(self, address):
+        for (base, end, name) in self.images:
+            if base <= address < end:
+                return name
+        return UNKNOWN_DRIVER
+
+    def usage(self, name):
+        if name not in self.drivers:
+            self.drivers[name] = DriverUsage(name)
+        return self.drivers[name]
+
+    def fragmentation(self):
+        # Gaps between adjacent outstanding page allocations that are at most
+        # the hole limit: free memory that is too small to be reused for a
+        # large allocation because the pages around it are still in use.
+        ranges = sorted(
+            (buffer, buffer + size)
+            for (buffer, (size, driver, isPages)) in self.outstanding.items()
+            if isPages
+            )
+        holes = 0
+        holePages = 0
+        limit = self.options.holeLimit * EFI_PAGE_SIZE
+        for index in range(1, len(ranges)):
+            gap = ranges[index][0] - ranges[index - 1][1]
+            if 0 < gap <= limit:
+                holes += 1
+                holePages += gap // EFI_PAGE_SIZE
+        return (len(ranges), holes, holePages)
+
+    def sample(self, time):
+        pageBytes = 0
+        poolBytes = 0
+        for (size, driver, isPages) in self.outstanding.values():
+            if isPages:
+                pageBytes += size
+            else:
+                poolBytes += size
+        (liveRanges, holes, holePages) = self.fragmentation()
+        self.timeline.append((time, pageBytes, poolBytes, len(self.outstanding), liveRanges, holes, holePages))
+
+    def replay(self):
+        if not self.events:
+            return
+        start = self.events[0].timeStamp
+        nextSample = 0.0
+        for event in self.events:
+            event.time = self.toMilliseconds(start, event.timeStamp)
+            while event.time >= nextSample:
+                self.sample(nextSample)
+                nextSample += self.options.interval
+
+            if event.action == "ImageStart":
+                name = event.fileName
+                if name == ZERO_GUID:
+                    name = "Image@0x%x" % event.buffer
+                self.images.insert(0, (event.buffer, event.buffer + event.size * EFI_PAGE_SIZE, name))
+                continue
+            if event.action == "ImageUnload":
+                self.images = [image for image in self.images if image[0] != event.buffer]
+                continue
+
+            isPages = event.action in ("AllocatePages", "FreePages")
+            if isPages:
+                event.bytes = event.size * EFI_PAGE_SIZE
+            else:
+                event.bytes = event.size
+
+            if event.action in ALLOCATE_ACTIONS:
+                driver = self.driverName(event.caller)
+                self.outstanding[event.buffer] = (event.bytes, driver, isPages)
+                self.usage(driver).allocate(event.bytes, event.time)
+            elif event.action in FREE_ACTIONS:
+                # Charge the free to the driver that allocated the buffer, it
+                # may be released by another one. FreePool has no size, the
+                # size comes from the matching AllocatePool.
+                if event.buffer not in self.outstanding:
+                    self.unmatchedFrees += 1
+                    continue
+                (size, driver, wasPages) = self.outstanding[event.buffer]
+                if isPages and event.bytes < size:
+                    self.outstanding[event.buffer + event.bytes] = (size - event.bytes, driver, wasPages)
+                    size = event.bytes
+                del self.outstanding[event.buffer]
+                self.usage(driver).free(size, event.time)
+        self.sample(self.events[-1].time)
+
+    def report(self, out):
+        print("Memory Allocation Trace Analysis", file=out)
+        print("  Events        - %d" % len(self.events), file=out)
+        print("  Lost events   - %d" % self.header.get("Lost", 0), file=out)
+        overwritten = self.header.get("NextSequence", 1) - 1 - len(self.events) - self.header.get("Lost", 0)
+        if overwritten > 0:
+            print("  Overwritten   - %d (ring too small, increase PcdMemoryAllocationTraceEntries)" % overwritten, file=out)
+        print("  Unmatched free- %d (allocated before the oldest event)" % self.unmatchedFrees, file=out)
+        if self.events:
+            print("  Duration      - %.3f ms" % self.events[-1].time, file=out)
+        print("", file=out)
+
+        print("Per driver usage, sorted by peak outstanding bytes:", file=out)
+        print("  %-38s %10s %10s %14s %14s %12s %12s %12s" %
+              ("Driver", "Allocs", "Frees", "Allocated", "Outstanding", "Peak", "PeakTime(ms)", "Allocs/s"), file=out)
+        for usage in sorted(self.drivers.values(), key=lambda usage: usage.peakBytes, reverse=True):
+            print("  %-38s %10d %10d %14d %14d %12d %12.3f %12.1f" % (
+                usage.name,
+                usage.allocateCount,
+                usage.freeCount,
+                usage.allocatedBytes,
+                usage.outstandingBytes,
+                usage.peakBytes,
+                usage.peakTime,
+                usage.rate()
+                ), file=out)
+        print("", file=out)
+
+        print("Timeline, one sample every %.3f ms (holes are gaps of at most %d pages between live page allocations):" %
+              (self.options.interval, self.options.holeLimit), file=out)
+        print("  %12s %14s %14s %10s %10s %8s %10s" %
+              ("Time(ms)", "PageBytes", "PoolBytes", "Live", "PageRanges", "Holes", "HolePages"), file=out)
+        for (time, pageBytes, poolBytes, live, liveRanges, holes, holePages) in self.timeline:
+            print("  %12.3f %14d %14d %10d %10d %8d %10d" %
+                  (time, pageBytes, poolBytes, live, liveRanges, holes, holePages), file=out)
+
+def myOptionParser():
+    usage = "%prog [--version] [-h] [--help] [-i inputfile [-o outputfile] [--interval ms] [--hole-limit pages]]"
+    Parser = OptionParser(usage=usage, description=__copyright__, version="%prog " + str(versionNumber))
+    Parser.add_option("-i", "--inputfile", dest="inputfilename", type="string", help="The input memory profile info file output from MemoryProfileInfo application in MdeModulePkg")
+    Parser.add_option("-o", "--outputfile", dest="outputfilename", type="string", help="The output analysis file, MemoryAllocationTrace.txt will be used if it is not specified")
+    Parser.add_option("--interval", dest="interval", type="float", default=10.0, help="The timeline sample interval in milliseconds, 10 by default")
+    Parser.add_option("--hole-limit", dest="holeLimit", type="int", default=16, help="The largest gap in pages between live page allocations that is reported as a hole, 16 by default")
+
+    (Options, args) = Parser.parse_args()
+    if Options.inputfilename is None:
+        Parser.error("no input file specified")
+    if Options.outputfilename is None:
+        Options.outputfilename = "MemoryAllocationTrace.txt"
+    if Options.interval <= 0:
+        Parser.error("interval must be positive")
+    return Options
+
+def main():
+    Options = myOptionParser()
+    analyzer = TraceAnalyzer(Options)
+
+    try :
+        file = open(Options.inputfilename)
+    except Exception:
+        print("fail to open " + Options.inputfilename)
+        return 1
+    try:
+        if not analyzer.parse(file):
+            print("no memory allocation trace found in " + Options.inputfilename)
+            return 1
+    finally:
+        file.close()
+
+    analyzer.replay()
+
+    try :
+        newfile = open(Options.outputfilename, "w")
+    except Exception:
+        print("fail to open " + Options.outputfilename)
+        return 1
+    try:
+        analyzer.report(newfile)
+    finally:
+        newfile.close()
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,7 +1,7 @@
 /** @file
 CalculateCrc32 routine.
 
-Copyright (c) 2004 - 2018, Intel Corporation. All rights reserved.<BR>
+Copyright (c) 2004 - 2019, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
@@ -9,6 +9,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <stdlib.h>
 #include "Crc32.h"
 
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#include <immintrin.h>
+#define CRC32_PCLMUL_SUPPORT
+#endif
+
 UINT32  mCrcTable[256] = {
   0x00000000,
   0x77073096,
@@ -268,6 +273,220 @@ UINT32  mCrcTable[256] = {
   0x2D02EF8D
 };
 
+//
+// mCrcSliceTable[N][Byte] is the CRC of Byte followed by N zero bytes, which
+// lets the generic path consume eight bytes per step (slicing-by-8). The
+// first slice is mCrcTable itself, the others are derived from it on first use.
+//
+STATIC UINT32   mCrcSliceTable[8][256];
+STATIC BOOLEAN  mCrcSliceTableReady = FALSE;
+
+STATIC
+VOID
+InitializeCrcSliceTable (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Derive the slicing-by-8 tables from mCrcTable.
+
+--*/
+{
+  UINTN   Index;
+  UINTN   Slice;
+  UINT32  Crc;
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = mCrcTable[Index];
+    mCrcSliceTable[0][Index] = Crc;
+    for (Slice = 1; Slice < 8; Slice++) {
+      Crc = (Crc >> 8) ^ mCrcTable[Crc & 0xFF];
+      mCrcSliceTable[Slice][Index] = Crc;
+    }
+  }
+
+  mCrcSliceTableReady = TRUE;
+}
+
+STATIC
+UINT32
+Crc32Generic (
+  IN UINT32  Crc,
+  IN UINT8   *Data,
+  IN UINTN   DataSize
+  )
+/*++
+
+Routine Description:
+
+  Update a pre-inverted CRC32 with the slicing-by-8 tables.
+
+Arguments:
+
+  Crc         - The current CRC, without the final inversion
+  Data        - The buffer containing the data to be processed
+  DataSize    - The size of data to be processed
+
+Returns:
+
+  The updated CRC, without the final inversion.
+
+--*/
+{
+  UINT32  Low;
+  UINT32  High;
+
+  if (!mCrcSliceTableReady) {
+    InitializeCrcSliceTable ();
+  }
+
+  while (DataSize >= 8) {
+    //
+    // Assemble the words byte by byte, so that the result does not depend on
+    // the alignment of Data or on the endianness of the host.
+    //
+    Low  = Crc ^ ((UINT32) Data[0] | ((UINT32) Data[1] << 8) | ((UINT32) Data[2] << 16) | ((UINT32) Data[3] << 24));
+    High = (UINT32) Data[4] | ((UINT32) Data[5] << 8) | ((UINT32) Data[6] << 16) | ((UINT32) Data[7] << 24);
+    Crc  = mCrcSliceTable[7][Low & 0xFF] ^
+           mCrcSliceTable[6][(Low >> 8) & 0xFF] ^
+           mCrcSliceTable[5][(Low >> 16) & 0xFF] ^
+           mCrcSliceTable[4][Low >> 24] ^
+           mCrcSliceTable[3][High & 0xFF] ^
+           mCrcSliceTable[2][(High >> 8) & 0xFF] ^
+           mCrcSliceTable[1][(High >> 16) & 0xFF] ^
+           mCrcSliceTable[0][High >> 24];
+    Data     += 8;
+    DataSize -= 8;
+  }
+
+  while (DataSize-- != 0) {
+    Crc = (Crc >> 8) ^ mCrcTable[(UINT8) Crc ^ *Data++];
+  }
+
+  return Crc;
+}
+
+#ifdef CRC32_PCLMUL_SUPPORT
+
+//
+// Folding constants for the bit-reflected CRC32 polynomial, from the Intel
+// white paper "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+// Instruction".
+//
+STATIC CONST UINT64  mCrcFold512[2]  __attribute__ ((aligned (16))) = { 0x0154442BD4ULL, 0x01C6E41596ULL };
+STATIC CONST UINT64  mCrcFold128[2]  __attribute__ ((aligned (16))) = { 0x01751997D0ULL, 0x00CCAA009EULL };
+STATIC CONST UINT64  mCrcFold64[2]   __attribute__ ((aligned (16))) = { 0x0163CD6124ULL, 0 };
+STATIC CONST UINT64  mCrcBarrett[2]  __attribute__ ((aligned (16))) = { 0x01DB710641ULL, 0x01F7011641ULL };
+
+STATIC
+UINT32
+__attribute__ ((target ("pclmul,sse4.1")))
+Crc32Pclmul (
+  IN UINT32  Crc,
+  IN UINT8   *Data,
+  IN UINTN   DataSize
+  )
+/*++
+
+Routine Description:
+
+  Update a pre-inverted CRC32 with carry-less multiplications. Four 128-bit
+  lanes are folded 64 bytes at a time, then folded into one lane, and the
+  result is reduced to 32 bits with a Barrett reduction.
+
+Arguments:
+
+  Crc         - The current CRC, without the final inversion
+  Data        - The buffer containing the data to be processed, DataSize must
+                be a multiple of 16 and at least 64
+  DataSize    - The size of data to be processed
+
+Returns:
+
+  The updated CRC, without the final inversion.
+
+--*/
+{
+  __m128i  Fold;
+  __m128i  X1;
+  __m128i  X2;
+  __m128i  X3;
+  __m128i  X4;
+  __m128i  T1;
+  __m128i  T2;
+  __m128i  T3;
+  __m128i  T4;
+  __m128i  Mask;
+
+  X1 = _mm_xor_si128 (_mm_loadu_si128 ((__m128i *) (Data + 0x00)), _mm_cvtsi32_si128 ((int) Crc));
+  X2 = _mm_loadu_si128 ((__m128i *) (Data + 0x10));
+  X3 = _mm_loadu_si128 ((__m128i *) (Data + 0x20));
+  X4 = _mm_loadu_si128 ((__m128i *) (Data + 0x30));
+  Data     += 64;
+  DataSize -= 64;
+
+  Fold = _mm_load_si128 ((__m128i *) mCrcFold512);
+  while (DataSize >= 64) {
+    T1 = _mm_clmulepi64_si128 (X1, Fold, 0x00);
+    T2 = _mm_clmulepi64_si128 (X2, Fold, 0x00);
+    T3 = _mm_clmulepi64_si128 (X3, Fold, 0x00);
+    T4 = _mm_clmulepi64_si128 (X4, Fold, 0x00);
+    X1 = _mm_clmulepi64_si128 (X1, Fold, 0x11);
+    X2 = _mm_clmulepi64_si128 (X2, Fold, 0x11);
+    X3 = _mm_clmulepi64_si128 (X3, Fold, 0x11);
+    X4 = _mm_clmulepi64_si128 (X4, Fold, 0x11);
+    X1 = _mm_xor_si128 (_mm_xor_si128 (X1, T1), _mm_loadu_si128 ((__m128i *) (Data + 0x00)));
+    X2 = _mm_xor_si128 (_mm_xor_si128 (X2, T2), _mm_loadu_si128 ((__m128i *) (Data + 0x10)));
+    X3 = _mm_xor_si128 (_mm_xor_si128 (X3, T3), _mm_loadu_si128 ((__m128i *) (Data + 0x20)));
+    X4 = _mm_xor_si128 (_mm_xor_si128 (X4, T4), _mm_loadu_si128 ((__m128i *) (Data + 0x30)));
+    Data     += 64;
+    DataSize -= 64;
+  }
+
+  //
+  // Fold the four lanes into one, then fold the remaining 16-byte blocks.
+  //
+  Fold = _mm_load_si128 ((__m128i *) mCrcFold128);
+  T1 = _mm_clmulepi64_si128 (X1, Fold, 0x00);
+  X1 = _mm_xor_si128 (_mm_xor_si128 (_mm_clmulepi64_si128 (X1, Fold, 0x11), T1), X2);
+  T1 = _mm_clmulepi64_si128 (X1, Fold, 0x00);
+  X1 = _mm_xor_si128 (_mm_xor_si128 (_mm_clmulepi64_si128 (X1, Fold, 0x11), T1), X3);
+  T1 = _mm_clmulepi64_si128 (X1, Fold, 0x00);
+  X1 = _mm_xor_si128 (_mm_xor_si128 (_mm_clmulepi64_si128 (X1, Fold, 0x11), T1), X4);
+
+  while (DataSize >= 16) {
+    T1 = _mm_clmulepi64_si128 (X1, Fold, 0x00);
+    X1 = _mm_xor_si128 (_mm_xor_si128 (_mm_clmulepi64_si128 (X1, Fold, 0x11), T1), _mm_loadu_si128 ((__m128i *) Data));
+    Data     += 16;
+    DataSize -= 16;
+  }
+
+  //
+  // Fold 128 bits to 64 bits.
+  //
+  Mask = _mm_setr_epi32 (~0, 0, ~0, 0);
+  T1 = _mm_clmulepi64_si128 (X1, Fold, 0x10);
+  X1 = _mm_xor_si128 (_mm_srli_si128 (X1, 8), T1);
+
+  Fold = _mm_loadl_epi64 ((__m128i *) mCrcFold64);
+  T1 = _mm_srli_si128 (X1, 4);
+  X1 = _mm_xor_si128 (_mm_clmulepi64_si128 (_mm_and_si128 (X1, Mask), Fold, 0x00), T1);
+
+  //
+  // Barrett reduction to 32 bits.
+  //
+  Fold = _mm_load_si128 ((__m128i *) mCrcBarrett);
+  T1 = _mm_clmulepi64_si128 (_mm_and_si128 (X1, Mask), Fold, 0x10);
+  T1 = _mm_clmulepi64_si128 (_mm_and_si128 (T1, Mask), Fold, 0x00);
+  X1 = _mm_xor_si128 (X1, T1);
+
+  return (UINT32) _mm_extract_epi32 (X1, 1);
+}
+
+#endif
+
 EFI_STATUS
 CalculateCrc32 (
   IN  UINT8                             *Data,
@@ -295,17 +514,22 @@ Returns:
 --*/
 {
   UINT32  Crc;
-  UINTN   Index;
-  UINT8   *Ptr;
 
   if ((DataSize == 0) || (Data == NULL) || (CrcOut == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
   Crc = 0xffffffff;
-  for (Index = 0, Ptr = Data; Index < DataSize; Index++, Ptr++) {
-    Crc = (Crc >> 8) ^ mCrcTable[(UINT8) Crc ^ *Ptr];
+
+#ifdef CRC32_PCLMUL_SUPPORT
+  if (DataSize >= 64 && __builtin_cpu_supports ("pclmul") && __builtin_cpu_supports ("sse4.1")) {
+    Crc       = Crc32Pclmul (Crc, Data, DataSize & ~(UINTN) 0xF);
+    Data     += DataSize & ~(UINTN) 0xF;
+    DataSize &= 0xF;
   }
+#endif
+
+  Crc = Crc32Generic (Crc, Data, DataSize);
 
   *CrcOut = Crc ^ 0xffffffff;
 
@@ -16,6 +16,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #include "Sdk/C/Alloc.h"
 #include "Sdk/C/7zFile.h"
 #include "Sdk/C/7zVersion.h"
@@ -26,6 +33,17 @@
 
 #define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
 
+//
+// Chunked format: a header of four little endian UInt32 values (signature,
+// chunk size, chunk count, decoded size), a table holding the compressed size
+// of every chunk, and the chunks. Every chunk is a standard LZMA stream that
+// can be decoded independently of the others.
+//
+#define LZMA_CHUNKED_SIGNATURE      0x4B435A4C    // 'L', 'Z', 'C', 'K'
+#define LZMA_CHUNKED_HEADER_SIZE    16
+#define LZMA_CHUNK_SIZE_DEFAULT     (1 << 20)
+#define LZMA_MAX_THREADS            64
+
 typedef enum {
   NoConverter,
   X86Converter,
@@ -39,10 +57,13 @@ const char *kDataErrorMessage = "Data error";
 
 static Bool mQuietMode = False;
 static CONVERTER_TYPE mConType = NoConverter;
+static Bool mChunked = False;
+static UInt32 mChunkSize = LZMA_CHUNK_SIZE_DEFAULT;
+static unsigned mNumThreads = 0;
 
 #define UTILITY_NAME "LzmaCompress"
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 2
+#define UTILITY_MINOR_VERSION 3
 #define INTEL_COPYRIGHT \
   "Copyright (c) 2009-2018, Intel Corporation. All rights reserved."
 void PrintHelp(char *buffer)
@@ -55,6 +76,12 @@ void PrintHelp(char *buffer)
              "  -d: decode file\n"
              "  -o FileName, --output FileName: specify the output filename\n"
              "  --f86: enable converter for x86 code\n"
+             "  --chunked: use the chunked format, whose chunks are encoded\n"
+             "             and decoded in parallel\n"
+             "  --chunk-size Size: set the chunk size in KB, implies --chunked\n"
+             "                     (default 1024)\n"
+             "  --threads Number: set the number of worker threads\n"
+             "                    (default: number of processors)\n"
              "  -v, --verbose: increase output messages\n"
              "  -q, --quiet: reduce output messages\n"
              "  --debug [0-9]: set debug level\n"
@@ -235,6 +262,365 @@ Done:
   return res;
 }
 
+typedef struct {
+  const Byte *inData;
+  size_t inSize;
+  Byte *outData;
+  size_t outSize;
+  SRes res;
+} CHUNK_JOB;
+
+typedef struct {
+  CHUNK_JOB *jobs;
+  UInt32 numJobs;
+  UInt32 nextJob;
+  Bool encode;
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+#else
+  pthread_mutex_t lock;
+#endif
+} CHUNK_QUEUE;
+
+static unsigned GetNumberOfProcessors(void)
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (unsigned)info.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (unsigned)n : 1;
+#endif
+}
+
+static SRes EncodeChunk(CHUNK_JOB *job)
+{
+  CLzmaEncProps props;
+  size_t outSizeProcessed;
+  size_t outPropsSize = LZMA_PROPS_SIZE;
+  SRes res;
+  int i;
+
+  LzmaEncProps_Init(&props);
+  LzmaEncProps_Normalize(&props);
+
+  // we allocate 105% of original size + 64KB for output buffer
+  job->outSize = job->inSize / 20 * 21 + (1 << 16);
+  job->outData = (Byte *)MyAlloc(job->outSize);
+  if (job->outData == 0)
+    return SZ_ERROR_MEM;
+
+  for (i = 0; i < 8; i++)
+    job->outData[i + LZMA_PROPS_SIZE] = (Byte)((UInt64)job->inSize >> (8 * i));
+
+  outSizeProcessed = job->outSize - LZMA_HEADER_SIZE;
+  res = LzmaEncode(job->outData + LZMA_HEADER_SIZE, &outSizeProcessed,
+      job->inData, job->inSize, &props, job->outData, &outPropsSize, 0,
+      NULL, &g_Alloc, &g_Alloc);
+  job->outSize = LZMA_HEADER_SIZE + outSizeProcessed;
+  return res;
+}
+
+static SRes DecodeChunk(CHUNK_JOB *job)
+{
+  UInt64 outSize64 = 0;
+  size_t outSize;
+  size_t inSizePure;
+  ELzmaStatus status;
+  SRes res;
+  int i;
+
+  if (job->inSize < LZMA_HEADER_SIZE)
+    return SZ_ERROR_INPUT_EOF;
+
+  for (i = 0; i < 8; i++)
+    outSize64 += ((UInt64)job->inData[LZMA_PROPS_SIZE + i]) << (i * 8);
+
+  //
+  // A chunk must fill exactly its share of the output buffer.
+  //
+  if (outSize64 != job->outSize)
+    return SZ_ERROR_DATA;
+
+  outSize = job->outSize;
+  inSizePure = job->inSize - LZMA_HEADER_SIZE;
+  res = LzmaDecode(job->outData, &outSize, job->inData + LZMA_HEADER_SIZE, &inSizePure,
+      job->inData, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc);
+  if (res == SZ_OK && outSize != job->outSize)
+    res = SZ_ERROR_DATA;
+  return res;
+}
+
+static void RunChunkJobs(CHUNK_QUEUE *queue)
+{
+  UInt32 index;
+
+  for (;;) {
+#ifdef _WIN32
+    EnterCriticalSection(&queue->lock);
+#else
+    pthread_mutex_lock(&queue->lock);
+#endif
+    index = queue->nextJob;
+    if (index < queue->numJobs)
+      queue->nextJob++;
+#ifdef _WIN32
+    LeaveCriticalSection(&queue->lock);
+#else
+    pthread_mutex_unlock(&queue->lock);
+#endif
+    if (index >= queue->numJobs)
+      break;
+
+    queue->jobs[index].res = queue->encode ?
+        EncodeChunk(&queue->jobs[index]) : DecodeChunk(&queue->jobs[index]);
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI ChunkThread(LPVOID context)
+{
+  RunChunkJobs((CHUNK_QUEUE *)context);
+  return 0;
+}
+#else
+static void *ChunkThread(void *context)
+{
+  RunChunkJobs((CHUNK_QUEUE *)context);
+  return NULL;
+}
+#endif
+
+//
+// Process every job of the queue, on up to mNumThreads threads. The calling
+// thread always takes part, so the jobs still complete when no thread can be
+// created.
+//
+static SRes RunChunkQueue(CHUNK_QUEUE *queue)
+{
+#ifdef _WIN32
+  HANDLE threads[LZMA_MAX_THREADS];
+#else
+  pthread_t threads[LZMA_MAX_THREADS];
+#endif
+  unsigned numThreads;
+  unsigned created;
+  UInt32 i;
+
+  numThreads = mNumThreads != 0 ? mNumThreads : GetNumberOfProcessors();
+  if (numThreads > LZMA_MAX_THREADS)
+    numThreads = LZMA_MAX_THREADS;
+  if (numThreads > queue->numJobs)
+    numThreads = queue->numJobs;
+
+  queue->nextJob = 0;
+#ifdef _WIN32
+  InitializeCriticalSection(&queue->lock);
+#else
+  pthread_mutex_init(&queue->lock, NULL);
+#endif
+
+  for (created = 0; created + 1 < numThreads; created++) {
+#ifdef _WIN32
+    threads[created] = CreateThread(NULL, 0, ChunkThread, queue, 0, NULL);
+    if (threads[created] == NULL)
+      break;
+#else
+    if (pthread_create(&threads[created], NULL, ChunkThread, queue) != 0)
+      break;
+#endif
+  }
+
+  RunChunkJobs(queue);
+
+  while (created > 0) {
+    created--;
+#ifdef _WIN32
+    WaitForSingleObject(threads[created], INFINITE);
+    CloseHandle(threads[created]);
+#else
+    pthread_join(threads[created], NULL);
+#endif
+  }
+
+#ifdef _WIN32
+  DeleteCriticalSection(&queue->lock);
+#else
+  pthread_mutex_destroy(&queue->lock);
+#endif
+
+  for (i = 0; i < queue->numJobs; i++) {
+    if (queue->jobs[i].res != SZ_OK)
+      return queue->jobs[i].res;
+  }
+  return SZ_OK;
+}
+
+static void SetUi32(Byte *p, UInt32 v)
+{
+  p[0] = (Byte)v;
+  p[1] = (Byte)(v >> 8);
+  p[2] = (Byte)(v >> 16);
+  p[3] = (Byte)(v >> 24);
+}
+
+static UInt32 GetUi32(const Byte *p)
+{
+  return (UInt32)p[0] | ((UInt32)p[1] << 8) | ((UInt32)p[2] << 16) | ((UInt32)p[3] << 24);
+}
+
+static SRes EncodeChunked(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  Byte *inBuffer = 0;
+  Byte *header = 0;
+  size_t headerSize;
+  CHUNK_QUEUE queue;
+  UInt32 i;
+
+  memset(&queue, 0, sizeof(queue));
+
+  if (inSize == 0)
+    return SZ_ERROR_INPUT_EOF;
+  if (fileSize > 0xFFFFFFFF)
+    return SZ_ERROR_PARAM;
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  if (inBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  queue.encode = True;
+  queue.numJobs = (UInt32)((inSize - 1) / mChunkSize + 1);
+  queue.jobs = (CHUNK_JOB *)calloc(queue.numJobs, sizeof(CHUNK_JOB));
+  headerSize = LZMA_CHUNKED_HEADER_SIZE + (size_t)queue.numJobs * 4;
+  header = (Byte *)MyAlloc(headerSize);
+  if (queue.jobs == 0 || header == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  for (i = 0; i < queue.numJobs; i++) {
+    queue.jobs[i].inData = inBuffer + (size_t)i * mChunkSize;
+    queue.jobs[i].inSize = inSize - (size_t)i * mChunkSize;
+    if (queue.jobs[i].inSize > mChunkSize)
+      queue.jobs[i].inSize = mChunkSize;
+  }
+
+  res = RunChunkQueue(&queue);
+  if (res != SZ_OK)
+    goto Done;
+
+  SetUi32(header, LZMA_CHUNKED_SIGNATURE);
+  SetUi32(header + 4, mChunkSize);
+  SetUi32(header + 8, queue.numJobs);
+  SetUi32(header + 12, (UInt32)inSize);
+  for (i = 0; i < queue.numJobs; i++)
+    SetUi32(header + LZMA_CHUNKED_HEADER_SIZE + i * 4, (UInt32)queue.jobs[i].outSize);
+
+  if (outStream->Write(outStream, header, headerSize) != headerSize) {
+    res = SZ_ERROR_WRITE;
+    goto Done;
+  }
+  for (i = 0; i < queue.numJobs; i++) {
+    if (outStream->Write(outStream, queue.jobs[i].outData, queue.jobs[i].outSize) != queue.jobs[i].outSize) {
+      res = SZ_ERROR_WRITE;
+      goto Done;
+    }
+  }
+
+Done:
+  if (queue.jobs != 0) {
+    for (i = 0; i < queue.numJobs; i++)
+      MyFree(queue.jobs[i].outData);
+    free(queue.jobs);
+  }
+  MyFree(header);
+  MyFree(inBuffer);
+
+  return res;
+}
+
+static SRes DecodeChunked(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  Byte *inBuffer = 0;
+  Byte *outBuffer = 0;
+  size_t outSize;
+  size_t offset;
+  UInt32 chunkSize;
+  CHUNK_QUEUE queue;
+  UInt32 i;
+
+  memset(&queue, 0, sizeof(queue));
+
+  if (inSize < LZMA_CHUNKED_HEADER_SIZE)
+    return SZ_ERROR_INPUT_EOF;
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  if (inBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  chunkSize = GetUi32(inBuffer + 4);
+  queue.numJobs = GetUi32(inBuffer + 8);
+  outSize = GetUi32(inBuffer + 12);
+  if (GetUi32(inBuffer) != LZMA_CHUNKED_SIGNATURE || chunkSize == 0 || outSize == 0 ||
+      queue.numJobs > (inSize - LZMA_CHUNKED_HEADER_SIZE) / 4 ||
+      queue.numJobs != (outSize - 1) / chunkSize + 1) {
+    res = SZ_ERROR_DATA;
+    goto Done;
+  }
+
+  queue.encode = False;
+  queue.jobs = (CHUNK_JOB *)calloc(queue.numJobs, sizeof(CHUNK_JOB));
+  outBuffer = (Byte *)MyAlloc(outSize);
+  if (queue.jobs == 0 || outBuffer == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  offset = LZMA_CHUNKED_HEADER_SIZE + (size_t)queue.numJobs * 4;
+  for (i = 0; i < queue.numJobs; i++) {
+    queue.jobs[i].inData = inBuffer + offset;
+    queue.jobs[i].inSize = GetUi32(inBuffer + LZMA_CHUNKED_HEADER_SIZE + i * 4);
+    if (queue.jobs[i].inSize > inSize - offset) {
+      res = SZ_ERROR_DATA;
+      goto Done;
+    }
+    offset += queue.jobs[i].inSize;
+    queue.jobs[i].outData = outBuffer + (size_t)i * chunkSize;
+    queue.jobs[i].outSize = outSize - (size_t)i * chunkSize;
+    if (queue.jobs[i].outSize > chunkSize)
+      queue.jobs[i].outSize = chunkSize;
+  }
+
+  res = RunChunkQueue(&queue);
+  if (res != SZ_OK)
+    goto Done;
+
+  if (outStream->Write(outStream, outBuffer, outSize) != outSize)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  free(queue.jobs);
+  MyFree(outBuffer);
+  MyFree(inBuffer);
+
+  return res;
+}
+
 int main2(int numArgs, const char *args[], char *rs)
 {
   CFileSeqInStream inStream;
@@ -265,6 +651,23 @@ int main2(int numArgs, const char *args[], char *rs)
       modeWasSet = True;
     } else if (strcmp(args[param], "--f86") == 0) {
       mConType = X86Converter;
+    } else if (strcmp(args[param], "--chunked") == 0) {
+      mChunked = True;
+    } else if (strcmp(args[param], "--chunk-size") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      mChunkSize = (UInt32)strtoul(args[++param], NULL, 0);
+      if (mChunkSize == 0 || mChunkSize > (1 << 20)) {
+        return PrintError(rs, "Chunk size must be between 1 and 1048576 KB");
+      }
+      mChunkSize <<= 10;
+      mChunked = True;
+    } else if (strcmp(args[param], "--threads") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      mNumThreads = (unsigned)strtoul(args[++param], NULL, 0);
     } else if (strcmp(args[param], "-o") == 0 ||
                strcmp(args[param], "--output") == 0) {
       if (numArgs < (param + 2)) {
@@ -313,6 +716,10 @@ int main2(int numArgs, const char *args[], char *rs)
     return PrintUserError(rs);
   }
 
+  if (mChunked && mConType != NoConverter) {
+    return PrintError(rs, "The x86 converter can not be used with the chunked format");
+  }
+
   {
     size_t t4 = sizeof(UInt32);
     size_t t8 = sizeof(UInt64);
@@ -335,14 +742,22 @@ int main2(int numArgs, const char *args[], char *rs)
     if (!mQuietMode) {
       printf("Encoding\n");
     }
-    res = Encode(&outStream.vt, &inStream.vt, fileSize);
+    if (mChunked) {
+      res = EncodeChunked(&outStream.vt, &inStream.vt, fileSize);
+    } else {
+      res = Encode(&outStream.vt, &inStream.vt, fileSize);
+    }
   }
   else
   {
     if (!mQuietMode) {
       printf("Decoding\n");
     }
-    res = Decode(&outStream.vt, &inStream.vt, fileSize);
+    if (mChunked) {
+      res = DecodeChunked(&outStream.vt, &inStream.vt, fileSize);
+    } else {
+      res = Decode(&outStream.vt, &inStream.vt, fileSize);
+    }
   }
 
   File_Close(&outStream.file);
@@ -22,6 +22,7 @@
 #include <Protocol/SmmAccess2.h>
 
 #include <Guid/MemoryProfile.h>
+#include <Guid/MemoryAllocationTrace.h>
 #include <Guid/PiSmmCommunicationRegionTable.h>
 
 CHAR8 *mActionString[] = {
@@ -32,6 +33,16 @@ CHAR8 *mActionString[] = {
   "gBS->FreePool",
 };
 
+CHAR8 *mTraceActionString[] = {
+  "Unknown",
+  "AllocatePages",
+  "FreePages",
+  "AllocatePool",
+  "FreePool",
+  "ImageStart",
+  "ImageUnload",
+};
+
 CHAR8 *mSmmActionString[] = {
   "SmmUnknown",
   "gSmst->SmmAllocatePages",
@@ -1327,6 +1338,91 @@ Done:
   return Status;
 }
 
+/**
+  Dump the memory allocation trace ring published by the DXE core, oldest
+  event first, in the format decoded by MemoryAllocationTraceAnalyzer.py.
+
+  @retval EFI_SUCCESS           Get the memory allocation trace successfully.
+  @retval EFI_UNSUPPORTED       The memory allocation trace is not enabled.
+  @retval EFI_OUT_OF_RESOURCES  No enough resource to snapshot the trace.
+
+**/
+EFI_STATUS
+GetMemoryAllocationTraceData (
+  VOID
+  )
+{
+  EFI_STATUS                      Status;
+  MEMORY_ALLOCATION_TRACE_HEADER  *Trace;
+  MEMORY_ALLOCATION_TRACE_HEADER  *Snapshot;
+  MEMORY_ALLOCATION_TRACE_ENTRY   *Entries;
+  MEMORY_ALLOCATION_TRACE_ENTRY   *Entry;
+  UINT64                          NextSequence;
+  UINT64                          Sequence;
+  UINT64                          Lost;
+
+  Status = EfiGetSystemConfigurationTable (&gEdkiiMemoryAllocationTraceGuid, (VOID **) &Trace);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Trace->Signature != MEMORY_ALLOCATION_TRACE_SIGNATURE ||
+      Trace->EntrySize != sizeof (MEMORY_ALLOCATION_TRACE_ENTRY)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // The DXE core keeps recording while the ring is copied, including the
+  // allocations made by this application. Events written after NextSequence
+  // was read are dropped below by their sequence number.
+  //
+  NextSequence = Trace->NextSequence;
+  Snapshot     = AllocateCopyPool (Trace->Length, Trace);
+  if (Snapshot == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Entries = (MEMORY_ALLOCATION_TRACE_ENTRY *) (Snapshot + 1);
+
+  Sequence = 1;
+  if (NextSequence > Snapshot->EntryCount) {
+    Sequence = NextSequence - Snapshot->EntryCount;
+  }
+
+  Print (L"======= MemoryAllocationTrace begin =======\n");
+  Print (L"EntryCount     - 0x%08x\n", Snapshot->EntryCount);
+  Print (L"NextSequence   - 0x%016lx\n", NextSequence);
+  Print (L"TimerFrequency - 0x%016lx\n", Snapshot->TimerFrequency);
+  Print (L"TimerStart     - 0x%016lx\n", Snapshot->TimerStart);
+  Print (L"TimerEnd       - 0x%016lx\n", Snapshot->TimerEnd);
+
+  Lost = 0;
+  for (; Sequence < NextSequence; Sequence++) {
+    Entry = &Entries[(UINTN) (Sequence - 1) & (Snapshot->EntryCount - 1)];
+    if (Entry->Sequence != Sequence || Entry->Action >= ARRAY_SIZE (mTraceActionString)) {
+      Lost++;
+      continue;
+    }
+    Print (
+      L"0x%016lx %a Tpl 0x%02x Type 0x%08x Time 0x%016lx Buffer 0x%016lx Size 0x%016lx Caller 0x%016lx File %g\n",
+      Entry->Sequence,
+      mTraceActionString[Entry->Action],
+      Entry->Tpl,
+      Entry->MemoryType,
+      Entry->TimeStamp,
+      Entry->Buffer,
+      Entry->Size,
+      Entry->CallerAddress,
+      &Entry->FileName
+      );
+  }
+
+  Print (L"Lost           - 0x%016lx\n", Lost);
+  Print (L"======= MemoryAllocationTrace end =======\n\n\n");
+
+  FreePool (Snapshot);
+  return EFI_SUCCESS;
+}
+
 /**
   The user Entry Point for Application. The user code starts with this function
   as the real entry point for the image goes into a library that calls this function.
@@ -1357,5 +1453,10 @@ UefiMain (
     DEBUG ((EFI_D_ERROR, "GetSmramProfileData - %r\n", Status));
   }
 
+  Status = GetMemoryAllocationTraceData ();
+  if (EFI_ERROR (Status)) {
+    DEBUG ((EFI_D_ERROR, "GetMemoryAllocationTraceData - %r\n", Status));
+  }
+
   return EFI_SUCCESS;
 }
@@ -148,6 +148,79 @@ PopBool (
 
 
 
+/**
+  Collect the protocol GUIDs that a dependency expression pushes into
+  DriverEntry->DepexWaiters, so that the Depex is only evaluated again after
+  one of them has been installed.
+
+  If the Depex contains a NOT, it may become TRUE when a protocol is
+  uninstalled, so DriverEntry->DepexAlwaysEvaluate is set instead.
+
+  @param  DriverEntry           DriverEntry element to update.
+
+**/
+VOID
+CoreCollectDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  UINT8                  *Iterator;
+  UINT8                  *End;
+  UINTN                  Count;
+  UINTN                  Index;
+  EFI_CORE_DEPEX_WAITER  *Waiter;
+
+  DriverEntry->DepexNeedsEvaluation = TRUE;
+
+  //
+  // Count the GUIDs the Depex pushes. Stop at the first malformed opcode, as
+  // the evaluator returns FALSE there whatever protocols are installed.
+  //
+  Count = 0;
+  End   = (UINT8 *) DriverEntry->Depex + DriverEntry->DepexSize;
+  for (Iterator = DriverEntry->Depex; Iterator < End && *Iterator != EFI_DEP_END; Iterator++) {
+    if (*Iterator == EFI_DEP_PUSH) {
+      if (Iterator + sizeof (EFI_GUID) >= End) {
+        break;
+      }
+      Count++;
+      Iterator += sizeof (EFI_GUID);
+    } else if (*Iterator == EFI_DEP_NOT) {
+      DriverEntry->DepexAlwaysEvaluate = TRUE;
+      return;
+    } else if (*Iterator == EFI_DEP_BEFORE || *Iterator == EFI_DEP_AFTER || *Iterator > EFI_DEP_SOR) {
+      break;
+    }
+  }
+
+  if (Count == 0) {
+    return;
+  }
+
+  Waiter = AllocatePool (Count * sizeof (EFI_CORE_DEPEX_WAITER));
+  if (Waiter == NULL) {
+    DriverEntry->DepexAlwaysEvaluate = TRUE;
+    return;
+  }
+
+  Index = 0;
+  for (Iterator = DriverEntry->Depex; Index < Count; Iterator++) {
+    if (*Iterator == EFI_DEP_PUSH) {
+      Waiter[Index].Signature   = EFI_CORE_DEPEX_WAITER_SIGNATURE;
+      Waiter[Index].DriverEntry = DriverEntry;
+      CopyMem (&Waiter[Index].ProtocolGuid, Iterator + 1, sizeof (EFI_GUID));
+      Index++;
+      Iterator += sizeof (EFI_GUID);
+    }
+  }
+
+  DriverEntry->DepexWaiters     = Waiter;
+  DriverEntry->DepexWaiterCount = Count;
+  CoreInsertDepexWaiters (DriverEntry);
+}
+
+
+
 /**
   Preprocess dependency expression and update DriverEntry to reflect the
   state of  Before, After, and SOR dependencies. If DriverEntry->Before
@@ -182,6 +255,8 @@ CorePreProcessDepex (
 
   if (DriverEntry->Before || DriverEntry->After) {
     CopyMem (&DriverEntry->BeforeAfterGuid, Iterator + 1, sizeof (EFI_GUID));
+  } else {
+    CoreCollectDepexWaiters (DriverEntry);
   }
 
   return EFI_SUCCESS;
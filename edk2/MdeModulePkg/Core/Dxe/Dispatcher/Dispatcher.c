@@ -19,6 +19,10 @@
             all Befores. It then addes the item that was passed in and then
             processess the After dependecies by recursively calling the routine.
 
+  The protocols pushed by each Depex are kept in the mDepexWaiterHash reverse
+  index. A Depex that evaluated to FALSE is only evaluated again once one of
+  its protocols has been installed.
+
   Dispatcher Rules:
   The rules for the dispatcher are in chapter 10 of the DXE CIS. Figure 10-3
   is the state diagram for the DXE dispatcher
@@ -51,7 +55,23 @@ LIST_ENTRY  mScheduledQueue = INITIALIZE_LIST_HEAD_VARIABLE (mScheduledQueue);
 LIST_ENTRY  mFvHandleList = INITIALIZE_LIST_HEAD_VARIABLE (mFvHandleList);           // list of KNOWN_HANDLE
 
 //
-// Lock for mDiscoveredList, mScheduledQueue, gDispatcherRunning.
+// Reverse index from protocol GUID to the Dependent drivers whose Depex is
+// waiting for it. List of EFI_CORE_DEPEX_WAITER.
+//
+#define DEPEX_WAITER_HASH_BUCKET_COUNT  64
+
+LIST_ENTRY  mDepexWaiterHash[DEPEX_WAITER_HASH_BUCKET_COUNT];
+BOOLEAN     mDepexWaiterHashInitialized = FALSE;
+
+//
+// Number of Depex evaluations done, and skipped because none of the
+// protocols of the Depex had been installed since it was last evaluated
+//
+UINT64      mDepexEvaluations = 0;
+UINT64      mDepexEvaluationsSaved = 0;
+
+//
+// Lock for mDiscoveredList, mScheduledQueue, gDispatcherRunning, mDepexWaiterHash.
 //
 EFI_LOCK  mDispatcherLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 
@@ -222,6 +242,120 @@ CoreReleaseDispatcherLock (
 }
 
 
+/**
+  Return the mDepexWaiterHash bucket that a protocol GUID belongs to.
+
+  @param  Protocol              The protocol GUID.
+
+  @return The bucket list head for Protocol
+
+**/
+LIST_ENTRY *
+CoreGetDepexWaiterBucket (
+  IN  EFI_GUID                *Protocol
+  )
+{
+  UINT32  Value;
+
+  Value = ReadUnaligned32 ((UINT32 *) Protocol) ^
+          ReadUnaligned32 ((UINT32 *) Protocol + 1) ^
+          ReadUnaligned32 ((UINT32 *) Protocol + 2) ^
+          ReadUnaligned32 ((UINT32 *) Protocol + 3);
+  Value = Value ^ (Value >> 16);
+  Value = Value ^ (Value >> 8);
+  return &mDepexWaiterHash[Value & (DEPEX_WAITER_HASH_BUCKET_COUNT - 1)];
+}
+
+
+/**
+  Add the protocols a driver's Depex is waiting for to the reverse index that
+  CoreWakeDepexWaiters() uses to wake the driver up.
+
+  @param  DriverEntry           The driver whose DepexWaiters are to be added.
+
+**/
+VOID
+CoreInsertDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  UINTN                 Index;
+  EFI_CORE_DEPEX_WAITER *Waiter;
+
+  ASSERT (mDepexWaiterHashInitialized);
+
+  CoreAcquireDispatcherLock ();
+
+  for (Index = 0; Index < DriverEntry->DepexWaiterCount; Index++) {
+    Waiter = &DriverEntry->DepexWaiters[Index];
+    InsertTailList (CoreGetDepexWaiterBucket (&Waiter->ProtocolGuid), &Waiter->Link);
+  }
+
+  CoreReleaseDispatcherLock ();
+}
+
+
+/**
+  Remove the protocols a driver's Depex is waiting for from the reverse index
+  once the driver has left the Dependent state. The dispatcher lock must be held.
+
+  @param  DriverEntry           The driver whose DepexWaiters are to be removed.
+
+**/
+VOID
+CoreRemoveDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  UINTN                 Index;
+
+  ASSERT_LOCKED (&mDispatcherLock);
+
+  for (Index = 0; Index < DriverEntry->DepexWaiterCount; Index++) {
+    RemoveEntryList (&DriverEntry->DepexWaiters[Index].Link);
+  }
+
+  DriverEntry->DepexWaiterCount = 0;
+}
+
+
+/**
+  Mark every Dependent driver whose Depex pushes Protocol for evaluation
+  by the next pass of the dispatcher.
+
+  @param  Protocol              The protocol that has been installed.
+
+**/
+VOID
+CoreWakeDepexWaiters (
+  IN  EFI_GUID                *Protocol
+  )
+{
+  LIST_ENTRY            *Link;
+  LIST_ENTRY            *Bucket;
+  EFI_CORE_DEPEX_WAITER *Waiter;
+
+  //
+  // No driver has been discovered before the dispatcher is initialized
+  //
+  if (!mDepexWaiterHashInitialized) {
+    return;
+  }
+
+  CoreAcquireDispatcherLock ();
+
+  Bucket = CoreGetDepexWaiterBucket (Protocol);
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Waiter = CR (Link, EFI_CORE_DEPEX_WAITER, Link, EFI_CORE_DEPEX_WAITER_SIGNATURE);
+    if (CompareGuid (&Waiter->ProtocolGuid, Protocol)) {
+      Waiter->DriverEntry->DepexNeedsEvaluation = TRUE;
+    }
+  }
+
+  CoreReleaseDispatcherLock ();
+}
+
+
 /**
   Read Depex and pre-process the Depex for Before and After. If Section Extraction
   protocol returns an error via ReadSection defer the reading of the Depex.
@@ -273,6 +407,11 @@ CoreGetDepexSectionAndPreProccess (
       DriverEntry->Depex = NULL;
       DriverEntry->Dependent = TRUE;
       DriverEntry->DepexProtocolError = FALSE;
+
+      //
+      // Depends on the architectural protocols rather than a protocol list
+      //
+      DriverEntry->DepexAlwaysEvaluate = TRUE;
     }
   } else {
     //
@@ -557,6 +696,26 @@ CoreDispatcher (
       }
 
       if (DriverEntry->Dependent) {
+        if (DriverEntry->Before || DriverEntry->After) {
+          //
+          // Scheduled by CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter ()
+          //
+          continue;
+        }
+
+        if (!DriverEntry->DepexNeedsEvaluation && !DriverEntry->DepexAlwaysEvaluate) {
+          //
+          // No protocol in the Depex has been installed since it evaluated to FALSE
+          //
+          mDepexEvaluationsSaved++;
+          continue;
+        }
+
+        CoreAcquireDispatcherLock ();
+        DriverEntry->DepexNeedsEvaluation = FALSE;
+        CoreReleaseDispatcherLock ();
+
+        mDepexEvaluations++;
         if (CoreIsSchedulable (DriverEntry)) {
           CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
           ReadyToRun = TRUE;
@@ -571,6 +730,13 @@ CoreDispatcher (
     }
   } while (ReadyToRun);
 
+  DEBUG ((
+    DEBUG_DISPATCH,
+    "Depex evaluations: %ld, saved: %ld\n",
+    mDepexEvaluations,
+    mDepexEvaluationsSaved
+    ));
+
   //
   // Close DXE dispatch Event
   //
@@ -631,6 +797,7 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
   InsertedDriverEntry->Dependent = FALSE;
   InsertedDriverEntry->Scheduled = TRUE;
   InsertTailList (&mScheduledQueue, &InsertedDriverEntry->ScheduledLink);
+  CoreRemoveDepexWaiters (InsertedDriverEntry);
 
   CoreReleaseDispatcherLock ();
 
@@ -1449,8 +1616,15 @@ CoreInitializeDispatcher (
   VOID
   )
 {
+  UINTN  Index;
+
   PERF_FUNCTION_BEGIN ();
 
+  for (Index = 0; Index < DEPEX_WAITER_HASH_BUCKET_COUNT; Index++) {
+    InitializeListHead (&mDepexWaiterHash[Index]);
+  }
+  mDepexWaiterHashInitialized = TRUE;
+
   mFwVolEvent = EfiCreateProtocolNotifyEvent (
                   &gEfiFirmwareVolume2ProtocolGuid,
                   TPL_CALLBACK,
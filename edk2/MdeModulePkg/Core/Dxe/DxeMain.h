@@ -47,6 +47,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
 #include <Protocol/PeCoffImageEmulator.h>
+#include <Protocol/MpService.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -64,6 +65,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/VectorHandoffTable.h>
 #include <Ppi/VectorHandoffInfo.h>
 #include <Guid/MemoryProfile.h>
+#include <Guid/MemoryAllocationTrace.h>
 
 #include <Library/DxeCoreEntryPoint.h>
 #include <Library/DebugLib.h>
@@ -71,6 +73,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseLib.h>
 #include <Library/HobLib.h>
 #include <Library/PerformanceLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiDecompressLib.h>
 #include <Library/ExtractGuidedSectionLib.h>
 #include <Library/CacheMaintenanceLib.h>
@@ -86,6 +89,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DxeServicesLib.h>
 #include <Library/DebugAgentLib.h>
 #include <Library/CpuExceptionHandlerLib.h>
+#include <Library/SynchronizationLib.h>
 
 
 //
@@ -137,6 +141,8 @@ typedef struct {
 } KNOWN_HANDLE;
 
 
+typedef struct _EFI_CORE_DEPEX_WAITER  EFI_CORE_DEPEX_WAITER;
+
 #define EFI_CORE_DRIVER_ENTRY_SIGNATURE SIGNATURE_32('d','r','v','r')
 typedef struct {
   UINTN                           Signature;
@@ -166,8 +172,28 @@ typedef struct {
   EFI_HANDLE                      ImageHandle;
   BOOLEAN                         IsFvImage;
 
+  //
+  // A Dependent driver's Depex is only evaluated again after one of the
+  // protocols it pushes has been installed, unless DepexAlwaysEvaluate is set
+  //
+  BOOLEAN                         DepexNeedsEvaluation;
+  BOOLEAN                         DepexAlwaysEvaluate;
+  UINTN                           DepexWaiterCount;
+  EFI_CORE_DEPEX_WAITER           *DepexWaiters;    // mDepexWaiterHash
+
 } EFI_CORE_DRIVER_ENTRY;
 
+//
+// A protocol that a Dependent driver's Depex is waiting for
+//
+#define EFI_CORE_DEPEX_WAITER_SIGNATURE SIGNATURE_32('d','w','t','r')
+struct _EFI_CORE_DEPEX_WAITER {
+  UINTN                           Signature;
+  LIST_ENTRY                      Link;             // mDepexWaiterHash
+  EFI_GUID                        ProtocolGuid;
+  EFI_CORE_DRIVER_ENTRY           *DriverEntry;
+};
+
 //
 //The data structure of GCD memory map entry
 //
@@ -305,6 +331,37 @@ CoreInitializePool (
   );
 
 
+/**
+  Dump the hit rate and fragmentation of each slab class when the slab
+  allocator is enabled.
+
+**/
+VOID
+CoreDumpPoolSlabStatistics (
+  VOID
+  );
+
+
+/**
+  Dump the event service statistics when PcdEventStatisticsEnable is TRUE.
+
+**/
+VOID
+CoreDumpEventStatistics (
+  VOID
+  );
+
+
+/**
+  Dump the section stream cache statistics.
+
+**/
+VOID
+CoreDumpSectionCacheStatistics (
+  VOID
+  );
+
+
 /**
   Called to initialize the memory map and add descriptors to
   the current descriptor list.
@@ -520,6 +577,32 @@ CorePreProcessDepex (
   );
 
 
+/**
+  Add the protocols a driver's Depex is waiting for to the reverse index that
+  CoreWakeDepexWaiters() uses to wake the driver up.
+
+  @param  DriverEntry           The driver whose DepexWaiters are to be added.
+
+**/
+VOID
+CoreInsertDepexWaiters (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  );
+
+
+/**
+  Mark every Dependent driver whose Depex pushes Protocol for evaluation
+  by the next pass of the dispatcher.
+
+  @param  Protocol              The protocol that has been installed.
+
+**/
+VOID
+CoreWakeDepexWaiters (
+  IN  EFI_GUID                *Protocol
+  );
+
+
 
 /**
   Terminates all boot services.
@@ -2799,6 +2882,67 @@ CoreUpdateProfile (
   IN CHAR8                  *ActionString OPTIONAL
   );
 
+/**
+  Get the GUID file name from the file path.
+
+  @param FilePath  File path.
+
+  @return The GUID file name from the file path.
+
+**/
+EFI_GUID *
+GetFileNameFromFilePath (
+  IN EFI_DEVICE_PATH_PROTOCOL   *FilePath
+  );
+
+/**
+  Allocate the memory allocation trace ring and publish it in the
+  EFI System Table.
+
+  The ring is only allocated if PcdMemoryAllocationTraceEntries is not 0.
+
+**/
+VOID
+CoreInitializeAllocationTrace (
+  VOID
+  );
+
+/**
+  Record a page or pool allocate/free in the memory allocation trace.
+
+  @param  CallerAddress  Address of caller who call Allocate or Free.
+  @param  Action         Allocate or Free action, MemoryAllocationTraceActionAllocatePages
+                         to MemoryAllocationTraceActionFreePool.
+  @param  MemoryType     Memory type.
+  @param  Size           Buffer size, in bytes for pool and in pages for pages.
+                         0 for FreePool.
+  @param  Buffer         Buffer address.
+
+**/
+VOID
+CoreRecordAllocationTrace (
+  IN EFI_PHYSICAL_ADDRESS            CallerAddress,
+  IN MEMORY_ALLOCATION_TRACE_ACTION  Action,
+  IN EFI_MEMORY_TYPE                 MemoryType,
+  IN UINTN                           Size,
+  IN VOID                            *Buffer
+  );
+
+/**
+  Record the start or unload of an image in the memory allocation trace, so
+  that the caller addresses of the allocations can be mapped to drivers.
+
+  @param  Image   The image being started or unloaded.
+  @param  Action  MemoryAllocationTraceActionImageStart or
+                  MemoryAllocationTraceActionImageUnload.
+
+**/
+VOID
+CoreRecordAllocationTraceImage (
+  IN LOADED_IMAGE_PRIVATE_DATA       *Image,
+  IN MEMORY_ALLOCATION_TRACE_ACTION  Action
+  );
+
 /**
   Internal function.  Converts a memory range to use new attributes.
 
@@ -331,6 +331,11 @@ DxeMain (
   Status = CoreInstallConfigurationTable (&gEfiMemoryTypeInformationGuid, &gMemoryTypeInformation);
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Start recording page and pool allocations if the allocation trace is enabled
+  //
+  CoreInitializeAllocationTrace ();
+
   //
   // If Loading modules At fixed address feature is enabled, install Load moduels at fixed address
   // Configuration Table so that user could easily to retrieve the top address to load Dxe and PEI
@@ -741,6 +746,12 @@ CoreExitBootServices (
 {
   EFI_STATUS                Status;
 
+  DEBUG_CODE (
+    CoreDumpPoolSlabStatistics ();
+    CoreDumpEventStatistics ();
+    CoreDumpSectionCacheStatistics ();
+  );
+
   //
   // Disable Timer
   //
@@ -32,9 +32,16 @@ LIST_ENTRY      gEventQueue[TPL_HIGH_LEVEL + 1];
 UINTN           gEventPending = 0;
 
 ///
-/// gEventSignalQueue - A list of events to signal based on EventGroup type
+/// gEventSignalQueue - Lists of events to signal based on EventGroup type,
+/// hashed by EventGroup
 ///
-LIST_ENTRY      gEventSignalQueue = INITIALIZE_LIST_HEAD_VARIABLE (gEventSignalQueue);
+LIST_ENTRY      gEventSignalQueue[EVENT_GROUP_HASH_BUCKET_COUNT];
+BOOLEAN         mEventSignalQueueInitialized = FALSE;
+
+///
+/// gEventStatistics - Event service statistics
+///
+EVENT_STATISTICS  gEventStatistics;
 
 ///
 /// Enumerate the valid types
@@ -115,6 +122,44 @@ CoreReleaseEventLock (
 
 
 
+/**
+  Return the signal queue that the events of an event group are kept in.
+
+  The event signal queues are initialized the first time they are used, as
+  the memory services signal the memory map change group before the event
+  services are initialized.
+
+  @param  EventGroup             The event group GUID
+
+  @return The signal queue list head for EventGroup
+
+**/
+LIST_ENTRY *
+CoreGetEventSignalQueue (
+  IN CONST EFI_GUID   *EventGroup
+  )
+{
+  UINTN   Index;
+  UINT32  Value;
+
+  if (!mEventSignalQueueInitialized) {
+    for (Index = 0; Index < EVENT_GROUP_HASH_BUCKET_COUNT; Index++) {
+      InitializeListHead (&gEventSignalQueue[Index]);
+    }
+    mEventSignalQueueInitialized = TRUE;
+  }
+
+  Value = ReadUnaligned32 ((CONST UINT32 *) EventGroup) ^
+          ReadUnaligned32 ((CONST UINT32 *) EventGroup + 1) ^
+          ReadUnaligned32 ((CONST UINT32 *) EventGroup + 2) ^
+          ReadUnaligned32 ((CONST UINT32 *) EventGroup + 3);
+  Value = Value ^ (Value >> 16);
+  Value = Value ^ (Value >> 8);
+  return &gEventSignalQueue[Value & (EVENT_GROUP_HASH_BUCKET_COUNT - 1)];
+}
+
+
+
 /**
   Initializes "event" support.
 
@@ -148,6 +193,45 @@ CoreInitializeEventServices (
 
 
 
+/**
+  Return the time elapsed between two performance counter values.
+
+  @param  StartTicks             The performance counter value at the start
+  @param  EndTicks               The performance counter value at the end
+
+  @return The elapsed time in nanoseconds
+
+**/
+UINT64
+CoreGetElapsedTime (
+  IN UINT64       StartTicks,
+  IN UINT64       EndTicks
+  )
+{
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+  UINT64  Delta;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart < CounterEnd) {
+    if (EndTicks >= StartTicks) {
+      Delta = EndTicks - StartTicks;
+    } else {
+      Delta = (CounterEnd - StartTicks) + (EndTicks - CounterStart);
+    }
+  } else {
+    if (StartTicks >= EndTicks) {
+      Delta = StartTicks - EndTicks;
+    } else {
+      Delta = (StartTicks - CounterEnd) + (CounterStart - EndTicks);
+    }
+  }
+
+  return GetTimeInNanoSecond (Delta);
+}
+
+
+
 /**
   Dispatches all pending events.
 
@@ -160,8 +244,13 @@ CoreDispatchEventNotifies (
   IN EFI_TPL      Priority
   )
 {
-  IEVENT          *Event;
-  LIST_ENTRY      *Head;
+  IEVENT            *Event;
+  LIST_ENTRY        *Head;
+  EFI_EVENT_NOTIFY  NotifyFunction;
+  UINT64            StartTicks;
+  UINT64            Elapsed;
+
+  StartTicks = 0;
 
   CoreAcquireEventLock ();
   ASSERT (gEventQueueLock.OwnerTpl == Priority);
@@ -191,12 +280,26 @@ CoreDispatchEventNotifies (
     // Notify this event
     //
     ASSERT (Event->NotifyFunction != NULL);
-    Event->NotifyFunction (Event, Event->NotifyContext);
+    NotifyFunction = Event->NotifyFunction;
+    if (FeaturePcdGet (PcdEventStatisticsEnable)) {
+      StartTicks = GetPerformanceCounter ();
+    }
+    NotifyFunction (Event, Event->NotifyContext);
 
     //
     // Check for next pending event
     //
     CoreAcquireEventLock ();
+
+    if (FeaturePcdGet (PcdEventStatisticsEnable)) {
+      Elapsed = CoreGetElapsedTime (StartTicks, GetPerformanceCounter ());
+      gEventStatistics.Notifies[Priority]++;
+      gEventStatistics.NotifyTime[Priority] += Elapsed;
+      if (Elapsed > gEventStatistics.MaxNotifyTime) {
+        gEventStatistics.MaxNotifyTime     = Elapsed;
+        gEventStatistics.MaxNotifyFunction = NotifyFunction;
+      }
+    }
   }
 
   gEventPending &= ~(UINTN)(1 << Priority);
@@ -243,30 +346,54 @@ CoreNotifyEvent (
 
 
 /**
-  Signals all events in the EventGroup.
+  Queues the notification functions of all events in the EventGroup.
+  The event database must be locked.
 
   @param  EventGroup             The list to signal
 
 **/
 VOID
-CoreNotifySignalList (
+CoreNotifySignalListLocked (
   IN EFI_GUID     *EventGroup
   )
 {
   LIST_ENTRY              *Link;
   LIST_ENTRY              *Head;
   IEVENT                  *Event;
+  UINT64                  Count;
 
-  CoreAcquireEventLock ();
+  ASSERT_LOCKED (&gEventQueueLock);
 
-  Head = &gEventSignalQueue;
+  Count = 0;
+  Head = CoreGetEventSignalQueue (EventGroup);
   for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
     Event = CR (Link, IEVENT, SignalLink, EVENT_SIGNATURE);
     if (CompareGuid (&Event->EventGroup, EventGroup)) {
       CoreNotifyEvent (Event);
+      Count++;
     }
   }
 
+  if (FeaturePcdGet (PcdEventStatisticsEnable)) {
+    gEventStatistics.GroupSignals++;
+    gEventStatistics.GroupEventsNotified += Count;
+  }
+}
+
+
+/**
+  Signals all events in the EventGroup.
+
+  @param  EventGroup             The list to signal
+
+**/
+VOID
+CoreNotifySignalList (
+  IN EFI_GUID     *EventGroup
+  )
+{
+  CoreAcquireEventLock ();
+  CoreNotifySignalListLocked (EventGroup);
   CoreReleaseEventLock ();
 }
 
@@ -495,7 +622,7 @@ CoreCreateEventInternal (
     //
     // The Event's NotifyFunction must be queued whenever the event is signaled
     //
-    InsertHeadList (&gEventSignalQueue, &IEvent->SignalLink);
+    InsertHeadList (CoreGetEventSignalQueue (&IEvent->EventGroup), &IEvent->SignalLink);
   }
 
   CoreReleaseEventLock ();
@@ -554,10 +681,8 @@ CoreSignalEvent (
         // The CreateEventEx() style requires all members of the Event Group
         //  to be signaled.
         //
-        CoreReleaseEventLock ();
-        CoreNotifySignalList (&Event->EventGroup);
-        CoreAcquireEventLock ();
-       } else {
+        CoreNotifySignalListLocked (&Event->EventGroup);
+      } else {
         CoreNotifyEvent (Event);
       }
     }
@@ -774,3 +899,50 @@ CoreCloseEvent (
   return Status;
 }
 
+
+/**
+  Dump the event service statistics when PcdEventStatisticsEnable is TRUE.
+
+**/
+VOID
+CoreDumpEventStatistics (
+  VOID
+  )
+{
+  EFI_TPL  Tpl;
+
+  if (!FeaturePcdGet (PcdEventStatisticsEnable)) {
+    return;
+  }
+
+  DEBUG ((
+    DEBUG_EVENT,
+    "Timer ticks: %ld, timers fired: %ld, max per tick: %ld\n",
+    gEventStatistics.TimerTicks,
+    gEventStatistics.TimersFired,
+    gEventStatistics.MaxTimersFiredPerTick
+    ));
+  DEBUG ((
+    DEBUG_EVENT,
+    "Event group signals: %ld, events notified: %ld\n",
+    gEventStatistics.GroupSignals,
+    gEventStatistics.GroupEventsNotified
+    ));
+  for (Tpl = TPL_APPLICATION; Tpl <= TPL_HIGH_LEVEL; Tpl++) {
+    if (gEventStatistics.Notifies[Tpl] != 0) {
+      DEBUG ((
+        DEBUG_EVENT,
+        "TPL %2d notifies: %ld, %ld ns\n",
+        (UINT32) Tpl,
+        gEventStatistics.Notifies[Tpl],
+        gEventStatistics.NotifyTime[Tpl]
+        ));
+    }
+  }
+  DEBUG ((
+    DEBUG_EVENT,
+    "Slowest notify function: %p, %ld ns\n",
+    gEventStatistics.MaxNotifyFunction,
+    gEventStatistics.MaxNotifyTime
+    ));
+}
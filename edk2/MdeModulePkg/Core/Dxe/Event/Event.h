@@ -14,6 +14,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define VALID_TPL(a)            ((a) <= TPL_HIGH_LEVEL)
 extern  UINTN                   gEventPending;
 
+///
+/// Number of lists that EVT_NOTIFY_SIGNAL events are hashed into by event group
+///
+#define EVENT_GROUP_HASH_BUCKET_COUNT             64
+
 ///
 /// Set if Event is part of an event group
 ///
@@ -61,6 +66,35 @@ typedef struct {
   TIMER_EVENT_INFO        Timer;
 } IEVENT;
 
+///
+/// Event service statistics, collected when PcdEventStatisticsEnable is TRUE
+///
+typedef struct {
+  ///
+  /// Number of times CoreCheckTimers() ran, and the timers it fired
+  ///
+  UINT64                  TimerTicks;
+  UINT64                  TimersFired;
+  UINT64                  MaxTimersFiredPerTick;
+  ///
+  /// Number of event group signals, and the events they queued
+  ///
+  UINT64                  GroupSignals;
+  UINT64                  GroupEventsNotified;
+  ///
+  /// Notification functions called, and the time spent in them, per TPL
+  ///
+  UINT64                  Notifies[TPL_HIGH_LEVEL + 1];
+  UINT64                  NotifyTime[TPL_HIGH_LEVEL + 1];
+  ///
+  /// The slowest notification function seen so far
+  ///
+  UINT64                  MaxNotifyTime;
+  EFI_EVENT_NOTIFY        MaxNotifyFunction;
+} EVENT_STATISTICS;
+
+extern EVENT_STATISTICS   gEventStatistics;
+
 //
 // Internal prototypes
 //
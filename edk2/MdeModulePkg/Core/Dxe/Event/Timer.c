@@ -10,14 +10,31 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "DxeMain.h"
 #include "Event.h"
 
+//
+// The timer database is a timer wheel. Each slot covers 2^TIMER_WHEEL_SLOT_SHIFT
+// 100ns units (about 6.5ms), and a timer is queued to the slot of its trigger
+// time modulo the size of the wheel, in ascending trigger time order.
+//
+#define TIMER_WHEEL_SLOT_SHIFT    16
+#define TIMER_WHEEL_SLOT_COUNT    256
+
+#define TIMER_WHEEL_SLOT_TIME(Time)  RShiftU64 ((Time), TIMER_WHEEL_SLOT_SHIFT)
+#define TIMER_WHEEL_SLOT(SlotTime)   (&mEfiTimerWheel[(UINTN) (SlotTime) & (TIMER_WHEEL_SLOT_COUNT - 1)])
+
 //
 // Internal data
 //
 
-LIST_ENTRY       mEfiTimerList = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
+LIST_ENTRY       mEfiTimerWheel[TIMER_WHEEL_SLOT_COUNT];
 EFI_LOCK         mEfiTimerLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
 EFI_EVENT        mEfiCheckTimerEvent = NULL;
 
+//
+// mEfiTimerWheelTime   - The slot time up to which the wheel has been checked
+// mEfiTimerNextTrigger - No queued timer expires before this time
+//
+UINT64           mEfiTimerWheelTime = 0;
+UINT64           mEfiTimerNextTrigger = MAX_UINT64;
 EFI_LOCK         mEfiSystemTimeLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 UINT64           mEfiSystemTime = 0;
 
@@ -37,6 +54,7 @@ CoreInsertEventTimer (
   )
 {
   UINT64          TriggerTime;
+  LIST_ENTRY      *Head;
   LIST_ENTRY      *Link;
   IEVENT          *Event2;
 
@@ -48,17 +66,68 @@ CoreInsertEventTimer (
   TriggerTime = Event->Timer.TriggerTime;
 
   //
-  // Insert the timer into the timer database in assending sorted order
+  // Insert the timer into its slot in assending sorted order. The slot is
+  // searched from the tail, as a new timer usually expires last.
   //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
+  Head = TIMER_WHEEL_SLOT (TIMER_WHEEL_SLOT_TIME (TriggerTime));
+  for (Link = Head->BackLink; Link != Head; Link = Link->BackLink) {
     Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
 
-    if (Event2->Timer.TriggerTime > TriggerTime) {
+    if (Event2->Timer.TriggerTime <= TriggerTime) {
+      break;
+    }
+  }
+
+  InsertHeadList (Link, &Event->Timer.Link);
+
+  if (TriggerTime < mEfiTimerNextTrigger) {
+    mEfiTimerNextTrigger = TriggerTime;
+  }
+}
+
+/**
+  Recomputes the earliest trigger time of the timers in the timer wheel.
+
+  All the timers that expired before mEfiTimerWheelTime must have been
+  removed from the wheel.
+
+**/
+VOID
+CoreUpdateNextTimerTrigger (
+  VOID
+  )
+{
+  UINT64          NextTrigger;
+  UINT64          SlotTime;
+  UINTN           Index;
+  LIST_ENTRY      *Head;
+  IEVENT          *Event;
+
+  ASSERT_LOCKED (&mEfiTimerLock);
+
+  NextTrigger = MAX_UINT64;
+  for (Index = 0; Index < TIMER_WHEEL_SLOT_COUNT; Index++) {
+    SlotTime = mEfiTimerWheelTime + Index;
+    Head = TIMER_WHEEL_SLOT (SlotTime);
+    if (IsListEmpty (Head)) {
+      continue;
+    }
+
+    Event = CR (Head->ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+    if (Event->Timer.TriggerTime < NextTrigger) {
+      NextTrigger = Event->Timer.TriggerTime;
+    }
+
+    //
+    // The timers of this revolution of the wheel expire before the timers
+    // in any of the slots that are left
+    //
+    if (TIMER_WHEEL_SLOT_TIME (Event->Timer.TriggerTime) == SlotTime) {
       break;
     }
   }
 
-  InsertTailList (Link, &Event->Timer.Link);
+  mEfiTimerNextTrigger = NextTrigger;
 }
 
 /**
@@ -82,7 +151,7 @@ CoreCurrentSystemTime (
 }
 
 /**
-  Checks the sorted timer list against the current system time.
+  Checks the timer wheel against the current system time.
   Signals any expired event timer.
 
   @param  CheckEvent             Not used
@@ -97,6 +166,10 @@ CoreCheckTimers (
   )
 {
   UINT64                  SystemTime;
+  UINT64                  SlotTime;
+  UINT64                  CurrentSlotTime;
+  UINT64                  Fired;
+  LIST_ENTRY              *Head;
   IEVENT                  *Event;
 
   //
@@ -104,50 +177,76 @@ CoreCheckTimers (
   //
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
+  Fired = 0;
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  //
+  // Check each slot from the last one checked up to the current one, but
+  // no slot more than once
+  //
+  CurrentSlotTime = TIMER_WHEEL_SLOT_TIME (SystemTime);
+  SlotTime = mEfiTimerWheelTime;
+  if (CurrentSlotTime - SlotTime >= TIMER_WHEEL_SLOT_COUNT) {
+    SlotTime = CurrentSlotTime - (TIMER_WHEEL_SLOT_COUNT - 1);
+  }
 
-    //
-    // If this timer is not expired, then we're done
-    //
-    if (Event->Timer.TriggerTime > SystemTime) {
-      break;
-    }
+  for (; SlotTime <= CurrentSlotTime; SlotTime++) {
+    Head = TIMER_WHEEL_SLOT (SlotTime);
+    while (!IsListEmpty (Head)) {
+      Event = CR (Head->ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
 
-    //
-    // Remove this timer from the timer queue
-    //
+      //
+      // If this timer is not expired, then the rest of the slot is not either
+      //
+      if (Event->Timer.TriggerTime > SystemTime) {
+        break;
+      }
 
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+      //
+      // Remove this timer from the timer queue
+      //
 
-    //
-    // Signal it
-    //
-    CoreSignalEvent (Event);
+      RemoveEntryList (&Event->Timer.Link);
+      Event->Timer.Link.ForwardLink = NULL;
 
-    //
-    // If this is a periodic timer, set it
-    //
-    if (Event->Timer.Period != 0) {
       //
-      // Compute the timers new trigger time
+      // Signal it
       //
-      Event->Timer.TriggerTime = Event->Timer.TriggerTime + Event->Timer.Period;
+      CoreSignalEvent (Event);
+      Fired++;
 
       //
-      // If that's before now, then reset the timer to start from now
+      // If this is a periodic timer, set it
       //
-      if (Event->Timer.TriggerTime <= SystemTime) {
-        Event->Timer.TriggerTime = SystemTime;
-        CoreSignalEvent (mEfiCheckTimerEvent);
+      if (Event->Timer.Period != 0) {
+        //
+        // Compute the timers new trigger time
+        //
+        Event->Timer.TriggerTime = Event->Timer.TriggerTime + Event->Timer.Period;
+
+        //
+        // If that's before now, then reset the timer to start from now
+        //
+        if (Event->Timer.TriggerTime <= SystemTime) {
+          Event->Timer.TriggerTime = SystemTime;
+          CoreSignalEvent (mEfiCheckTimerEvent);
+        }
+
+        //
+        // Add the timer
+        //
+        CoreInsertEventTimer (Event);
       }
+    }
+  }
 
-      //
-      // Add the timer
-      //
-      CoreInsertEventTimer (Event);
+  mEfiTimerWheelTime = CurrentSlotTime;
+  CoreUpdateNextTimerTrigger ();
+
+  if (FeaturePcdGet (PcdEventStatisticsEnable)) {
+    gEventStatistics.TimerTicks++;
+    gEventStatistics.TimersFired += Fired;
+    if (Fired > gEventStatistics.MaxTimersFiredPerTick) {
+      gEventStatistics.MaxTimersFiredPerTick = Fired;
     }
   }
 
@@ -165,6 +264,11 @@ CoreInitializeTimer (
   )
 {
   EFI_STATUS  Status;
+  UINTN       Index;
+
+  for (Index = 0; Index < TIMER_WHEEL_SLOT_COUNT; Index++) {
+    InitializeListHead (&mEfiTimerWheel[Index]);
+  }
 
   Status = CoreCreateEventInternal (
              EVT_NOTIFY_SIGNAL,
@@ -191,8 +295,6 @@ CoreTimerTick (
   IN UINT64   Duration
   )
 {
-  IEVENT          *Event;
-
   //
   // Check runtiem flag in case there are ticks while exiting boot services
   //
@@ -204,15 +306,11 @@ CoreTimerTick (
   mEfiSystemTime += Duration;
 
   //
-  // If the head of the list is expired, fire the timer event
+  // If the earliest timer is expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
-
-    if (Event->Timer.TriggerTime <= mEfiSystemTime) {
-      CoreSignalEvent (mEfiCheckTimerEvent);
-    }
+  if (mEfiTimerNextTrigger <= mEfiSystemTime) {
+    CoreSignalEvent (mEfiCheckTimerEvent);
   }
 
   CoreReleaseLock (&mEfiSystemTimeLock);
@@ -299,6 +299,174 @@ FreeFvDeviceResource (
 
 
 
+//
+// Verifying the data checksums of the files of an FV is spread over the APs
+// only when the FV holds at least this many checksummed bytes.
+//
+#define FV_CHECKSUM_MP_THRESHOLD  SIZE_1MB
+
+typedef struct {
+  EFI_FFS_FILE_HEADER  *FfsHeader;
+  BOOLEAN              Valid;
+} FV_CHECKSUM_JOB;
+
+typedef struct {
+  FV_CHECKSUM_JOB      *Jobs;
+  UINT32               JobCount;
+  volatile UINT32      NextJob;
+  UINT8                ErasePolarity;
+} FV_CHECKSUM_QUEUE;
+
+/**
+  Verify the files of a checksum queue until the queue is empty.
+
+  This function runs on every enabled AP at the same time when the MP
+  Services Protocol is available, and on the BSP otherwise. It only touches
+  memory that has been set up by the BSP, and it does not call any UEFI
+  service.
+
+  @param  Buffer                Pointer to the FV_CHECKSUM_QUEUE.
+
+**/
+VOID
+EFIAPI
+FvChecksumWorker (
+  IN OUT VOID  *Buffer
+  )
+{
+  FV_CHECKSUM_QUEUE  *Queue;
+  UINT32             Index;
+
+  Queue = (FV_CHECKSUM_QUEUE *) Buffer;
+  while (TRUE) {
+    Index = InterlockedIncrement (&Queue->NextJob) - 1;
+    if (Index >= Queue->JobCount) {
+      break;
+    }
+
+    Queue->Jobs[Index].Valid = IsValidFfsFile (Queue->ErasePolarity, Queue->Jobs[Index].FfsHeader);
+  }
+}
+
+/**
+  Process a checksum queue, on every processor when possible.
+
+  The APs are started in blocking mode, which returns as soon as the last AP
+  is done. If the MP Services Protocol is not installed yet, or if the APs can
+  not be started, the BSP processes the whole queue by itself.
+
+  @param  Queue                 The checksum queue to process.
+  @param  Size                  Total size, in bytes, of the files in the queue.
+
+**/
+VOID
+FvRunChecksumQueue (
+  IN OUT FV_CHECKSUM_QUEUE  *Queue,
+  IN     UINTN              Size
+  )
+{
+  EFI_STATUS                Status;
+  EFI_MP_SERVICES_PROTOCOL  *MpServices;
+
+  //
+  // In non-blocking mode, the completion event is only signaled from the
+  // periodic timer of the MP Services driver, tens of milliseconds after
+  // the APs are done. Blocking mode polls the APs instead, so the BSP
+  // leaves the work to them.
+  //
+  if (Size >= FV_CHECKSUM_MP_THRESHOLD && Queue->JobCount > 1) {
+    Status = CoreLocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **) &MpServices);
+    if (!EFI_ERROR (Status)) {
+      MpServices->StartupAllAPs (
+                    MpServices,
+                    FvChecksumWorker,
+                    FALSE,
+                    NULL,
+                    0,
+                    Queue,
+                    NULL
+                    );
+    }
+  }
+
+  //
+  // Take the jobs the APs did not, all of them if no AP ran.
+  //
+  FvChecksumWorker (Queue);
+}
+
+/**
+  Verify the data checksum of every file of an FV that carries one.
+
+  FvCheck () leaves the data checksums to this function, so that they can be
+  verified in one pass over all the files instead of one file at a time.
+
+  @param  FvDevice              A pointer to the FvDevice to be checked.
+
+  @retval EFI_SUCCESS           All the data checksums are valid.
+  @retval EFI_OUT_OF_RESOURCES  No enough buffer could be allocated.
+  @retval EFI_VOLUME_CORRUPTED  A data checksum is not valid.
+
+**/
+EFI_STATUS
+FvVerifyFileChecksums (
+  IN FV_DEVICE  *FvDevice
+  )
+{
+  LIST_ENTRY           *Link;
+  FFS_FILE_LIST_ENTRY  *FfsFileEntry;
+  FV_CHECKSUM_QUEUE    Queue;
+  UINTN                Size;
+  UINT32               Index;
+  EFI_STATUS           Status;
+
+  Queue.JobCount      = 0;
+  Queue.NextJob       = 0;
+  Queue.ErasePolarity = FvDevice->ErasePolarity;
+  Size                = 0;
+
+  for (Link = FvDevice->FfsFileListHeader.ForwardLink; Link != &FvDevice->FfsFileListHeader; Link = Link->ForwardLink) {
+    FfsFileEntry = (FFS_FILE_LIST_ENTRY *) Link;
+    if ((FfsFileEntry->FfsHeader->Attributes & FFS_ATTRIB_CHECKSUM) == FFS_ATTRIB_CHECKSUM) {
+      Queue.JobCount++;
+      Size += IS_FFS_FILE2 (FfsFileEntry->FfsHeader) ? FFS_FILE2_SIZE (FfsFileEntry->FfsHeader) : FFS_FILE_SIZE (FfsFileEntry->FfsHeader);
+    }
+  }
+
+  if (Queue.JobCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Queue.Jobs = AllocatePool (Queue.JobCount * sizeof (FV_CHECKSUM_JOB));
+  if (Queue.Jobs == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Index = 0;
+  for (Link = FvDevice->FfsFileListHeader.ForwardLink; Link != &FvDevice->FfsFileListHeader; Link = Link->ForwardLink) {
+    FfsFileEntry = (FFS_FILE_LIST_ENTRY *) Link;
+    if ((FfsFileEntry->FfsHeader->Attributes & FFS_ATTRIB_CHECKSUM) == FFS_ATTRIB_CHECKSUM) {
+      Queue.Jobs[Index].FfsHeader = FfsFileEntry->FfsHeader;
+      Queue.Jobs[Index].Valid     = FALSE;
+      Index++;
+    }
+  }
+
+  FvRunChecksumQueue (&Queue, Size);
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < Queue.JobCount; Index++) {
+    if (!Queue.Jobs[Index].Valid) {
+      DEBUG ((DEBUG_ERROR, "File %g in FV has an invalid data checksum\n", &Queue.Jobs[Index].FfsHeader->Name));
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+  }
+
+  CoreFreePool (Queue.Jobs);
+  return Status;
+}
+
 /**
   Check if an FV is consistent and allocate cache for it.
 
@@ -497,7 +665,22 @@ FvCheck (
       }
     }
 
-    if (!IsValidFfsFile (FvDevice->ErasePolarity, CacheFfsHeader)) {
+    //
+    // The data checksum of a file that goes into the file list is verified
+    // later on, together with the other files, by FvVerifyFileChecksums ().
+    //
+    FileState = GetFileState (FvDevice->ErasePolarity, CacheFfsHeader);
+    if (((CacheFfsHeader->Attributes & FFS_ATTRIB_CHECKSUM) != FFS_ATTRIB_CHECKSUM) ||
+        (FileState == EFI_FILE_DELETED) ||
+        (IS_FFS_FILE2 (CacheFfsHeader) && !FvDevice->IsFfs3Fv)) {
+      if (!IsValidFfsFile (FvDevice->ErasePolarity, CacheFfsHeader)) {
+        //
+        // File system is corrupted
+        //
+        Status = EFI_VOLUME_CORRUPTED;
+        goto Done;
+      }
+    } else if ((FileState != EFI_FILE_DATA_VALID) && (FileState != EFI_FILE_MARKED_FOR_UPDATE)) {
       //
       // File system is corrupted
       //
@@ -518,8 +701,6 @@ FvCheck (
       }
     }
 
-    FileState = GetFileState (FvDevice->ErasePolarity, CacheFfsHeader);
-
     //
     // check for non-deleted file
     //
@@ -553,6 +734,10 @@ FvCheck (
   }
 
 Done:
+  if (!EFI_ERROR (Status)) {
+    Status = FvVerifyFileChecksums (FvDevice);
+  }
+
   if (EFI_ERROR (Status)) {
     if (FileCached) {
       CoreFreePool (CacheFfsHeader);
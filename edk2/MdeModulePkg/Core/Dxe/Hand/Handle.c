@@ -15,12 +15,103 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // gHandleList           - A list of all the handles in the system
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
+// mHandleHashTable      - Handles in gHandleList, hashed by handle value
+// mProtocolHashTable    - Protocol entries in mProtocolDatabase, hashed by GUID
 //
 LIST_ENTRY      mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
 LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
 
+LIST_ENTRY      mHandleHashTable[HANDLE_HASH_BUCKET_COUNT];
+LIST_ENTRY      mProtocolHashTable[PROTOCOL_HASH_BUCKET_COUNT];
+BOOLEAN         mHandleHashTableInitialized = FALSE;
+
+
+
+/**
+  Initialize the bucket lists of the handle and protocol hash tables the
+  first time they are used.
+
+**/
+VOID
+CoreInitializeHandleHashTables (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  if (mHandleHashTableInitialized) {
+    return;
+  }
+
+  for (Index = 0; Index < HANDLE_HASH_BUCKET_COUNT; Index++) {
+    InitializeListHead (&mHandleHashTable[Index]);
+  }
+  for (Index = 0; Index < PROTOCOL_HASH_BUCKET_COUNT; Index++) {
+    InitializeListHead (&mProtocolHashTable[Index]);
+  }
+  mHandleHashTableInitialized = TRUE;
+}
+
+
+
+/**
+  Return the handle hash bucket that a handle value belongs to.
+
+  The handle value is only used as a number, so it is safe to call this
+  function with a pointer that is not a valid IHANDLE.
+
+  @param  UserHandle             The handle value to hash
+
+  @return The bucket list head for UserHandle
+
+**/
+LIST_ENTRY *
+CoreGetHandleHashBucket (
+  IN  EFI_HANDLE                UserHandle
+  )
+{
+  UINTN  Value;
+
+  CoreInitializeHandleHashTables ();
+
+  //
+  // Handles come from pool, so the low bits carry no information
+  //
+  Value = (UINTN) UserHandle;
+  Value = (Value >> 3) ^ (Value >> 12);
+  return &mHandleHashTable[Value & (HANDLE_HASH_BUCKET_COUNT - 1)];
+}
+
+
+
+/**
+  Return the protocol hash bucket that a protocol GUID belongs to.
+
+  @param  Protocol               The ID of the protocol
+
+  @return The bucket list head for Protocol
+
+**/
+LIST_ENTRY *
+CoreGetProtocolHashBucket (
+  IN EFI_GUID   *Protocol
+  )
+{
+  UINT32  Value;
+
+  CoreInitializeHandleHashTables ();
+
+  Value = ReadUnaligned32 ((UINT32 *) Protocol) ^
+          ReadUnaligned32 ((UINT32 *) Protocol + 1) ^
+          ReadUnaligned32 ((UINT32 *) Protocol + 2) ^
+          ReadUnaligned32 ((UINT32 *) Protocol + 3);
+  Value = Value ^ (Value >> 16);
+  Value = Value ^ (Value >> 8);
+  return &mProtocolHashTable[Value & (PROTOCOL_HASH_BUCKET_COUNT - 1)];
+}
+
 
 
 /**
@@ -66,14 +157,20 @@ CoreValidateHandle (
   )
 {
   IHANDLE             *Handle;
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
 
   if (UserHandle == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  for (Link = gHandleList.BackLink; Link != &gHandleList; Link = Link->BackLink) {
-    Handle = CR (Link, IHANDLE, AllHandles, EFI_HANDLE_SIGNATURE);
+  //
+  // Only the bucket for UserHandle is searched, and UserHandle itself is
+  // never dereferenced before it has been found there
+  //
+  Bucket = CoreGetHandleHashBucket (UserHandle);
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Handle = CR (Link, IHANDLE, HashLink, EFI_HANDLE_SIGNATURE);
     if (Handle == (IHANDLE *) UserHandle) {
       return EFI_SUCCESS;
     }
@@ -100,6 +197,7 @@ CoreFindProtocolEntry (
   IN BOOLEAN    Create
   )
 {
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
   PROTOCOL_ENTRY      *Item;
   PROTOCOL_ENTRY      *ProtEntry;
@@ -107,15 +205,16 @@ CoreFindProtocolEntry (
   ASSERT_LOCKED(&gProtocolDatabaseLock);
 
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket of the database for the matching GUID
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
+  Bucket    = CoreGetProtocolHashBucket (Protocol);
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    Item = CR(Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
 
       //
@@ -147,6 +246,7 @@ CoreFindProtocolEntry (
       // Add it to protocol database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertTailList (Bucket, &ProtEntry->HashLink);
     }
   }
 
@@ -427,6 +527,7 @@ CoreInstallProtocolInterfaceNotify (
     // in the system
     //
     InsertTailList (&gHandleList, &Handle->AllHandles);
+    InsertTailList (CoreGetHandleHashBucket (Handle), &Handle->HashLink);
   } else {
     Status = CoreValidateHandle (Handle);
     if (EFI_ERROR (Status)) {
@@ -484,6 +585,11 @@ Done:
     // Return the new handle back to the caller
     //
     *UserHandle = Handle;
+
+    //
+    // Let the dispatcher evaluate the Depex of the drivers waiting for Protocol
+    //
+    CoreWakeDepexWaiters (Protocol);
   } else {
     //
     // There was an error, clean up
@@ -789,6 +895,7 @@ CoreUninstallProtocolInterface (
   if (IsListEmpty (&Handle->Protocols)) {
     Handle->Signature = 0;
     RemoveEntryList (&Handle->AllHandles);
+    RemoveEntryList (&Handle->HashLink);
     CoreFreePool (Handle);
   }
 
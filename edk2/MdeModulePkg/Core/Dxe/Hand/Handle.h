@@ -12,6 +12,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define EFI_HANDLE_SIGNATURE            SIGNATURE_32('h','n','d','l')
 
+///
+/// Number of buckets in the handle and protocol hash tables. Both must be
+/// a power of 2.
+///
+#define HANDLE_HASH_BUCKET_COUNT        512
+#define PROTOCOL_HASH_BUCKET_COUNT      128
+
 ///
 /// IHANDLE - contains a list of protocol handles
 ///
@@ -19,6 +26,8 @@ typedef struct {
   UINTN               Signature;
   /// All handles list of IHANDLE
   LIST_ENTRY          AllHandles;
+  /// Link on the handle hash bucket list
+  LIST_ENTRY          HashLink;
   /// List of PROTOCOL_INTERFACE's for this handle
   LIST_ENTRY          Protocols;
   UINTN               LocateRequest;
@@ -39,6 +48,8 @@ typedef struct {
   UINTN               Signature;
   /// Link Entry inserted to mProtocolDatabase
   LIST_ENTRY          AllEntries;
+  /// Link Entry inserted to the protocol hash bucket list
+  LIST_ENTRY          HashLink;
   /// ID of the protocol
   EFI_GUID            ProtocolID;
   /// All protocol interfaces
@@ -942,6 +942,7 @@ CoreUnloadAndCloseImage (
 
   if (Image->Started) {
     UnregisterMemoryProfileImage (Image);
+    CoreRecordAllocationTraceImage (Image, MemoryAllocationTraceActionImageUnload);
   }
 
   UnprotectUefiImage (&Image->Info, Image->LoadedImageDevicePath);
@@ -1645,6 +1646,7 @@ CoreStartImage (
   //
   if (SetJumpFlag == 0) {
     RegisterMemoryProfileImage (Image, (Image->ImageContext.ImageType == EFI_IMAGE_SUBSYSTEM_EFI_APPLICATION ? EFI_FV_FILETYPE_APPLICATION : EFI_FV_FILETYPE_DRIVER));
+    CoreRecordAllocationTraceImage (Image, MemoryAllocationTraceActionImageStart);
     //
     // Call the image's entry point
     //
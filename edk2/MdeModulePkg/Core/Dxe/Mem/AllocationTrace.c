@@ -0,0 +1,229 @@
+/** @file
+  Support routines for the memory allocation trace.
+
+  Every successful page and pool allocate/free is written into one slot of a
+  ring buffer published with gEdkiiMemoryAllocationTraceGuid. A slot is
+  reserved with an atomic increment of the sequence number, so an allocation
+  from a notification function that interrupts another one at a lower TPL gets
+  its own slot, and no lock is taken on the allocation paths.
+
+  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+
+MEMORY_ALLOCATION_TRACE_HEADER  *mAllocationTrace = NULL;
+
+/**
+  Reserve the next entry of the allocation trace ring.
+
+  @param  Sequence  Returns the sequence number of the reserved entry.
+
+  @return The reserved entry.
+
+**/
+STATIC
+MEMORY_ALLOCATION_TRACE_ENTRY *
+ReserveAllocationTraceEntry (
+  OUT UINT64  *Sequence
+  )
+{
+  UINT64  Current;
+
+  do {
+    Current = mAllocationTrace->NextSequence;
+  } while (InterlockedCompareExchange64 (&mAllocationTrace->NextSequence, Current, Current + 1) != Current);
+
+  *Sequence = Current;
+  return (MEMORY_ALLOCATION_TRACE_ENTRY *) (mAllocationTrace + 1) +
+         ((UINTN) (Current - 1) & (mAllocationTrace->EntryCount - 1));
+}
+
+/**
+  Write one event into the allocation trace ring.
+
+  @param  Action         The MEMORY_ALLOCATION_TRACE_ACTION of the event.
+  @param  MemoryType     Memory type of the buffer.
+  @param  Buffer         Buffer address.
+  @param  Size           Buffer size, in bytes for pool and in pages for pages and images.
+  @param  CallerAddress  Address of caller who call Allocate or Free.
+  @param  FileName       File name of the image for image events, or NULL.
+
+**/
+STATIC
+VOID
+WriteAllocationTraceEntry (
+  IN MEMORY_ALLOCATION_TRACE_ACTION  Action,
+  IN EFI_MEMORY_TYPE                 MemoryType,
+  IN EFI_PHYSICAL_ADDRESS            Buffer,
+  IN UINT64                          Size,
+  IN EFI_PHYSICAL_ADDRESS            CallerAddress,
+  IN EFI_GUID                        *FileName OPTIONAL
+  )
+{
+  MEMORY_ALLOCATION_TRACE_ENTRY  *Entry;
+  UINT64                         Sequence;
+
+  Entry = ReserveAllocationTraceEntry (&Sequence);
+
+  //
+  // Invalidate the slot before the fields change, so that a reader never
+  // takes a mix of the old and new event for a complete one.
+  //
+  Entry->Sequence = 0;
+  MemoryFence ();
+
+  Entry->Action        = (UINT8) Action;
+  Entry->Tpl           = (UINT8) gEfiCurrentTpl;
+  Entry->Reserved      = 0;
+  Entry->MemoryType    = (UINT32) MemoryType;
+  Entry->TimeStamp     = GetPerformanceCounter ();
+  Entry->Buffer        = Buffer;
+  Entry->Size          = Size;
+  Entry->CallerAddress = CallerAddress;
+  if (FileName != NULL) {
+    CopyGuid (&Entry->FileName, FileName);
+  } else {
+    ZeroMem (&Entry->FileName, sizeof (Entry->FileName));
+  }
+
+  MemoryFence ();
+  Entry->Sequence = Sequence;
+}
+
+/**
+  Allocate the memory allocation trace ring and publish it in the
+  EFI System Table.
+
+  The ring is only allocated if PcdMemoryAllocationTraceEntries is not 0.
+
+**/
+VOID
+CoreInitializeAllocationTrace (
+  VOID
+  )
+{
+  EFI_STATUS                      Status;
+  UINT32                          EntryCount;
+  UINTN                           Length;
+  EFI_PHYSICAL_ADDRESS            Memory;
+  MEMORY_ALLOCATION_TRACE_HEADER  *Header;
+
+  EntryCount = PcdGet32 (PcdMemoryAllocationTraceEntries);
+  if (EntryCount == 0) {
+    return;
+  }
+
+  EntryCount = GetPowerOfTwo32 (EntryCount);
+  Length     = sizeof (MEMORY_ALLOCATION_TRACE_HEADER) + EntryCount * sizeof (MEMORY_ALLOCATION_TRACE_ENTRY);
+
+  Status = CoreAllocatePages (
+             AllocateAnyPages,
+             EfiBootServicesData,
+             EFI_SIZE_TO_PAGES (Length),
+             &Memory
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "AllocationTrace: no memory for %d entries\n", EntryCount));
+    return;
+  }
+
+  Header = (MEMORY_ALLOCATION_TRACE_HEADER *) (UINTN) Memory;
+  ZeroMem (Header, Length);
+  Header->Signature      = MEMORY_ALLOCATION_TRACE_SIGNATURE;
+  Header->Length         = (UINT32) Length;
+  Header->Revision       = MEMORY_ALLOCATION_TRACE_REVISION;
+  Header->EntrySize      = sizeof (MEMORY_ALLOCATION_TRACE_ENTRY);
+  Header->EntryCount     = EntryCount;
+  Header->NextSequence   = 1;
+  Header->TimerFrequency = GetPerformanceCounterProperties (&Header->TimerStart, &Header->TimerEnd);
+
+  Status = CoreInstallConfigurationTable (&gEdkiiMemoryAllocationTraceGuid, Header);
+  if (EFI_ERROR (Status)) {
+    CoreFreePages (Memory, EFI_SIZE_TO_PAGES (Length));
+    return;
+  }
+
+  mAllocationTrace = Header;
+
+  //
+  // The DXE core was loaded before the ring existed, record it first so that
+  // its own allocations can be attributed.
+  //
+  if (gDxeCoreLoadedImage != NULL) {
+    WriteAllocationTraceEntry (
+      MemoryAllocationTraceActionImageStart,
+      gDxeCoreLoadedImage->ImageCodeType,
+      (EFI_PHYSICAL_ADDRESS) (UINTN) gDxeCoreLoadedImage->ImageBase,
+      EFI_SIZE_TO_PAGES ((UINTN) gDxeCoreLoadedImage->ImageSize),
+      0,
+      &gEfiCallerIdGuid
+      );
+  }
+}
+
+/**
+  Record a page or pool allocate/free in the memory allocation trace.
+
+  @param  CallerAddress  Address of caller who call Allocate or Free.
+  @param  Action         Allocate or Free action, MemoryAllocationTraceActionAllocatePages
+                         to MemoryAllocationTraceActionFreePool.
+  @param  MemoryType     Memory type.
+  @param  Size           Buffer size, in bytes for pool and in pages for pages.
+                         0 for FreePool.
+  @param  Buffer         Buffer address.
+
+**/
+VOID
+CoreRecordAllocationTrace (
+  IN EFI_PHYSICAL_ADDRESS            CallerAddress,
+  IN MEMORY_ALLOCATION_TRACE_ACTION  Action,
+  IN EFI_MEMORY_TYPE                 MemoryType,
+  IN UINTN                           Size,
+  IN VOID                            *Buffer
+  )
+{
+  if (mAllocationTrace == NULL || gMemoryMapTerminated) {
+    return;
+  }
+
+  WriteAllocationTraceEntry (
+    Action,
+    MemoryType,
+    (EFI_PHYSICAL_ADDRESS) (UINTN) Buffer,
+    Size,
+    CallerAddress,
+    NULL
+    );
+}
+
+/**
+  Record the start or unload of an image in the memory allocation trace, so
+  that the caller addresses of the allocations can be mapped to drivers.
+
+  @param  Image   The image being started or unloaded.
+  @param  Action  MemoryAllocationTraceActionImageStart or
+                  MemoryAllocationTraceActionImageUnload.
+
+**/
+VOID
+CoreRecordAllocationTraceImage (
+  IN LOADED_IMAGE_PRIVATE_DATA       *Image,
+  IN MEMORY_ALLOCATION_TRACE_ACTION  Action
+  )
+{
+  if (mAllocationTrace == NULL || gMemoryMapTerminated) {
+    return;
+  }
+
+  WriteAllocationTraceEntry (
+    Action,
+    Image->Info.ImageCodeType,
+    Image->ImageContext.ImageAddress,
+    EFI_SIZE_TO_PAGES ((UINTN) Image->ImageContext.ImageSize),
+    0,
+    GetFileNameFromFilePath (Image->Info.FilePath)
+    );
+}
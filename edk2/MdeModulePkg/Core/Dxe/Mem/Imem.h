@@ -30,7 +30,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 
 #define MEMORY_MAP_SIGNATURE   SIGNATURE_32('m','m','a','p')
-typedef struct {
+typedef struct _MEMORY_MAP  MEMORY_MAP;
+struct _MEMORY_MAP {
   UINTN           Signature;
   LIST_ENTRY      Link;
   BOOLEAN         FromPages;
@@ -41,7 +42,18 @@ typedef struct {
 
   UINT64          VirtualStart;
   UINT64          Attribute;
-} MEMORY_MAP;
+
+  //
+  // Node in the ordered index of the memory map, an AVL tree keyed by Start.
+  // MaxFreeSize is the size in bytes of the largest EfiConventionalMemory
+  // entry in the subtree rooted at this node.
+  //
+  MEMORY_MAP      *Parent;
+  MEMORY_MAP      *Left;
+  MEMORY_MAP      *Right;
+  UINTN           Height;
+  UINT64          MaxFreeSize;
+};
 
 //
 // Internal prototypes
@@ -172,6 +184,86 @@ CoreInternalAllocatePages (
   IN BOOLEAN                NeedGuard
   );
 
+/**
+  Internal function.  Adds an entry of the memory map to the ordered index.
+  The range of the entry must not overlap any entry already in the index.
+
+  @param  Entry                  The memory map entry to add
+
+**/
+VOID
+CoreInsertMemoryMapIndex (
+  IN MEMORY_MAP       *Entry
+  );
+
+/**
+  Internal function.  Removes an entry of the memory map from the ordered
+  index.
+
+  @param  Entry                  The memory map entry to remove
+
+**/
+VOID
+CoreRemoveMemoryMapIndex (
+  IN MEMORY_MAP       *Entry
+  );
+
+/**
+  Internal function.  Updates the ordered index after the range of an entry
+  has been clipped in place. The entry must keep its position relative to
+  the other entries.
+
+  @param  Entry                  The memory map entry that was clipped
+
+**/
+VOID
+CoreUpdateMemoryMapIndex (
+  IN MEMORY_MAP       *Entry
+  );
+
+/**
+  Internal function.  Finds the memory map entry that covers an address.
+
+  @param  Address                The address to look up
+
+  @return The entry that covers Address, or NULL if there is none
+
+**/
+MEMORY_MAP *
+CoreFindMemoryMapEntry (
+  IN UINT64           Address
+  );
+
+/**
+  Internal function.  Finds the entry that follows an entry in the ordered
+  index, that is the entry with the next higher start address.
+
+  @param  Entry                  The memory map entry in the index
+
+  @return The next entry, or NULL if Entry is the highest one
+
+**/
+MEMORY_MAP *
+CoreGetNextMemoryMapEntry (
+  IN MEMORY_MAP       *Entry
+  );
+
+/**
+  Internal function.  Finds the EfiConventionalMemory entry with the highest
+  start address below Limit that is at least MinSize bytes long.
+
+  @param  Limit                  The start of the entry must be below Limit
+  @param  MinSize                The minimum size of the entry in bytes
+
+  @return The entry found, or NULL if there is none
+
+**/
+MEMORY_MAP *
+CoreFindFreeMemoryMapEntry (
+  IN UINT64           Limit,
+  IN UINT64           MinSize
+  );
+
 //
 // Internal Global data
 //
@@ -0,0 +1,428 @@
+/** @file
+  Ordered index of the UEFI memory map.
+
+  The entries of gMemoryMap are also kept in an AVL tree keyed by their start
+  address, so that the entry covering an address, the neighbors of a range
+  and the highest free range of a given size are found in O(log n) steps
+  however fragmented the memory map becomes. Each node records the size of
+  the largest free range in its subtree, which lets searches for free pages
+  skip the subtrees that cannot satisfy the request.
+
+  The nodes are embedded in the MEMORY_MAP entries, so the index never
+  allocates memory.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+#include "Imem.h"
+
+//
+// Root of the ordered index of gMemoryMap
+//
+MEMORY_MAP  *mMemoryMapIndexRoot = NULL;
+
+#define NODE_HEIGHT(Node)         (((Node) == NULL) ? 0 : (Node)->Height)
+#define NODE_MAX_FREE_SIZE(Node)  (((Node) == NULL) ? 0 : (Node)->MaxFreeSize)
+
+/**
+  Return the number of bytes of an entry that are free memory.
+
+  @param  Entry                  The memory map entry
+
+  @return The size of Entry if it is EfiConventionalMemory, otherwise 0
+
+**/
+STATIC
+UINT64
+GetFreeSize (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  //
+  // An entry that has just been clipped to nothing has End < Start
+  //
+  if (Entry->Type != EfiConventionalMemory || Entry->End < Entry->Start) {
+    return 0;
+  }
+  return Entry->End - Entry->Start + 1;
+}
+
+/**
+  Recompute the height and the largest free size of a node from its children.
+
+  @param  Node                   The node to update
+
+**/
+STATIC
+VOID
+UpdateNode (
+  IN MEMORY_MAP       *Node
+  )
+{
+  Node->Height      = MAX (NODE_HEIGHT (Node->Left), NODE_HEIGHT (Node->Right)) + 1;
+  Node->MaxFreeSize = MAX (
+                        GetFreeSize (Node),
+                        MAX (NODE_MAX_FREE_SIZE (Node->Left), NODE_MAX_FREE_SIZE (Node->Right))
+                        );
+}
+
+/**
+  Make New take the place of Old as a child of Parent.
+
+  @param  Parent                 The parent of Old, or NULL if Old is the root
+  @param  Old                    The node being replaced
+  @param  New                    The replacing node, may be NULL
+
+**/
+STATIC
+VOID
+ReplaceChild (
+  IN MEMORY_MAP       *Parent,
+  IN MEMORY_MAP       *Old,
+  IN MEMORY_MAP       *New
+  )
+{
+  if (Parent == NULL) {
+    mMemoryMapIndexRoot = New;
+  } else if (Parent->Left == Old) {
+    Parent->Left = New;
+  } else {
+    Parent->Right = New;
+  }
+
+  if (New != NULL) {
+    New->Parent = Parent;
+  }
+}
+
+/**
+  Rotate a subtree to the left.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+RotateLeft (
+  IN MEMORY_MAP       *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot = Node->Right;
+  ReplaceChild (Node->Parent, Node, Pivot);
+
+  Node->Right = Pivot->Left;
+  if (Node->Right != NULL) {
+    Node->Right->Parent = Node;
+  }
+  Pivot->Left  = Node;
+  Node->Parent = Pivot;
+
+  UpdateNode (Node);
+  UpdateNode (Pivot);
+  return Pivot;
+}
+
+/**
+  Rotate a subtree to the right.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+RotateRight (
+  IN MEMORY_MAP       *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot = Node->Left;
+  ReplaceChild (Node->Parent, Node, Pivot);
+
+  Node->Left = Pivot->Right;
+  if (Node->Left != NULL) {
+    Node->Left->Parent = Node;
+  }
+  Pivot->Right = Node;
+  Node->Parent = Pivot;
+
+  UpdateNode (Node);
+  UpdateNode (Pivot);
+  return Pivot;
+}
+
+/**
+  Update and rebalance every node from Node up to the root.
+
+  @param  Node                   The lowest node whose subtree has changed
+
+**/
+STATIC
+VOID
+RebalanceToRoot (
+  IN MEMORY_MAP       *Node
+  )
+{
+  INTN  Balance;
+
+  while (Node != NULL) {
+    UpdateNode (Node);
+
+    Balance = (INTN) NODE_HEIGHT (Node->Left) - (INTN) NODE_HEIGHT (Node->Right);
+    if (Balance > 1) {
+      if (NODE_HEIGHT (Node->Left->Left) < NODE_HEIGHT (Node->Left->Right)) {
+        RotateLeft (Node->Left);
+      }
+      Node = RotateRight (Node);
+    } else if (Balance < -1) {
+      if (NODE_HEIGHT (Node->Right->Right) < NODE_HEIGHT (Node->Right->Left)) {
+        RotateRight (Node->Right);
+      }
+      Node = RotateLeft (Node);
+    }
+
+    Node = Node->Parent;
+  }
+}
+
+/**
+  Internal function.  Adds an entry of the memory map to the ordered index.
+  The range of the entry must not overlap any entry already in the index.
+
+  @param  Entry                  The memory map entry to add
+
+**/
+VOID
+CoreInsertMemoryMapIndex (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  MEMORY_MAP  *Parent;
+  MEMORY_MAP  *Node;
+
+  Parent = NULL;
+  Node   = mMemoryMapIndexRoot;
+  while (Node != NULL) {
+    ASSERT (Node != Entry);
+    Parent = Node;
+    Node   = (Entry->Start < Node->Start) ? Node->Left : Node->Right;
+  }
+
+  Entry->Parent = Parent;
+  Entry->Left   = NULL;
+  Entry->Right  = NULL;
+  if (Parent == NULL) {
+    mMemoryMapIndexRoot = Entry;
+  } else if (Entry->Start < Parent->Start) {
+    Parent->Left = Entry;
+  } else {
+    Parent->Right = Entry;
+  }
+
+  RebalanceToRoot (Entry);
+}
+
+/**
+  Internal function.  Removes an entry of the memory map from the ordered
+  index.
+
+  @param  Entry                  The memory map entry to remove
+
+**/
+VOID
+CoreRemoveMemoryMapIndex (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  MEMORY_MAP  *Successor;
+  MEMORY_MAP  *Lowest;
+
+  if (Entry->Left != NULL && Entry->Right != NULL) {
+    //
+    // Move the successor of Entry, which has no left child, into its place
+    //
+    Successor = Entry->Right;
+    while (Successor->Left != NULL) {
+      Successor = Successor->Left;
+    }
+
+    if (Successor->Parent != Entry) {
+      Lowest = Successor->Parent;
+      ReplaceChild (Successor->Parent, Successor, Successor->Right);
+      Successor->Right         = Entry->Right;
+      Successor->Right->Parent = Successor;
+    } else {
+      Lowest = Successor;
+    }
+
+    ReplaceChild (Entry->Parent, Entry, Successor);
+    Successor->Left         = Entry->Left;
+    Successor->Left->Parent = Successor;
+  } else {
+    Lowest = Entry->Parent;
+    ReplaceChild (Entry->Parent, Entry, (Entry->Left != NULL) ? Entry->Left : Entry->Right);
+  }
+
+  Entry->Parent = NULL;
+  Entry->Left   = NULL;
+  Entry->Right  = NULL;
+
+  RebalanceToRoot (Lowest);
+}
+
+/**
+  Internal function.  Updates the ordered index after the range of an entry
+  has been clipped in place. The entry must keep its position relative to
+  the other entries.
+
+  @param  Entry                  The memory map entry that was clipped
+
+**/
+VOID
+CoreUpdateMemoryMapIndex (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  //
+  // The shape of the tree does not change, only the free sizes on the path
+  // to the root
+  //
+  while (Entry != NULL) {
+    UpdateNode (Entry);
+    Entry = Entry->Parent;
+  }
+}
+
+/**
+  Internal function.  Finds the memory map entry that covers an address.
+
+  @param  Address                The address to look up
+
+  @return The entry that covers Address, or NULL if there is none
+
+**/
+MEMORY_MAP *
+CoreFindMemoryMapEntry (
+  IN UINT64           Address
+  )
+{
+  MEMORY_MAP  *Node;
+
+  Node = mMemoryMapIndexRoot;
+  while (Node != NULL) {
+    if (Address < Node->Start) {
+      Node = Node->Left;
+    } else if (Address > Node->End) {
+      Node = Node->Right;
+    } else {
+      return Node;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Internal function.  Finds the entry that follows an entry in the ordered
+  index, that is the entry with the next higher start address.
+
+  @param  Entry                  The memory map entry in the index
+
+  @return The next entry, or NULL if Entry is the highest one
+
+**/
+MEMORY_MAP *
+CoreGetNextMemoryMapEntry (
+  IN MEMORY_MAP       *Entry
+  )
+{
+  MEMORY_MAP  *Node;
+
+  if (Entry->Right != NULL) {
+    Node = Entry->Right;
+    while (Node->Left != NULL) {
+      Node = Node->Left;
+    }
+
+    return Node;
+  }
+
+  while (Entry->Parent != NULL && Entry->Parent->Right == Entry) {
+    Entry = Entry->Parent;
+  }
+
+  return Entry->Parent;
+}
+
+/**
+  Find the free entry with the highest start address below Limit that is at
+  least MinSize bytes long, in a subtree.
+
+  @param  Node                   The root of the subtree
+  @param  Limit                  The start of the entry must be below Limit
+  @param  MinSize                The minimum size of the entry in bytes
+
+  @return The entry found, or NULL if there is none
+
+**/
+STATIC
+MEMORY_MAP *
+FindFreeEntryInSubtree (
+  IN MEMORY_MAP       *Node,
+  IN UINT64           Limit,
+  IN UINT64           MinSize
+  )
+{
+  MEMORY_MAP  *Found;
+
+  while (Node != NULL && Node->MaxFreeSize >= MinSize) {
+    if (Node->Start >= Limit) {
+      Node = Node->Left;
+      continue;
+    }
+
+    //
+    // Entries in the right subtree are higher than Node, try them first
+    //
+    Found = FindFreeEntryInSubtree (Node->Right, Limit, MinSize);
+    if (Found != NULL) {
+      return Found;
+    }
+
+    if (GetFreeSize (Node) >= MinSize) {
+      return Node;
+    }
+
+    Node = Node->Left;
+  }
+
+  return NULL;
+}
+
+/**
+  Internal function.  Finds the EfiConventionalMemory entry with the highest
+  start address below Limit that is at least MinSize bytes long.
+
+  @param  Limit                  The start of the entry must be below Limit
+  @param  MinSize                The minimum size of the entry in bytes
+
+  @return The entry found, or NULL if there is none
+
+**/
+MEMORY_MAP *
+CoreFindFreeMemoryMapEntry (
+  IN UINT64           Limit,
+  IN UINT64           MinSize
+  )
+{
+  return FindFreeEntryInSubtree (mMemoryMapIndexRoot, Limit, MinSize);
+}
@@ -132,6 +132,7 @@ RemoveMemoryMapEntry (
   IN OUT MEMORY_MAP      *Entry
   )
 {
+  CoreRemoveMemoryMapIndex (Entry);
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
 
@@ -163,7 +164,6 @@ CoreAddRange (
   IN UINT64                   Attribute
   )
 {
-  LIST_ENTRY        *Link;
   MEMORY_MAP        *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -209,32 +209,22 @@ CoreAddRange (
   //
 
   // Two memory descriptors can only be merged if they have the same Type
-  // and the same Attribute
+  // and the same Attribute. As the range does not exist in the map yet,
+  // only the entries covering Start - 1 and End + 1 can adjoin it.
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
-    }
-
-    if (Entry->End + 1 == Start) {
-
-      Start = Entry->Start;
-      RemoveMemoryMapEntry (Entry);
-
-    } else if (Entry->Start == End + 1) {
+  Entry = (Start == 0) ? NULL : CoreFindMemoryMapEntry (Start - 1);
+  if (Entry != NULL && Entry->Type == Type && Entry->Attribute == Attribute) {
+    ASSERT (Entry->End + 1 == Start);
+    Start = Entry->Start;
+    RemoveMemoryMapEntry (Entry);
+  }
 
-      End = Entry->End;
-      RemoveMemoryMapEntry (Entry);
-    }
+  Entry = (End == MAX_UINT64) ? NULL : CoreFindMemoryMapEntry (End + 1);
+  if (Entry != NULL && Entry->Type == Type && Entry->Attribute == Attribute) {
+    ASSERT (Entry->Start == End + 1);
+    End = Entry->End;
+    RemoveMemoryMapEntry (Entry);
   }
 
   //
@@ -249,6 +239,7 @@ CoreAddRange (
   mMapStack[mMapDepth].VirtualStart  = 0;
   mMapStack[mMapDepth].Attribute     = Attribute;
   InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  CoreInsertMemoryMapIndex (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -322,7 +313,6 @@ CoreFreeMemoryMapStack (
 {
   MEMORY_MAP      *Entry;
   MEMORY_MAP      *Entry2;
-  LIST_ENTRY      *Link2;
 
   ASSERT_LOCKED (&gMemoryLock);
 
@@ -356,23 +346,25 @@ CoreFreeMemoryMapStack (
       //
       // Move this entry to general memory
       //
+      CoreRemoveMemoryMapIndex (&mMapStack[mMapDepth]);
       RemoveEntryList (&mMapStack[mMapDepth].Link);
       mMapStack[mMapDepth].Link.ForwardLink = NULL;
 
       CopyMem (Entry , &mMapStack[mMapDepth], sizeof (MEMORY_MAP));
       Entry->FromPages = TRUE;
+      CoreInsertMemoryMapIndex (Entry);
 
       //
-      // Find insertion location
+      // Find insertion location: in front of the next higher entry that has
+      // been moved to general memory. The entries skipped are still on the
+      // map stack, so there are at most MAX_MAP_DEPTH of them.
       //
-      for (Link2 = gMemoryMap.ForwardLink; Link2 != &gMemoryMap; Link2 = Link2->ForwardLink) {
-        Entry2 = CR (Link2, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-        if (Entry2->FromPages && Entry2->Start > Entry->Start) {
-          break;
-        }
+      Entry2 = CoreGetNextMemoryMapEntry (Entry);
+      while (Entry2 != NULL && !Entry2->FromPages) {
+        Entry2 = CoreGetNextMemoryMapEntry (Entry2);
       }
 
-      InsertTailList (Link2, &Entry->Link);
+      InsertTailList ((Entry2 != NULL) ? &Entry2->Link : &gMemoryMap, &Entry->Link);
 
     } else {
       //
@@ -736,7 +728,6 @@ CoreConvertPagesEx (
   UINT64          RangeEnd;
   UINT64          Attribute;
   EFI_MEMORY_TYPE MemType;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
 
   Entry = NULL;
@@ -762,15 +753,8 @@ CoreConvertPagesEx (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-      if (Entry->Start <= Start && Entry->End > Start) {
-        break;
-      }
-    }
-
-    if (Link == &gMemoryMap) {
+    Entry = CoreFindMemoryMapEntry (Start);
+    if (Entry == NULL) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -852,6 +836,7 @@ CoreConvertPagesEx (
       // Clip start
       //
       Entry->Start = RangeEnd + 1;
+      CoreUpdateMemoryMapIndex (Entry);
 
     } else if (Entry->End == RangeEnd) {
 
@@ -859,6 +844,7 @@ CoreConvertPagesEx (
       // Clip end
       //
       Entry->End = Start - 1;
+      CoreUpdateMemoryMapIndex (Entry);
 
     } else {
 
@@ -882,9 +868,11 @@ CoreConvertPagesEx (
 
       Entry->End = Start - 1;
       ASSERT (Entry->Start < Entry->End);
+      CoreUpdateMemoryMapIndex (Entry);
 
       Entry = &mMapStack[mMapDepth];
       InsertTailList (&gMemoryMap, &Entry->Link);
+      CoreInsertMemoryMapIndex (Entry);
 
       mMapDepth += 1;
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -1038,7 +1026,7 @@ CoreFindFreePagesI (
   UINT64          DescStart;
   UINT64          DescEnd;
   UINT64          DescNumberOfBytes;
-  LIST_ENTRY      *Link;
+  UINT64          Limit;
   MEMORY_MAP      *Entry;
 
   if ((MaxAddress < EFI_PAGE_MASK) ||(NumberOfPages == 0)) {
@@ -1070,24 +1058,26 @@ CoreFindFreePagesI (
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
   Target = 0;
 
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
+  //
+  // Visit the free entries that are large enough from the highest address
+  // down, so the first one that fits is the best match.
+  //
+  Limit = MaxAddress;
+  while (Target == 0) {
+    Entry = CoreFindFreeMemoryMapEntry (Limit, NumberOfBytes);
+    if (Entry == NULL) {
+      break;
     }
+    Limit = Entry->Start;
 
     DescStart = Entry->Start;
     DescEnd = Entry->End;
 
     //
-    // If desc is past max allowed address or below min allowed address, skip it
+    // If desc is below min allowed address, so are all the remaining ones
     //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
+    if (DescEnd < MinAddress) {
+      break;
     }
 
     //
@@ -1119,22 +1109,20 @@ CoreFindFreePagesI (
       }
 
       //
-      // If this is the best match so far remember it
+      // This is the best match
       //
-      if (DescEnd > Target) {
-        if (NeedGuard) {
-          DescEnd = AdjustMemoryS (
-                      DescEnd + 1 - DescNumberOfBytes,
-                      DescNumberOfBytes,
-                      NumberOfBytes
-                      );
-          if (DescEnd == 0) {
-            continue;
-          }
+      if (NeedGuard) {
+        DescEnd = AdjustMemoryS (
+                    DescEnd + 1 - DescNumberOfBytes,
+                    DescNumberOfBytes,
+                    NumberOfBytes
+                    );
+        if (DescEnd == 0) {
+          continue;
         }
-
-        Target = DescEnd;
       }
+
+      Target = DescEnd;
     }
   }
 
@@ -1420,6 +1408,13 @@ CoreAllocatePages (
       (VOID *) (UINTN) *Memory,
       NULL
       );
+    CoreRecordAllocationTrace (
+      (EFI_PHYSICAL_ADDRESS) (UINTN) RETURN_ADDRESS (0),
+      MemoryAllocationTraceActionAllocatePages,
+      MemoryType,
+      NumberOfPages,
+      (VOID *) (UINTN) *Memory
+      );
     InstallMemoryAttributesTableOnMemoryAllocation (MemoryType);
     ApplyMemoryProtectionPolicy (EfiConventionalMemory, MemoryType, *Memory,
       EFI_PAGES_TO_SIZE (NumberOfPages));
@@ -1448,7 +1443,6 @@ CoreInternalFreePages (
   )
 {
   EFI_STATUS      Status;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
   UINTN           Alignment;
   BOOLEAN         IsGuarded;
@@ -1462,14 +1456,8 @@ CoreInternalFreePages (
   // Find the entry that the covers the range
   //
   IsGuarded = FALSE;
-  Entry = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR(Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if (Entry->Start <= Memory && Entry->End > Memory) {
-        break;
-    }
-  }
-  if (Link == &gMemoryMap) {
+  Entry = CoreFindMemoryMapEntry (Memory);
+  if (Entry == NULL) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
@@ -1544,6 +1532,13 @@ CoreFreePages (
       (VOID *) (UINTN) Memory,
       NULL
       );
+    CoreRecordAllocationTrace (
+      (EFI_PHYSICAL_ADDRESS) (UINTN) RETURN_ADDRESS (0),
+      MemoryAllocationTraceActionFreePages,
+      MemoryType,
+      NumberOfPages,
+      (VOID *) (UINTN) Memory
+      );
     InstallMemoryAttributesTableOnMemoryAllocation (MemoryType);
     ApplyMemoryProtectionPolicy (MemoryType, EfiConventionalMemory, Memory,
       EFI_PAGES_TO_SIZE (NumberOfPages));
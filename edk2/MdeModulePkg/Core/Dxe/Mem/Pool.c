@@ -22,6 +22,7 @@ typedef struct {
 
 #define POOL_HEAD_SIGNATURE       SIGNATURE_32('p','h','d','0')
 #define POOLPAGE_HEAD_SIGNATURE   SIGNATURE_32('p','h','d','1')
+#define POOLSLAB_HEAD_SIGNATURE   SIGNATURE_32('p','h','d','2')
 typedef struct {
   UINT32          Signature;
   UINT32          Reserved;
@@ -60,6 +61,88 @@ STATIC CONST UINT16 mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE     (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Size classes of the slab allocator, used instead of the free lists above
+// when PcdPoolSlabAllocatorEnable is TRUE. Sizes include the POOL_HEAD, and
+// go up in steps of 1.5x and 2x, so no class wastes more than a third of an
+// entry. Slabs of the larger classes span several pages to keep the unused
+// tail of each slab small.
+//
+typedef struct {
+  UINT16          Size;
+  UINT16          Pages;
+} POOL_SLAB_CLASS;
+
+STATIC CONST POOL_SLAB_CLASS mPoolSlabClassTable[] = {
+  {   32, 1 }, {   48, 1 }, {   64, 1 }, {   96, 1 }, {  128, 1 }, {  192, 1 },
+  {  256, 1 }, {  384, 2 }, {  512, 2 }, {  768, 4 }, { 1024, 4 }, { 1536, 8 },
+  { 2048, 8 }
+};
+
+#define MAX_SLAB_CLASS    (ARRAY_SIZE (mPoolSlabClassTable))
+#define MAX_SLAB_SIZE     2048
+
+//
+// Number of free entries each memory type keeps per class in front of the
+// slabs, so an allocation that follows a free of the same size is served
+// without touching any slab.
+//
+#define SLAB_MAGAZINE_SIZE  8
+
+//
+// Maps (Size - 1) / 8 to a slab class, for sizes up to MAX_SLAB_SIZE
+//
+UINT8           mPoolSlabClassMap[MAX_SLAB_SIZE / 8];
+
+#define SIZE_TO_SLAB_CLASS(a)   (mPoolSlabClassMap[((a) - 1) >> 3])
+#define SLAB_CLASS_TO_SIZE(a)   (mPoolSlabClassTable[a].Size)
+
+#define POOL_SLAB_FREE_SIGNATURE  SIGNATURE_32('p','f','r','1')
+typedef struct _POOL_SLAB_FREE POOL_SLAB_FREE;
+struct _POOL_SLAB_FREE {
+  UINT32          Signature;
+  UINT32          Reserved;
+  POOL_SLAB_FREE  *Next;
+};
+
+//
+// Header at the start of the pages of each slab. The Reserved field of the
+// POOL_HEAD of every slab entry holds the offset of the entry from this
+// header.
+//
+#define POOL_SLAB_SIGNATURE  SIGNATURE_32('p','s','l','b')
+typedef struct {
+  UINT32          Signature;
+  UINT32          Class;
+  UINT32          Total;
+  UINT32          InUse;
+  UINTN           Pages;
+  POOL_SLAB_FREE  *FreeList;
+  LIST_ENTRY      Link;
+} POOL_SLAB;
+
+#define SIZE_OF_POOL_SLAB  ALIGN_VALUE (sizeof (POOL_SLAB), 8)
+
+//
+// Slabs and magazine of one size class in one memory type
+//
+typedef struct {
+  LIST_ENTRY      PartialList;
+  UINTN           MagazineCount;
+  POOL_HEAD       *Magazine[SLAB_MAGAZINE_SIZE];
+  //
+  // Statistics
+  //
+  UINT64          Allocations;
+  UINT64          MagazineHits;
+  UINT64          SlabsReclaimed;
+  UINTN           SlabCount;
+  UINTN           SlabPages;
+  UINTN           Capacity;
+  UINTN           InUse;
+  UINTN           RequestedBytes;
+} POOL_SLAB_CACHE;
+
 //
 // Globals
 //
@@ -71,6 +154,7 @@ typedef struct {
     EFI_MEMORY_TYPE  MemoryType;
     LIST_ENTRY       FreeList[MAX_POOL_LIST];
     LIST_ENTRY       Link;
+    POOL_SLAB_CACHE  *SlabCache;
 } POOL;
 
 //
@@ -118,6 +202,7 @@ CoreInitializePool (
 {
   UINTN  Type;
   UINTN  Index;
+  UINTN  Class;
 
   for (Type=0; Type < EfiMaxMemoryType; Type++) {
     mPoolHead[Type].Signature  = 0;
@@ -126,6 +211,14 @@ CoreInitializePool (
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+    mPoolHead[Type].SlabCache  = NULL;
+  }
+
+  for (Index = 0, Class = 0; Index < ARRAY_SIZE (mPoolSlabClassMap); Index++) {
+    while (SLAB_CLASS_TO_SIZE (Class) < (Index + 1) * 8) {
+      Class++;
+    }
+    mPoolSlabClassMap[Index] = (UINT8) Class;
   }
 }
 
@@ -176,6 +269,7 @@ LookupPoolHead (
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&Pool->FreeList[Index]);
     }
+    Pool->SlabCache = NULL;
 
     InsertHeadList (&mPoolHeadList, &Pool->Link);
 
@@ -285,6 +379,13 @@ CoreAllocatePool (
       *Buffer,
       NULL
       );
+    CoreRecordAllocationTrace (
+      (EFI_PHYSICAL_ADDRESS) (UINTN) RETURN_ADDRESS (0),
+      MemoryAllocationTraceActionAllocatePool,
+      PoolType,
+      Size,
+      *Buffer
+      );
     InstallMemoryAttributesTableOnMemoryAllocation (PoolType);
   }
   return Status;
@@ -332,6 +433,393 @@ CoreAllocatePoolPagesI (
   return Buffer;
 }
 
+/**
+  Internal function.  Frees pool pages allocated via CoreAllocatePoolPagesI().
+
+  @param  PoolType               The type of memory for the pool pages
+  @param  Memory                 The base address to free
+  @param  NoPages                The number of pages to free
+
+**/
+STATIC
+VOID
+CoreFreePoolPagesI (
+  IN EFI_MEMORY_TYPE        PoolType,
+  IN EFI_PHYSICAL_ADDRESS   Memory,
+  IN UINTN                  NoPages
+  );
+
+/**
+  Internal function.  Allocates the slab caches of a pool head the first time
+  the slab allocator serves a request of its memory type.
+  Caller must have the memory lock held
+
+  @param  Pool                   The pool head of the memory type
+
+  @retval TRUE                   The slab caches of Pool are available.
+  @retval FALSE                  The slab caches could not be allocated.
+
+**/
+STATIC
+BOOLEAN
+CoreCreatePoolSlabCaches (
+  IN POOL             *Pool
+  )
+{
+  POOL_SLAB_CACHE   *SlabCache;
+  UINTN             Class;
+
+  if (Pool->SlabCache != NULL) {
+    return TRUE;
+  }
+
+  //
+  // Take the caches from pages, so that creating the caches of
+  // EfiBootServicesData does not recurse into the slab allocator
+  //
+  SlabCache = CoreAllocatePoolPagesI (
+                EfiBootServicesData,
+                EFI_SIZE_TO_PAGES (MAX_SLAB_CLASS * sizeof (POOL_SLAB_CACHE)),
+                DEFAULT_PAGE_ALLOCATION_GRANULARITY,
+                FALSE
+                );
+  if (SlabCache == NULL) {
+    return FALSE;
+  }
+
+  ZeroMem (SlabCache, MAX_SLAB_CLASS * sizeof (POOL_SLAB_CACHE));
+  for (Class = 0; Class < MAX_SLAB_CLASS; Class++) {
+    InitializeListHead (&SlabCache[Class].PartialList);
+  }
+  Pool->SlabCache = SlabCache;
+  return TRUE;
+}
+
+/**
+  Internal function.  Takes a free entry of a slab class, from the magazine
+  if possible, then from a partially used slab, and finally from a new slab.
+
+  @param  Pool                   The pool head of the memory type
+  @param  Class                  The slab class to allocate from
+  @param  Granularity            The page allocation granularity of the memory type
+
+  @return The pool head of the entry, or NULL
+
+**/
+STATIC
+POOL_HEAD *
+CoreAllocatePoolSlabEntry (
+  IN POOL             *Pool,
+  IN UINTN            Class,
+  IN UINTN            Granularity
+  )
+{
+  POOL_SLAB_CACHE   *Cache;
+  POOL_SLAB         *Slab;
+  POOL_SLAB_FREE    *Free;
+  UINTN             Pages;
+  UINTN             Index;
+  UINTN             Size;
+
+  Cache = &Pool->SlabCache[Class];
+  Cache->Allocations++;
+
+  if (Cache->MagazineCount > 0) {
+    Cache->MagazineHits++;
+    return Cache->Magazine[--Cache->MagazineCount];
+  }
+
+  if (IsListEmpty (&Cache->PartialList)) {
+    Pages = MAX (mPoolSlabClassTable[Class].Pages, EFI_SIZE_TO_PAGES (Granularity));
+    Slab  = CoreAllocatePoolPagesI (Pool->MemoryType, Pages, Granularity, FALSE);
+    if (Slab == NULL) {
+      return NULL;
+    }
+
+    //
+    // Thread every entry of the new slab onto its free list
+    //
+    Size            = SLAB_CLASS_TO_SIZE (Class);
+    Slab->Signature = POOL_SLAB_SIGNATURE;
+    Slab->Class     = (UINT32) Class;
+    Slab->Total     = (UINT32) ((EFI_PAGES_TO_SIZE (Pages) - SIZE_OF_POOL_SLAB) / Size);
+    Slab->InUse     = 0;
+    Slab->Pages     = Pages;
+    Slab->FreeList  = NULL;
+    for (Index = Slab->Total; Index > 0; Index--) {
+      Free            = (POOL_SLAB_FREE *) ((UINT8 *) Slab + SIZE_OF_POOL_SLAB + (Index - 1) * Size);
+      Free->Signature = POOL_SLAB_FREE_SIGNATURE;
+      Free->Next      = Slab->FreeList;
+      Slab->FreeList  = Free;
+    }
+
+    InsertHeadList (&Cache->PartialList, &Slab->Link);
+    Cache->SlabCount++;
+    Cache->SlabPages += Pages;
+    Cache->Capacity  += Slab->Total;
+  }
+
+  Slab = CR (Cache->PartialList.ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  Free = Slab->FreeList;
+  ASSERT (Free->Signature == POOL_SLAB_FREE_SIGNATURE);
+  Slab->FreeList = Free->Next;
+  Slab->InUse++;
+  if (Slab->FreeList == NULL) {
+    //
+    // The slab is full, so it is only found again through its entries
+    //
+    RemoveEntryList (&Slab->Link);
+  }
+
+  ((POOL_HEAD *) Free)->Reserved = (UINT32) ((UINTN) Free - (UINTN) Slab);
+  return (POOL_HEAD *) Free;
+}
+
+/**
+  Internal function.  Returns the pages of an empty slab to free memory.
+
+  @param  Pool                   The pool head of the memory type
+  @param  Cache                  The slab cache the slab belongs to
+  @param  Slab                   The slab to free
+
+**/
+STATIC
+VOID
+CoreFreePoolSlab (
+  IN POOL             *Pool,
+  IN POOL_SLAB_CACHE  *Cache,
+  IN POOL_SLAB        *Slab
+  )
+{
+  ASSERT (Slab->InUse == 0);
+
+  RemoveEntryList (&Slab->Link);
+  Slab->Signature = 0;
+  Cache->SlabCount--;
+  Cache->SlabPages -= Slab->Pages;
+  Cache->Capacity  -= Slab->Total;
+  Cache->SlabsReclaimed++;
+  CoreFreePoolPagesI (Pool->MemoryType, (EFI_PHYSICAL_ADDRESS) (UINTN) Slab, Slab->Pages);
+}
+
+/**
+  Internal function.  Returns an entry to the slab it was carved from, and
+  returns the pages of the slab to free memory if no entry of the slab is in
+  use any more and the class has other slabs to allocate from.
+
+  @param  Pool                   The pool head of the memory type
+  @param  Head                   The pool head of the entry
+
+**/
+STATIC
+VOID
+CoreReturnPoolSlabEntry (
+  IN POOL             *Pool,
+  IN POOL_HEAD        *Head
+  )
+{
+  POOL_SLAB_CACHE   *Cache;
+  POOL_SLAB         *Slab;
+  POOL_SLAB_FREE    *Free;
+
+  Slab  = (POOL_SLAB *) ((UINTN) Head - Head->Reserved);
+  ASSERT (Slab->Signature == POOL_SLAB_SIGNATURE);
+  Cache = &Pool->SlabCache[Slab->Class];
+
+  Free            = (POOL_SLAB_FREE *) Head;
+  Free->Signature = POOL_SLAB_FREE_SIGNATURE;
+  Free->Next      = Slab->FreeList;
+  if (Slab->FreeList == NULL) {
+    InsertHeadList (&Cache->PartialList, &Slab->Link);
+  }
+  Slab->FreeList = Free;
+  Slab->InUse--;
+
+  //
+  // Keep the last partially used slab of the class even if it is empty, so
+  // a class that is used lightly does not allocate and free pages each time
+  //
+  if (Slab->InUse == 0 &&
+      (Cache->PartialList.ForwardLink != &Slab->Link ||
+       Cache->PartialList.BackLink != &Slab->Link)) {
+    CoreFreePoolSlab (Pool, Cache, Slab);
+  }
+}
+
+/**
+  Internal function.  Frees an entry allocated from a slab, keeping it in
+  the magazine of its class if there is room.
+
+  @param  Pool                   The pool head of the memory type
+  @param  Head                   The pool head of the entry
+
+**/
+STATIC
+VOID
+CoreFreePoolSlabEntry (
+  IN POOL             *Pool,
+  IN POOL_HEAD        *Head
+  )
+{
+  POOL_SLAB_CACHE   *Cache;
+  POOL_SLAB         *Slab;
+
+  Slab  = (POOL_SLAB *) ((UINTN) Head - Head->Reserved);
+  ASSERT (Slab->Signature == POOL_SLAB_SIGNATURE);
+  Cache = &Pool->SlabCache[Slab->Class];
+
+  Cache->InUse--;
+  Cache->RequestedBytes -= Head->Size;
+
+  if (Cache->MagazineCount < SLAB_MAGAZINE_SIZE) {
+    Head->Signature = POOL_SLAB_FREE_SIGNATURE;
+    Cache->Magazine[Cache->MagazineCount++] = Head;
+    return;
+  }
+
+  CoreReturnPoolSlabEntry (Pool, Head);
+}
+
+/**
+  Internal function.  Empties the magazines of a pool head back into its
+  slabs, and frees every slab and the slab caches themselves. Called when
+  no entry of the memory type is in use any more.
+
+  @param  Pool                   The pool head of the memory type
+
+**/
+STATIC
+VOID
+CoreReleasePoolSlabs (
+  IN POOL             *Pool
+  )
+{
+  POOL_SLAB_CACHE   *Cache;
+  POOL_SLAB         *Slab;
+  LIST_ENTRY        *Link;
+  UINTN             Class;
+
+  if (Pool->SlabCache == NULL) {
+    return;
+  }
+
+  for (Class = 0; Class < MAX_SLAB_CLASS; Class++) {
+    Cache = &Pool->SlabCache[Class];
+    while (Cache->MagazineCount > 0) {
+      CoreReturnPoolSlabEntry (Pool, Cache->Magazine[--Cache->MagazineCount]);
+    }
+
+    for (Link = Cache->PartialList.ForwardLink; Link != &Cache->PartialList;) {
+      Slab = CR (Link, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+      Link = Link->ForwardLink;
+      if (Slab->InUse == 0) {
+        CoreFreePoolSlab (Pool, Cache, Slab);
+      }
+    }
+  }
+
+  CoreFreePoolPagesI (
+    EfiBootServicesData,
+    (EFI_PHYSICAL_ADDRESS) (UINTN) Pool->SlabCache,
+    EFI_SIZE_TO_PAGES (MAX_SLAB_CLASS * sizeof (POOL_SLAB_CACHE))
+    );
+  Pool->SlabCache = NULL;
+}
+
+/**
+  Dump the hit rate and fragmentation of each slab class when the slab
+  allocator is enabled.
+
+**/
+VOID
+CoreDumpPoolSlabStatistics (
+  VOID
+  )
+{
+  UINTN             Class;
+  UINTN             Type;
+  LIST_ENTRY        *Link;
+  POOL              *Pool;
+  POOL_SLAB_CACHE   *Cache;
+  UINT64            Allocations;
+  UINT64            MagazineHits;
+  UINT64            SlabsReclaimed;
+  UINT64            SlabCount;
+  UINT64            SlabBytes;
+  UINT64            Capacity;
+  UINT64            InUse;
+  UINT64            RequestedBytes;
+
+  if (!FeaturePcdGet (PcdPoolSlabAllocatorEnable)) {
+    return;
+  }
+
+  CoreAcquireLock (&mPoolMemoryLock);
+
+  DEBUG ((DEBUG_POOL, "Pool slab statistics:\n"));
+  DEBUG ((DEBUG_POOL, "  Size     Allocs  MagHit%%  Slabs  Reclaimed   InUse  Capacity  Waste%%\n"));
+  for (Class = 0; Class < MAX_SLAB_CLASS; Class++) {
+    Allocations    = 0;
+    MagazineHits   = 0;
+    SlabsReclaimed = 0;
+    SlabCount      = 0;
+    SlabBytes      = 0;
+    Capacity       = 0;
+    InUse          = 0;
+    RequestedBytes = 0;
+
+    Type = 0;
+    Link = mPoolHeadList.ForwardLink;
+    while (TRUE) {
+      if (Type < EfiMaxMemoryType) {
+        Pool = &mPoolHead[Type++];
+      } else if (Link != &mPoolHeadList) {
+        Pool = CR (Link, POOL, Link, POOL_SIGNATURE);
+        Link = Link->ForwardLink;
+      } else {
+        break;
+      }
+
+      if (Pool->SlabCache == NULL) {
+        continue;
+      }
+      Cache           = &Pool->SlabCache[Class];
+      Allocations    += Cache->Allocations;
+      MagazineHits   += Cache->MagazineHits;
+      SlabsReclaimed += Cache->SlabsReclaimed;
+      SlabCount      += Cache->SlabCount;
+      SlabBytes      += EFI_PAGES_TO_SIZE (Cache->SlabPages);
+      Capacity       += Cache->Capacity;
+      InUse          += Cache->InUse;
+      RequestedBytes += Cache->RequestedBytes;
+    }
+
+    if (Allocations == 0) {
+      continue;
+    }
+
+    //
+    // Waste is the part of the slab pages that does not hold requested
+    // bytes: the rounding up to the class size, the entries that are not
+    // in use, and the unused tail of each slab.
+    //
+    DEBUG ((
+      DEBUG_POOL,
+      "  %4d  %9ld  %7ld  %5ld  %9ld  %6ld  %8ld  %6ld\n",
+      (UINT32) SLAB_CLASS_TO_SIZE (Class),
+      Allocations,
+      DivU64x64Remainder (MultU64x32 (MagazineHits, 100), Allocations, NULL),
+      SlabCount,
+      SlabsReclaimed,
+      InUse,
+      Capacity,
+      (SlabBytes == 0) ? 0 : 100 - DivU64x64Remainder (MultU64x32 (RequestedBytes, 100), SlabBytes, NULL)
+      ));
+  }
+
+  CoreReleaseLock (&mPoolMemoryLock);
+}
+
 /**
   Internal function to allocate pool of a particular type.
   Caller must have the memory lock held
@@ -363,6 +851,7 @@ CoreAllocatePoolI (
   UINTN       Granularity;
   BOOLEAN     HasPoolTail;
   BOOLEAN     PageAsPool;
+  BOOLEAN     IsSlab;
 
   ASSERT_LOCKED (&mPoolMemoryLock);
 
@@ -391,14 +880,34 @@ CoreAllocatePoolI (
   //
   Size = ALIGN_VARIABLE (Size);
 
-  Size += POOL_OVERHEAD;
-  Index = SIZE_TO_LIST(Size);
   Pool = LookupPoolHead (PoolType);
   if (Pool== NULL) {
     return NULL;
   }
   Head = NULL;
 
+  //
+  // Serve small requests from the slabs, without a pool tail
+  //
+  IsSlab = (BOOLEAN) (FeaturePcdGet (PcdPoolSlabAllocatorEnable) &&
+                      !NeedGuard && !PageAsPool &&
+                      Size <= MAX_SLAB_SIZE - SIZE_OF_POOL_HEAD);
+  if (IsSlab && CoreCreatePoolSlabCaches (Pool)) {
+    HasPoolTail = FALSE;
+    Size += SIZE_OF_POOL_HEAD;
+    Index = SIZE_TO_SLAB_CLASS (Size);
+    Head = CoreAllocatePoolSlabEntry (Pool, Index, Granularity);
+    if (Head != NULL) {
+      Pool->SlabCache[Index].InUse++;
+      Pool->SlabCache[Index].RequestedBytes += Size;
+    }
+    goto Done;
+  }
+  IsSlab = FALSE;
+
+  Size += POOL_OVERHEAD;
+  Index = SIZE_TO_LIST(Size);
+
   //
   // If allocation is over max size, just allocate pages for the request
   // (slow)
@@ -495,7 +1004,11 @@ Done:
     //
     // If we have a pool buffer, fill in the header & tail info
     //
-    Head->Signature = (PageAsPool) ? POOLPAGE_HEAD_SIGNATURE : POOL_HEAD_SIGNATURE;
+    if (IsSlab) {
+      Head->Signature = POOLSLAB_HEAD_SIGNATURE;
+    } else {
+      Head->Signature = (PageAsPool) ? POOLPAGE_HEAD_SIGNATURE : POOL_HEAD_SIGNATURE;
+    }
     Head->Size      = Size;
     Head->Type      = (EFI_MEMORY_TYPE) PoolType;
     Buffer          = Head->Data;
@@ -587,6 +1100,13 @@ CoreFreePool (
       Buffer,
       NULL
       );
+    CoreRecordAllocationTrace (
+      (EFI_PHYSICAL_ADDRESS) (UINTN) RETURN_ADDRESS (0),
+      MemoryAllocationTraceActionFreePool,
+      PoolType,
+      0,
+      Buffer
+      );
     InstallMemoryAttributesTableOnMemoryAllocation (PoolType);
   }
   return Status;
@@ -684,6 +1204,7 @@ CoreFreePoolI (
   BOOLEAN     IsGuarded;
   BOOLEAN     HasPoolTail;
   BOOLEAN     PageAsPool;
+  BOOLEAN     IsSlab;
 
   ASSERT(Buffer != NULL);
   //
@@ -693,15 +1214,20 @@ CoreFreePoolI (
   ASSERT(Head != NULL);
 
   if (Head->Signature != POOL_HEAD_SIGNATURE &&
-      Head->Signature != POOLPAGE_HEAD_SIGNATURE) {
+      Head->Signature != POOLPAGE_HEAD_SIGNATURE &&
+      Head->Signature != POOLSLAB_HEAD_SIGNATURE) {
     ASSERT (Head->Signature == POOL_HEAD_SIGNATURE ||
-            Head->Signature == POOLPAGE_HEAD_SIGNATURE);
+            Head->Signature == POOLPAGE_HEAD_SIGNATURE ||
+            Head->Signature == POOLSLAB_HEAD_SIGNATURE);
     return EFI_INVALID_PARAMETER;
   }
 
-  IsGuarded   = IsPoolTypeToGuard (Head->Type) &&
+  IsSlab      = (BOOLEAN) (Head->Signature == POOLSLAB_HEAD_SIGNATURE);
+  IsGuarded   = !IsSlab &&
+                IsPoolTypeToGuard (Head->Type) &&
                 IsMemoryGuarded ((EFI_PHYSICAL_ADDRESS)(UINTN)Head);
-  HasPoolTail = !(IsGuarded &&
+  HasPoolTail = !IsSlab &&
+                !(IsGuarded &&
                   ((PcdGet8 (PcdHeapGuardPropertyMask) & BIT7) == 0));
   PageAsPool = (Head->Signature == POOLPAGE_HEAD_SIGNATURE);
 
@@ -735,7 +1261,13 @@ CoreFreePoolI (
     return EFI_INVALID_PARAMETER;
   }
   Pool->Used -= Size;
-  DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) %,ld\n", Head->Data, (UINT64)(Head->Size - POOL_OVERHEAD), (UINT64) Pool->Used));
+  DEBUG ((
+    DEBUG_POOL,
+    "FreePool: %p (len %lx) %,ld\n",
+    Head->Data,
+    (UINT64)(Head->Size - (HasPoolTail ? POOL_OVERHEAD : SIZE_OF_POOL_HEAD)),
+    (UINT64) Pool->Used
+    ));
 
   if  (Head->Type == EfiACPIReclaimMemory   ||
        Head->Type == EfiACPIMemoryNVS       ||
@@ -755,14 +1287,19 @@ CoreFreePoolI (
   // Determine the pool list
   //
   Index = SIZE_TO_LIST(Size);
-  DEBUG_CLEAR_MEMORY (Head, Size);
 
-  //
-  // If it's not on the list, it must be pool pages
-  //
-  if (Index >= SIZE_TO_LIST (Granularity) || IsGuarded || PageAsPool) {
+  if (IsSlab) {
+    //
+    // Keep the head intact, it locates the slab of the entry
+    //
+    DEBUG_CLEAR_MEMORY (Head->Data, Size - SIZE_OF_POOL_HEAD);
+    CoreFreePoolSlabEntry (Pool, Head);
+
+  } else if (Index >= SIZE_TO_LIST (Granularity) || IsGuarded || PageAsPool) {
+    DEBUG_CLEAR_MEMORY (Head, Size);
 
     //
+    // If it's not on the list, it must be pool pages.
     // Return the memory pages back to free memory
     //
     NoPages = EFI_SIZE_TO_PAGES (Size) + EFI_SIZE_TO_PAGES (Granularity) - 1;
@@ -783,6 +1320,7 @@ CoreFreePoolI (
     }
 
   } else {
+    DEBUG_CLEAR_MEMORY (Head, Size);
 
     //
     // Put the pool entry onto the free pool list
@@ -848,6 +1386,7 @@ CoreFreePoolI (
   // list entry for that memory type
   //
   if (((UINT32) Pool->MemoryType >= MEMORY_TYPE_OEM_RESERVED_MIN) && Pool->Used == 0) {
+    CoreReleasePoolSlabs (Pool);
     RemoveEntryList (&Pool->Link);
     CoreFreePoolI (Pool, NULL);
   }
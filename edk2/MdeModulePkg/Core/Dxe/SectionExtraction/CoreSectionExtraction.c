@@ -27,6 +27,11 @@
   3) A support protocol is not found, and the data is not available to be read
      without it.  This results in EFI_PROTOCOL_ERROR.
 
+  The streams produced by decompressing or extracting encapsulation sections
+  are kept as a cache. When PcdSectionStreamCacheSize is not zero, the least
+  recently used of them are freed once their total size exceeds it, and are
+  produced again on demand.
+
 Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
@@ -65,6 +70,16 @@ typedef struct {
   // when the required GUIDed extraction protocol becomes available.
   //
   EFI_EVENT                   Event;
+  //
+  // Link in mSectionCacheLru and the size of the encapsulated stream if the
+  // stream was produced by decompressing or extracting the section.
+  //
+  LIST_ENTRY                  CacheLink;
+  UINTN                       CacheSize;
+  //
+  // TRUE if the encapsulated stream was freed by CoreTrimSectionCache().
+  //
+  BOOLEAN                     Evicted;
 } CORE_SECTION_CHILD_NODE;
 
 #define CORE_SECTION_STREAM_SIGNATURE SIGNATURE_32('S','X','S','S')
@@ -191,6 +206,16 @@ CustomGuidedSectionExtract (
 //
 LIST_ENTRY mStreamRoot = INITIALIZE_LIST_HEAD_VARIABLE (mStreamRoot);
 
+//
+// Child nodes whose encapsulated stream is held in memory, least recently used
+// first, the total size of their streams, and the cache statistics
+//
+LIST_ENTRY mSectionCacheLru = INITIALIZE_LIST_HEAD_VARIABLE (mSectionCacheLru);
+UINTN      mSectionCacheSize = 0;
+UINT64     mSectionCacheHits = 0;
+UINT64     mSectionCacheMisses = 0;
+UINT64     mSectionCacheEvictions = 0;
+
 EFI_HANDLE mSectionExtractionHandle = NULL;
 
 EFI_GUIDED_SECTION_EXTRACTION_PROTOCOL mCustomGuidedSectionExtractionProtocol = {
@@ -642,31 +667,124 @@ CreateGuidedExtractionRpnEvent (
 }
 
 /**
-  Worker function.  Constructor for new child nodes.
+  Worker function.  Add a child node whose encapsulated stream has just been
+  produced to the section stream cache, as the most recently used one.
 
-  @param  Stream                 Indicates the section stream in which to add the
-                                 child.
-  @param  ChildOffset            Indicates the offset in Stream that is the
-                                 beginning of the child section.
-  @param  ChildNode              Indicates the Callee allocated and initialized
+  @param  Node                   Indicates the child node.
+
+**/
+VOID
+CoreInsertSectionCacheNode (
+  IN  CORE_SECTION_CHILD_NODE                   *Node
+  )
+{
+  Node->CacheSize = ((CORE_SECTION_STREAM_NODE *) Node->EncapsulatedStreamHandle)->StreamLength;
+  InsertTailList (&mSectionCacheLru, &Node->CacheLink);
+  mSectionCacheSize += Node->CacheSize;
+  mSectionCacheMisses++;
+}
+
+
+/**
+  Worker function.  Remove a child node from the section stream cache.
+
+  @param  Node                   Indicates the child node.
+
+**/
+VOID
+CoreRemoveSectionCacheNode (
+  IN  CORE_SECTION_CHILD_NODE                   *Node
+  )
+{
+  if (Node->CacheLink.ForwardLink != NULL) {
+    RemoveEntryList (&Node->CacheLink);
+    Node->CacheLink.ForwardLink = NULL;
+    mSectionCacheSize -= Node->CacheSize;
+  }
+}
+
+
+/**
+  Worker function.  Free the least recently used encapsulated streams until
+  the section stream cache fits in PcdSectionStreamCacheSize. The most
+  recently used stream is always kept.
+
+  No pointer into a cached stream may be held when this function is called.
+
+**/
+VOID
+CoreTrimSectionCache (
+  VOID
+  )
+{
+  UINTN                    Budget;
+  CORE_SECTION_CHILD_NODE  *Node;
+
+  Budget = PcdGet32 (PcdSectionStreamCacheSize);
+  if (Budget == 0) {
+    return;
+  }
+
+  while (mSectionCacheSize > Budget &&
+         !IsListEmpty (&mSectionCacheLru) &&
+         !IsNodeAtEnd (&mSectionCacheLru, GetFirstNode (&mSectionCacheLru))) {
+    Node = CR (GetFirstNode (&mSectionCacheLru), CORE_SECTION_CHILD_NODE, CacheLink, CORE_SECTION_CHILD_SIGNATURE);
+    CoreRemoveSectionCacheNode (Node);
+
+    //
+    // Closing the stream also frees the cached streams nested in it
+    //
+    CloseSectionStream (Node->EncapsulatedStreamHandle, TRUE);
+    Node->EncapsulatedStreamHandle = NULL_STREAM_HANDLE;
+    Node->Evicted = TRUE;
+    mSectionCacheEvictions++;
+  }
+}
+
+
+/**
+  Dump the section stream cache statistics.
+
+**/
+VOID
+CoreDumpSectionCacheStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_LOAD,
+    "Section stream cache: %ld hits, %ld misses, %ld evictions, %ld bytes in use\n",
+    mSectionCacheHits,
+    mSectionCacheMisses,
+    mSectionCacheEvictions,
+    (UINT64) mSectionCacheSize
+    ));
+}
+
+
+/**
+  Worker function.  Produce the section stream encapsulated by a child node
+  by decompressing or extracting the section.
+
+  @param  Stream                 Indicates the section stream that contains the
                                  child.
+  @param  Node                   Indicates the child node. Nothing is done if
+                                 it is not an encapsulating section.
 
-  @retval EFI_SUCCESS            Child node was found and returned.
-                                 EFI_OUT_OF_RESOURCES- Memory allocation failed.
-  @retval EFI_PROTOCOL_ERROR     Encapsulation sections produce new stream
-                                 handles when the child node is created.  If the
-                                 section type is GUID defined, and the extraction
-                                 GUID does not exist, and producing the stream
-                                 requires the GUID, then a protocol error is
-                                 generated and no child is produced. Values
-                                 returned by OpenSectionStreamEx.
+  @retval EFI_SUCCESS            The encapsulated stream was produced, or will
+                                 be produced when the required GUIDed section
+                                 extraction protocol is installed.
+  @retval EFI_OUT_OF_RESOURCES   Memory allocation failed.
+  @retval EFI_PROTOCOL_ERROR     The GUIDed section extraction protocol failed
+                                 to extract the section.
+  @retval Others                 Values returned by the decompress protocol or
+                                 OpenSectionStreamEx.
 
 **/
 EFI_STATUS
-CreateChildNode (
+CreateEncapsulatedStream (
   IN     CORE_SECTION_STREAM_NODE              *Stream,
-  IN     UINT32                                ChildOffset,
-  OUT    CORE_SECTION_CHILD_NODE               **ChildNode
+  IN     CORE_SECTION_CHILD_NODE               *Node
   )
 {
   EFI_STATUS                                   Status;
@@ -686,43 +804,14 @@ CreateChildNode (
   UINT8                                        CompressionType;
   UINT16                                       GuidedSectionAttributes;
 
-  CORE_SECTION_CHILD_NODE                      *Node;
-
-  SectionHeader = (EFI_COMMON_SECTION_HEADER *) (Stream->StreamBuffer + ChildOffset);
+  SectionHeader = (EFI_COMMON_SECTION_HEADER *) (Stream->StreamBuffer + Node->OffsetInStream);
 
-  //
-  // Allocate a new node
-  //
-  *ChildNode = AllocateZeroPool (sizeof (CORE_SECTION_CHILD_NODE));
-  Node = *ChildNode;
-  if (Node == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  //
-  // Now initialize it
-  //
-  Node->Signature = CORE_SECTION_CHILD_SIGNATURE;
-  Node->Type = SectionHeader->Type;
-  if (IS_SECTION2 (SectionHeader)) {
-    Node->Size = SECTION2_SIZE (SectionHeader);
-  } else {
-    Node->Size = SECTION_SIZE (SectionHeader);
-  }
-  Node->OffsetInStream = ChildOffset;
-  Node->EncapsulatedStreamHandle = NULL_STREAM_HANDLE;
-  Node->EncapsulationGuid = NULL;
-
-  //
-  // If it's an encapsulating section, then create the new section stream also
-  //
   switch (Node->Type) {
     case EFI_SECTION_COMPRESSION:
       //
       // Get the CompressionSectionHeader
       //
       if (Node->Size < sizeof (EFI_COMPRESSION_SECTION)) {
-        CoreFreePool (Node);
         return EFI_NOT_FOUND;
       }
 
@@ -747,7 +836,6 @@ CreateChildNode (
         NewStreamBufferSize = UncompressedLength;
         NewStreamBuffer = AllocatePool (NewStreamBufferSize);
         if (NewStreamBuffer == NULL) {
-          CoreFreePool (Node);
           return EFI_OUT_OF_RESOURCES;
         }
 
@@ -776,7 +864,6 @@ CreateChildNode (
                                  &ScratchSize
                                  );
           if (EFI_ERROR (Status) || (NewStreamBufferSize != UncompressedLength)) {
-            CoreFreePool (Node);
             CoreFreePool (NewStreamBuffer);
             if (!EFI_ERROR (Status)) {
               Status = EFI_BAD_BUFFER_SIZE;
@@ -786,7 +873,6 @@ CreateChildNode (
 
           ScratchBuffer = AllocatePool (ScratchSize);
           if (ScratchBuffer == NULL) {
-            CoreFreePool (Node);
             CoreFreePool (NewStreamBuffer);
             return EFI_OUT_OF_RESOURCES;
           }
@@ -802,7 +888,6 @@ CreateChildNode (
                                  );
           CoreFreePool (ScratchBuffer);
           if (EFI_ERROR (Status)) {
-            CoreFreePool (Node);
             CoreFreePool (NewStreamBuffer);
             return Status;
           }
@@ -820,7 +905,6 @@ CreateChildNode (
                  &Node->EncapsulatedStreamHandle
                  );
       if (EFI_ERROR (Status)) {
-        CoreFreePool (Node);
         CoreFreePool (NewStreamBuffer);
         return Status;
       }
@@ -848,7 +932,6 @@ CreateChildNode (
                                      &AuthenticationStatus
                                      );
         if (EFI_ERROR (Status)) {
-          CoreFreePool (*ChildNode);
           return EFI_PROTOCOL_ERROR;
         }
 
@@ -877,7 +960,6 @@ CreateChildNode (
                    &Node->EncapsulatedStreamHandle
                    );
         if (EFI_ERROR (Status)) {
-          CoreFreePool (*ChildNode);
           CoreFreePool (NewStreamBuffer);
           return Status;
         }
@@ -919,7 +1001,6 @@ CreateChildNode (
                        );
           }
           if (EFI_ERROR (Status)) {
-            CoreFreePool (Node);
             return Status;
           }
         }
@@ -935,6 +1016,80 @@ CreateChildNode (
       break;
   }
 
+  if (Node->EncapsulatedStreamHandle != NULL_STREAM_HANDLE) {
+    CoreInsertSectionCacheNode (Node);
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Worker function.  Constructor for new child nodes.
+
+  @param  Stream                 Indicates the section stream in which to add the
+                                 child.
+  @param  ChildOffset            Indicates the offset in Stream that is the
+                                 beginning of the child section.
+  @param  ChildNode              Indicates the Callee allocated and initialized
+                                 child.
+
+  @retval EFI_SUCCESS            Child node was found and returned.
+                                 EFI_OUT_OF_RESOURCES- Memory allocation failed.
+  @retval EFI_PROTOCOL_ERROR     Encapsulation sections produce new stream
+                                 handles when the child node is created.  If the
+                                 section type is GUID defined, and the extraction
+                                 GUID does not exist, and producing the stream
+                                 requires the GUID, then a protocol error is
+                                 generated and no child is produced. Values
+                                 returned by OpenSectionStreamEx.
+
+**/
+EFI_STATUS
+CreateChildNode (
+  IN     CORE_SECTION_STREAM_NODE              *Stream,
+  IN     UINT32                                ChildOffset,
+  OUT    CORE_SECTION_CHILD_NODE               **ChildNode
+  )
+{
+  EFI_STATUS                                   Status;
+  EFI_COMMON_SECTION_HEADER                    *SectionHeader;
+  CORE_SECTION_CHILD_NODE                      *Node;
+
+  SectionHeader = (EFI_COMMON_SECTION_HEADER *) (Stream->StreamBuffer + ChildOffset);
+
+  //
+  // Allocate a new node
+  //
+  *ChildNode = AllocateZeroPool (sizeof (CORE_SECTION_CHILD_NODE));
+  Node = *ChildNode;
+  if (Node == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Now initialize it
+  //
+  Node->Signature = CORE_SECTION_CHILD_SIGNATURE;
+  Node->Type = SectionHeader->Type;
+  if (IS_SECTION2 (SectionHeader)) {
+    Node->Size = SECTION2_SIZE (SectionHeader);
+  } else {
+    Node->Size = SECTION_SIZE (SectionHeader);
+  }
+  Node->OffsetInStream = ChildOffset;
+  Node->EncapsulatedStreamHandle = NULL_STREAM_HANDLE;
+  Node->EncapsulationGuid = NULL;
+
+  //
+  // If it's an encapsulating section, then create the new section stream also
+  //
+  Status = CreateEncapsulatedStream (Stream, Node);
+  if (EFI_ERROR (Status)) {
+    CoreFreePool (Node);
+    return Status;
+  }
+
   //
   // Last, add the new child node to the stream
   //
@@ -1037,6 +1192,19 @@ FindChildNode (
       }
     }
 
+    if (CurrentChildNode->Evicted) {
+      //
+      // The encapsulated stream was freed to keep the cache within its
+      // budget, so produce it again
+      //
+      Status = CreateEncapsulatedStream (SourceStream, CurrentChildNode);
+      if (!EFI_ERROR (Status)) {
+        CurrentChildNode->Evicted = FALSE;
+      }
+    } else if (CurrentChildNode->CacheLink.ForwardLink != NULL) {
+      mSectionCacheHits++;
+    }
+
     if (CurrentChildNode->EncapsulatedStreamHandle != NULL_STREAM_HANDLE) {
       //
       // If the current node is an encapsulating node, recurse into it...
@@ -1050,6 +1218,15 @@ FindChildNode (
                 &RecursedFoundStream,
                 AuthenticationStatus
                 );
+
+      //
+      // Mark the stream as most recently used once the streams nested in it
+      // have been, so that they are evicted before it
+      //
+      if (CurrentChildNode->CacheLink.ForwardLink != NULL) {
+        RemoveEntryList (&CurrentChildNode->CacheLink);
+        InsertTailList (&mSectionCacheLru, &CurrentChildNode->CacheLink);
+      }
       //
       // If the status is not EFI_SUCCESS, just save the error code and continue
       // to find the request child node in the rest stream.
@@ -1310,6 +1487,7 @@ GetSection (
   *BufferSize = SectionSize;
 
 GetSection_Done:
+  CoreTrimSectionCache ();
   CoreRestoreTpl (OldTpl);
 
   return Status;
@@ -1332,6 +1510,7 @@ FreeChildNode (
   // Remove the child from it's list
   //
   RemoveEntryList (&ChildNode->Link);
+  CoreRemoveSectionCacheNode (ChildNode);
 
   if (ChildNode->EncapsulatedStreamHandle != NULL_STREAM_HANDLE) {
     //
@@ -23,7 +23,34 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define LZMAF86_CUSTOM_DECOMPRESS_GUID  \
   { 0xD42AE6BD, 0x1352, 0x4bfb, { 0x90, 0x9A, 0xCA, 0x72, 0xA6, 0xEA, 0xE8, 0x89 } }
 
+///
+/// The Global ID used to identify a section of an FFS file of type
+/// EFI_SECTION_GUID_DEFINED, whose contents have been split into fixed size
+/// chunks that were compressed independently using LZMA. Each chunk can be
+/// decoded without reference to any other chunk.
+///
+#define LZMA_CHUNKED_CUSTOM_DECOMPRESS_GUID  \
+  { 0x68BDA24B, 0x71C2, 0x4303, { 0xB8, 0xF0, 0x7C, 0xFA, 0x41, 0xB6, 0xD6, 0x3B } }
+
+#define LZMA_CHUNKED_SIGNATURE  SIGNATURE_32 ('L', 'Z', 'C', 'K')
+
+///
+/// Header at the start of the data of a chunked LZMA GUIDed section. It is
+/// followed by ChunkCount UINT32 values holding the compressed size of each
+/// chunk, and then by the chunks themselves. Every chunk is a standard LZMA
+/// stream (properties and 64-bit decoded size followed by the encoded data)
+/// that decodes to ChunkSize bytes, except the last one which holds the
+/// remainder of DecodedSize.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    ChunkSize;
+  UINT32    ChunkCount;
+  UINT32    DecodedSize;
+} LZMA_CHUNKED_HEADER;
+
 extern GUID gLzmaCustomDecompressGuid;
 extern GUID gLzmaF86CustomDecompressGuid;
+extern GUID gLzmaChunkedCustomDecompressGuid;
 
 #endif
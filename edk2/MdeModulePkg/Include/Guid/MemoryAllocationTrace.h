@@ -0,0 +1,72 @@
+/** @file
+  Memory allocation trace data structure.
+
+  The DXE core may record every page and pool allocate/free in a fixed size
+  ring buffer, published as a configuration table with the GUID defined here.
+  Unlike the memory profile, no per-allocation bookkeeping is kept: each event
+  is written once into the next ring slot and the ring is decoded off-line.
+
+  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _MEMORY_ALLOCATION_TRACE_H_
+#define _MEMORY_ALLOCATION_TRACE_H_
+
+#define MEMORY_ALLOCATION_TRACE_SIGNATURE SIGNATURE_32 ('M','A','T','R')
+#define MEMORY_ALLOCATION_TRACE_REVISION  0x0001
+
+typedef enum {
+  MemoryAllocationTraceActionAllocatePages = 1,
+  MemoryAllocationTraceActionFreePages     = 2,
+  MemoryAllocationTraceActionAllocatePool  = 3,
+  MemoryAllocationTraceActionFreePool      = 4,
+  MemoryAllocationTraceActionImageStart    = 5,
+  MemoryAllocationTraceActionImageUnload   = 6
+} MEMORY_ALLOCATION_TRACE_ACTION;
+
+typedef struct {
+  UINT32                        Signature;
+  UINT32                        Length;         // Header and ring, in bytes.
+  UINT16                        Revision;
+  UINT16                        EntrySize;
+  UINT32                        EntryCount;     // Power of two.
+  //
+  // Sequence number of the next event. The event with sequence number S is
+  // stored in entry (S - 1) & (EntryCount - 1); 0 marks an unused entry.
+  //
+  UINT64                        NextSequence;
+  UINT64                        TimerFrequency; // Hz.
+  UINT64                        TimerStart;
+  UINT64                        TimerEnd;
+} MEMORY_ALLOCATION_TRACE_HEADER;
+
+typedef struct {
+  //
+  // Written last, so an entry whose Sequence does not match its slot is
+  // being overwritten and must be ignored.
+  //
+  UINT64                        Sequence;
+  UINT8                         Action;         // MEMORY_ALLOCATION_TRACE_ACTION.
+  UINT8                         Tpl;
+  UINT16                        Reserved;
+  UINT32                        MemoryType;
+  UINT64                        TimeStamp;      // Performance counter value.
+  PHYSICAL_ADDRESS              Buffer;
+  UINT64                        Size;           // Bytes for pool, pages for page and image events.
+  PHYSICAL_ADDRESS              CallerAddress;
+  //
+  // Image events only: FFS file name of the image. Buffer and Size
+  // describe the image so that callers can be attributed to it.
+  //
+  EFI_GUID                      FileName;
+} MEMORY_ALLOCATION_TRACE_ENTRY;
+
+#define EDKII_MEMORY_ALLOCATION_TRACE_GUID { \
+  0x05762c31, 0x8a50, 0x4c95, { 0x83, 0xf5, 0x27, 0x8a, 0xde, 0xb2, 0x27, 0x9f } \
+}
+
+extern EFI_GUID gEdkiiMemoryAllocationTraceGuid;
+
+#endif
@@ -9,6 +9,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _SMM_VARIABLE_COMMON_H_
 #define _SMM_VARIABLE_COMMON_H_
 
+#include <Guid/VariableFormat.h>
 #include <Protocol/VarCheck.h>
 
 #define EFI_SMM_VARIABLE_WRITE_GUID \
@@ -67,6 +68,21 @@ typedef struct {
 
 #define SMM_VARIABLE_FUNCTION_GET_PAYLOAD_SIZE        11
 
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO.
+//
+#define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO  12
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_RUNTIME_CACHE_CONTEXT.
+// It is only accepted before the end of DXE.
+//
+#define SMM_VARIABLE_FUNCTION_INIT_RUNTIME_CACHE      13
+//
+// No extra payload for this function. It copies the updates that were deferred
+// while the runtime cache was being read.
+//
+#define SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE      14
+
 ///
 /// Size of SMM communicate header, without including the payload.
 ///
@@ -120,4 +136,34 @@ typedef struct {
   UINTN                         VariablePayloadSize;
 } SMM_VARIABLE_COMMUNICATE_GET_PAYLOAD_SIZE;
 
+///
+/// This structure is used to communicate with SMI handler by GetRuntimeCacheInfo.
+///
+typedef struct {
+  UINTN                         HobStoreSize;       // 0 if there is no HOB variable store.
+  UINTN                         NvStoreSize;
+  UINTN                         VolatileStoreSize;
+  BOOLEAN                       AuthFormat;         // The stores use AUTHENTICATED_VARIABLE_HEADER.
+} SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO;
+
+///
+/// Flags shared by the variable runtime cache reader and the SMM variable driver.
+///
+typedef struct {
+  BOOLEAN                       ReadLock;           // Set while the runtime cache is being read.
+  BOOLEAN                       PendingUpdate;      // An update was deferred because of ReadLock.
+  BOOLEAN                       HobFlushComplete;   // The HOB variable store is no longer used.
+} SMM_VARIABLE_RUNTIME_CACHE_CONTROL;
+
+///
+/// This structure is used to communicate with SMI handler by InitRuntimeCache.
+/// Every store buffer is as large as reported by GetRuntimeCacheInfo.
+///
+typedef struct {
+  SMM_VARIABLE_RUNTIME_CACHE_CONTROL  *Control;
+  VARIABLE_STORE_HEADER               *HobStore;    // NULL if there is no HOB variable store.
+  VARIABLE_STORE_HEADER               *NvStore;
+  VARIABLE_STORE_HEADER               *VolatileStore;
+} SMM_VARIABLE_COMMUNICATE_RUNTIME_CACHE_CONTEXT;
+
 #endif // _SMM_VARIABLE_COMMON_H_
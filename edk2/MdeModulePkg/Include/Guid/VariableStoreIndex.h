@@ -0,0 +1,72 @@
+/** @file
+  The variable store index is related to EDK II-specific implementation of UEFI variables.
+
+  The PEI variable driver walks the NV variable store once, on its first access
+  to it, and publishes the index of all the variables in the store in a GUID HOB.
+  The PEI lookups after that only compare the hashes of the index instead of
+  walking the store, and the DXE variable driver initializes from the index
+  instead of walking the store again, as long as the index still matches the
+  store it reads.
+
+  The index covers the whole store or nothing: a store that cannot be indexed
+  has an index HOB with StoreSize 0 and no entries, so that it is not walked
+  again to try to build it.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __VARIABLE_STORE_INDEX_H__
+#define __VARIABLE_STORE_INDEX_H__
+
+#define EDKII_VARIABLE_STORE_INDEX_GUID \
+  { 0xaa8471ad, 0xf0d7, 0x4720, { 0xb9, 0x8e, 0x0b, 0x51, 0xc7, 0xfe, 0x0b, 0x12 } }
+
+#define VARIABLE_STORE_INDEX_SIGNATURE  SIGNATURE_32 ('V', 'S', 'I', 'X')
+
+///
+/// Index of the NV variable store, followed by EntryCount VARIABLE_STORE_INDEX_ENTRY.
+/// All offsets are from the variable store header.
+///
+typedef struct {
+  UINT32      Signature;
+  ///
+  /// Size and Signature of the variable store header of the indexed store.
+  ///
+  UINT32      StoreSize;
+  EFI_GUID    StoreSignature;
+  ///
+  /// Offset of the last variable header in the store, whatever its state,
+  /// or 0 if the store has no variable.
+  ///
+  UINT32      LastOffset;
+  ///
+  /// Offset of the end of the last variable, where the next one is added.
+  ///
+  UINT32      EndOffset;
+  ///
+  /// Total size of the hardware error record variables and of the other
+  /// variables, with the same accounting as the DXE variable driver.
+  ///
+  UINT32      HwErrVariableTotalSize;
+  UINT32      CommonVariableTotalSize;
+  UINT32      EntryCount;
+  UINT32      Reserved;
+} VARIABLE_STORE_INDEX;
+
+///
+/// One VAR_ADDED or IN_DELETED_TRANSITION variable, in the order of the store.
+///
+typedef struct {
+  ///
+  /// 32-bit FNV-1a hash of the vendor GUID followed by the name of the
+  /// variable, including its null terminator.
+  ///
+  UINT32      Hash;
+  UINT32      Offset;
+} VARIABLE_STORE_INDEX_ENTRY;
+
+extern EFI_GUID gEdkiiVariableStoreIndexGuid;
+
+#endif // __VARIABLE_STORE_INDEX_H__
@@ -0,0 +1,96 @@
+/** @file
+  Fault Tolerant Write Batch protocol is related to EDK II-specific implementation
+  of FTW. It extends the Fault Tolerant Write protocol with a service that applies
+  several writes to the same or adjacent target blocks with a single update of the
+  spare block, instead of one spare block update per write.
+
+  The SMM instance has the same structure and is installed in the SMM protocol
+  database by the SMM FTW driver.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FAULT_TOLERANT_WRITE_BATCH_H__
+#define __FAULT_TOLERANT_WRITE_BATCH_H__
+
+#include <Protocol/FaultTolerantWrite.h>
+
+#define EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL_GUID \
+  { \
+    0x1b490b99, 0xd9fb, 0x431a, { 0x83, 0x61, 0xf9, 0xea, 0xac, 0xb0, 0xd5, 0x30 } \
+  }
+
+#define EDKII_SMM_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL_GUID \
+  { \
+    0xe8ad9e6b, 0xd380, 0x43cb, { 0x87, 0xf5, 0x12, 0x40, 0x34, 0x95, 0x8f, 0x90 } \
+  }
+
+typedef struct _EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL;
+
+///
+/// One write of a batch.
+///
+typedef struct {
+  EFI_LBA     Lba;      ///< The logical block address of the target block.
+  UINTN       Offset;   ///< The offset within the target block to place the data.
+  UINTN       Length;   ///< The number of bytes to write to the target block.
+  VOID        *Buffer;  ///< The data to write.
+} EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY;
+
+/**
+  Starts a target block update of several writes. The writes are recorded as
+  one write of the fault tolerant storage, and are completed in a recoverable
+  manner, ensuring at all times that either the original contents or all the
+  modified contents are available.
+
+  The blocks from the first to the last block written are updated together,
+  so all of them must fit within the spare block. Writes are applied in order,
+  a later write overrides an earlier one where they overlap.
+
+  Like EFI_FAULT_TOLERANT_WRITE_PROTOCOL.Write(), the batch uses one of the
+  writes allocated with EFI_FAULT_TOLERANT_WRITE_PROTOCOL.Allocate(), and one
+  is allocated if no write has been allocated and PrivateData is NULL.
+
+  @param[in] This           The pointer to this protocol instance.
+  @param[in] FvBlockHandle  The handle of FVB protocol that provides services for
+                            reading, writing, and erasing the target blocks.
+  @param[in] PrivateData    A pointer to private data that the caller requires to
+                            complete any pending writes in the event of a fault.
+  @param[in] EntryCount     The number of entries in Entries.
+  @param[in] Entries        The writes to do.
+
+  @retval EFI_SUCCESS           The function completed successfully.
+  @retval EFI_INVALID_PARAMETER EntryCount is 0, or Entries is NULL.
+  @retval EFI_ABORTED           The function could not complete successfully.
+  @retval EFI_BAD_BUFFER_SIZE   The target blocks can't fit within the spare block.
+  @retval EFI_ACCESS_DENIED     No writes have been allocated.
+  @retval EFI_OUT_OF_RESOURCES  Cannot allocate enough memory resource.
+  @retval EFI_NOT_FOUND         Cannot find FVB protocol by handle.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI * EDKII_FAULT_TOLERANT_WRITE_BATCH_WRITE)(
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN VOID                                       *PrivateData,
+  IN UINTN                                      EntryCount,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Entries
+  );
+
+///
+/// Fault Tolerant Write Batch protocol, the batch service of an
+/// EFI_FAULT_TOLERANT_WRITE_PROTOCOL instance.
+///
+struct _EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL {
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_WRITE  Write;
+};
+
+typedef EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL EDKII_SMM_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL;
+
+extern EFI_GUID gEdkiiFaultTolerantWriteBatchProtocolGuid;
+extern EFI_GUID gEdkiiSmmFaultTolerantWriteBatchProtocolGuid;
+
+#endif
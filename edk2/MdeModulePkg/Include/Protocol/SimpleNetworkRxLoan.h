@@ -0,0 +1,94 @@
+/** @file
+  Simple Network Receive Loan protocol is related to EDK II-specific implementation
+  of the network stack. It is installed by a Simple Network Protocol driver on the
+  handle of its EFI_SIMPLE_NETWORK_PROTOCOL instance, and lends the receive buffers
+  of the network interface to the caller instead of copying the received packets
+  into a buffer of the caller as EFI_SIMPLE_NETWORK_PROTOCOL.Receive() does.
+
+  A lent buffer is not available to the network interface to receive packets until
+  it is recycled. It stays valid until it is recycled, even if the network interface
+  is shut down in between.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __SIMPLE_NETWORK_RX_LOAN_H__
+#define __SIMPLE_NETWORK_RX_LOAN_H__
+
+#define EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL_GUID \
+  { \
+    0xf3f11d5d, 0xdcde, 0x4f7c, { 0xa0, 0x2d, 0x7b, 0x1c, 0x62, 0x9e, 0xea, 0xeb } \
+  }
+
+typedef struct _EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL  EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL;
+
+/**
+  Receives a packet from the network interface, in a buffer lent by the network
+  interface. The buffer must be given back with Recycle().
+
+  The same rules as EFI_SIMPLE_NETWORK_PROTOCOL.Receive() apply: the network
+  interface must be initialized, and the function must be called at TPL_CALLBACK
+  or below.
+
+  @param[in]  This              The pointer to this protocol instance.
+  @param[out] HeaderSize        The size, in bytes, of the media header received
+                                on the network interface.
+  @param[out] BufferSize        The size, in bytes, of the packet received on the
+                                network interface, media header included.
+  @param[out] Buffer            The lent buffer that holds both the media header
+                                and the data. The caller may modify the packet in it.
+  @param[out] Token             The token to give to Recycle() to return the buffer.
+
+  @retval EFI_SUCCESS           A packet was received in the lent buffer.
+  @retval EFI_NOT_STARTED       The network interface has not been started.
+  @retval EFI_NOT_READY         No packet has been received on the network interface.
+  @retval EFI_OUT_OF_RESOURCES  MaxLoans buffers are lent already. The packets can
+                                still be received with EFI_SIMPLE_NETWORK_PROTOCOL.Receive().
+  @retval EFI_INVALID_PARAMETER One or more of the parameters is NULL.
+  @retval EFI_DEVICE_ERROR      The command could not be sent to the network interface.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_SIMPLE_NETWORK_RX_LOAN_RECEIVE)(
+  IN  EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL  *This,
+  OUT UINTN                                  *HeaderSize,
+  OUT UINTN                                  *BufferSize,
+  OUT VOID                                   **Buffer,
+  OUT VOID                                   **Token
+  );
+
+/**
+  Gives back to the network interface a buffer lent by Receive().
+
+  The function may be called at TPL_NOTIFY or below.
+
+  @param[in]  This              The pointer to this protocol instance.
+  @param[in]  Token             The token returned by Receive() with the buffer.
+
+**/
+typedef
+VOID
+(EFIAPI *EDKII_SIMPLE_NETWORK_RX_LOAN_RECYCLE)(
+  IN EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL  *This,
+  IN VOID                                   *Token
+  );
+
+///
+/// Simple Network Receive Loan protocol.
+///
+struct _EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL {
+  EDKII_SIMPLE_NETWORK_RX_LOAN_RECEIVE  Receive;
+  EDKII_SIMPLE_NETWORK_RX_LOAN_RECYCLE  Recycle;
+  ///
+  /// The maximum number of buffers lent at the same time. The network interface
+  /// keeps enough buffers to receive packets when all of them are lent.
+  ///
+  UINTN                                 MaxLoans;
+};
+
+extern EFI_GUID gEdkiiSimpleNetworkRxLoanProtocolGuid;
+
+#endif
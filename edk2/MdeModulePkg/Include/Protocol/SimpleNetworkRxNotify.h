@@ -0,0 +1,61 @@
+/** @file
+  Simple Network Receive Notify protocol is related to EDK II-specific implementation
+  of the network stack. It is installed by a Simple Network Protocol driver on the
+  handle of its EFI_SIMPLE_NETWORK_PROTOCOL instance, when the network interface can
+  tell when packets are received, for example from its receive interrupt.
+
+  The consumer of EFI_SIMPLE_NETWORK_PROTOCOL registers an event that the driver
+  signals when packets are received, so that it receives them as soon as they are
+  available instead of polling the network interface periodically.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __SIMPLE_NETWORK_RX_NOTIFY_H__
+#define __SIMPLE_NETWORK_RX_NOTIFY_H__
+
+#define EDKII_SIMPLE_NETWORK_RX_NOTIFY_PROTOCOL_GUID \
+  { \
+    0x5b1f8d3c, 0x2a64, 0x4e0b, { 0x9c, 0x71, 0x3e, 0xd8, 0x0f, 0x46, 0xa2, 0x95 } \
+  }
+
+typedef struct _EDKII_SIMPLE_NETWORK_RX_NOTIFY_PROTOCOL  EDKII_SIMPLE_NETWORK_RX_NOTIFY_PROTOCOL;
+
+/**
+  Registers the event to signal when packets are received on the network interface.
+
+  The driver signals the event, at any TPL up to TPL_NOTIFY, when packets become
+  available to EFI_SIMPLE_NETWORK_PROTOCOL.Receive() after it was signaled last.
+  The event may be signaled while no packet is available, and the consumer must
+  receive all the packets available when it is signaled. It is not signaled while
+  the network interface is not initialized.
+
+  @param[in]  This              The pointer to this protocol instance.
+  @param[in]  Event             The event to signal, or NULL to unregister the
+                                event registered before.
+
+  @retval EFI_SUCCESS           The event is registered or unregistered.
+  @retval EFI_ALREADY_STARTED   Another event is registered already.
+  @retval EFI_DEVICE_ERROR      The receive notification could not be enabled on
+                                the network interface.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_SIMPLE_NETWORK_RX_NOTIFY_REGISTER)(
+  IN EDKII_SIMPLE_NETWORK_RX_NOTIFY_PROTOCOL  *This,
+  IN EFI_EVENT                                Event  OPTIONAL
+  );
+
+///
+/// Simple Network Receive Notify protocol.
+///
+struct _EDKII_SIMPLE_NETWORK_RX_NOTIFY_PROTOCOL {
+  EDKII_SIMPLE_NETWORK_RX_NOTIFY_REGISTER  Register;
+};
+
+extern EFI_GUID gEdkiiSimpleNetworkRxNotifyProtocolGuid;
+
+#endif
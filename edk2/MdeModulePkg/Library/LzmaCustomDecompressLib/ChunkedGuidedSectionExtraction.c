@@ -0,0 +1,266 @@
+/** @file
+  Chunked LZMA Decompress GUIDed Section Extraction.
+  The data of a chunked LZMA GUIDed section is split into fixed size chunks
+  that were compressed independently, so that host tools can encode and decode
+  them in parallel. Firmware decodes the chunks one after another into the
+  output buffer, reusing the same scratch buffer for every chunk.
+
+  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+
+//
+// Every chunk starts with the LZMA properties and the 64-bit decoded size.
+//
+#define LZMA_CHUNK_HEADER_SIZE  (5 + 8)
+
+/**
+  Locate the data of a chunked LZMA GUIDed section and check its header.
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] Header        Returns the chunked LZMA header of the section data.
+  @param[out] DataSize      Returns the size, in bytes, of the section data.
+
+  @retval  RETURN_SUCCESS            The section data has a valid chunked LZMA header.
+  @retval  RETURN_INVALID_PARAMETER  The section is not a chunked LZMA section,
+                                     or its header is corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+LzmaChunkedGetHeader (
+  IN  CONST VOID           *InputSection,
+  OUT LZMA_CHUNKED_HEADER  **Header,
+  OUT UINT32               *DataSize
+  )
+{
+  EFI_GUID             *InputGuid;
+  LZMA_CHUNKED_HEADER  *ChunkedHeader;
+  UINT32               Size;
+
+  if (IS_SECTION2 (InputSection)) {
+    InputGuid     = &(((EFI_GUID_DEFINED_SECTION2 *) InputSection)->SectionDefinitionGuid);
+    ChunkedHeader = (LZMA_CHUNKED_HEADER *) ((UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset);
+    Size          = SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->DataOffset;
+  } else {
+    InputGuid     = &(((EFI_GUID_DEFINED_SECTION *) InputSection)->SectionDefinitionGuid);
+    ChunkedHeader = (LZMA_CHUNKED_HEADER *) ((UINT8 *) InputSection + ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset);
+    Size          = SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *) InputSection)->DataOffset;
+  }
+
+  if (!CompareGuid (&gLzmaChunkedCustomDecompressGuid, InputGuid)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Size < sizeof (LZMA_CHUNKED_HEADER) ||
+      ReadUnaligned32 (&ChunkedHeader->Signature) != LZMA_CHUNKED_SIGNATURE) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // The chunk table must fit in the section, and the chunks must cover the
+  // decoded data exactly.
+  //
+  if (ChunkedHeader->ChunkSize == 0 || ChunkedHeader->ChunkCount == 0 ||
+      ChunkedHeader->ChunkCount > (Size - sizeof (LZMA_CHUNKED_HEADER)) / sizeof (UINT32) ||
+      ChunkedHeader->DecodedSize == 0 ||
+      ChunkedHeader->ChunkCount != (ChunkedHeader->DecodedSize - 1) / ChunkedHeader->ChunkSize + 1) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  *Header   = ChunkedHeader;
+  *DataSize = Size;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Examines a GUIDed section and returns the size of the decoded buffer and the
+  size of an scratch buffer required to actually decode the data in a GUIDed section.
+
+  Examines a GUIDed section specified by InputSection.
+  If GUID for InputSection does not match the GUID that this handler supports,
+  then RETURN_UNSUPPORTED is returned.
+  If the required information can not be retrieved from InputSection,
+  then RETURN_INVALID_PARAMETER is returned.
+  If the GUID of InputSection does match the GUID that this handler supports,
+  then the size required to hold the decoded buffer is returned in OututBufferSize,
+  the size of an optional scratch buffer is returned in ScratchSize, and the Attributes field
+  from EFI_GUID_DEFINED_SECTION header of InputSection is returned in SectionAttribute.
+
+  If InputSection is NULL, then ASSERT().
+  If OutputBufferSize is NULL, then ASSERT().
+  If ScratchBufferSize is NULL, then ASSERT().
+  If SectionAttribute is NULL, then ASSERT().
+
+
+  @param[in]  InputSection       A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize   A pointer to the size, in bytes, of an output buffer required
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] ScratchBufferSize  A pointer to the size, in bytes, required as scratch space
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] SectionAttribute   A pointer to the attributes of the GUIDed section. See the Attributes
+                                 field of EFI_GUID_DEFINED_SECTION in the PI Specification.
+
+  @retval  RETURN_SUCCESS            The information about InputSection was returned.
+  @retval  RETURN_UNSUPPORTED        The section specified by InputSection does not match the GUID this handler supports.
+  @retval  RETURN_INVALID_PARAMETER  The information can not be retrieved from the section specified by InputSection.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedGuidedSectionGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *ScratchBufferSize,
+  OUT UINT16      *SectionAttribute
+  )
+{
+  RETURN_STATUS        Status;
+  LZMA_CHUNKED_HEADER  *Header;
+  UINT32               DataSize;
+  UINT32               ChunkTableSize;
+  UINT32               ChunkDecodedSize;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBufferSize != NULL);
+  ASSERT (ScratchBufferSize != NULL);
+  ASSERT (SectionAttribute != NULL);
+
+  Status = LzmaChunkedGetHeader (InputSection, &Header, &DataSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  if (IS_SECTION2 (InputSection)) {
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION2 *) InputSection)->Attributes;
+  } else {
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION *) InputSection)->Attributes;
+  }
+
+  //
+  // Every chunk is decoded with the same scratch buffer, so the requirement of
+  // the first chunk is the requirement of the whole section.
+  //
+  ChunkTableSize = sizeof (LZMA_CHUNKED_HEADER) + Header->ChunkCount * sizeof (UINT32);
+  if (ReadUnaligned32 ((UINT32 *) (Header + 1)) < LZMA_CHUNK_HEADER_SIZE ||
+      ReadUnaligned32 ((UINT32 *) (Header + 1)) > DataSize - ChunkTableSize) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Status = LzmaUefiDecompressGetInfo (
+             (UINT8 *) Header + ChunkTableSize,
+             ReadUnaligned32 ((UINT32 *) (Header + 1)),
+             &ChunkDecodedSize,
+             ScratchBufferSize
+             );
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  *OutputBufferSize = Header->DecodedSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompress a chunked LZMA compressed GUIDed section into a caller allocated output buffer.
+
+  Decodes the GUIDed section specified by InputSection.
+  If GUID for InputSection does not match the GUID that this handler supports, then RETURN_UNSUPPORTED is returned.
+  If the data in InputSection can not be decoded, then RETURN_INVALID_PARAMETER is returned.
+  If the GUID of InputSection does match the GUID that this handler supports, then InputSection
+  is decoded into the buffer specified by OutputBuffer and the authentication status of this
+  decode operation is returned in AuthenticationStatus.  If the decoded buffer is identical to the
+  data in InputSection, then OutputBuffer is set to point at the data in InputSection.  Otherwise,
+  the decoded data will be placed in caller allocated buffer specified by OutputBuffer.
+
+  If InputSection is NULL, then ASSERT().
+  If OutputBuffer is NULL, then ASSERT().
+  If ScratchBuffer is NULL and this decode operation requires a scratch buffer, then ASSERT().
+  If AuthenticationStatus is NULL, then ASSERT().
+
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBuffer  A pointer to a buffer that contains the result of a decode operation.
+  @param[out] ScratchBuffer A caller allocated buffer that may be required by this function
+                            as a scratch buffer to perform the decode operation.
+  @param[out] AuthenticationStatus
+                            A pointer to the authentication status of the decoded output buffer.
+                            See the definition of authentication status in the EFI_PEI_GUIDED_SECTION_EXTRACTION_PPI
+                            section of the PI Specification. EFI_AUTH_STATUS_PLATFORM_OVERRIDE must
+                            never be set by this handler.
+
+  @retval  RETURN_SUCCESS            The buffer specified by InputSection was decoded.
+  @retval  RETURN_UNSUPPORTED        The section specified by InputSection does not match the GUID this handler supports.
+  @retval  RETURN_INVALID_PARAMETER  The section specified by InputSection can not be decoded.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaChunkedGuidedSectionExtraction (
+  IN CONST  VOID    *InputSection,
+  OUT       VOID    **OutputBuffer,
+  OUT       VOID    *ScratchBuffer,        OPTIONAL
+  OUT       UINT32  *AuthenticationStatus
+  )
+{
+  RETURN_STATUS        Status;
+  LZMA_CHUNKED_HEADER  *Header;
+  UINT32               DataSize;
+  UINT32               *ChunkTable;
+  UINT8                *Chunk;
+  UINT32               Remaining;
+  UINT32               Index;
+  UINT32               ChunkCompressedSize;
+  UINT32               ChunkDecodedSize;
+  UINT32               ScratchSize;
+  UINT8                *Destination;
+
+  ASSERT (OutputBuffer != NULL);
+  ASSERT (InputSection != NULL);
+
+  Status = LzmaChunkedGetHeader (InputSection, &Header, &DataSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Authentication is set to Zero, which may be ignored.
+  //
+  *AuthenticationStatus = 0;
+
+  ChunkTable  = (UINT32 *) (Header + 1);
+  Chunk       = (UINT8 *) (ChunkTable + Header->ChunkCount);
+  Remaining   = DataSize - (UINT32) (Chunk - (UINT8 *) Header);
+  Destination = *OutputBuffer;
+
+  for (Index = 0; Index < Header->ChunkCount; Index++) {
+    ChunkCompressedSize = ReadUnaligned32 (&ChunkTable[Index]);
+    if (ChunkCompressedSize < LZMA_CHUNK_HEADER_SIZE || ChunkCompressedSize > Remaining) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    //
+    // Each chunk must decode to exactly its share of the output buffer, so
+    // that a corrupted chunk can not write past the end of it.
+    //
+    Status = LzmaUefiDecompressGetInfo (Chunk, ChunkCompressedSize, &ChunkDecodedSize, &ScratchSize);
+    if (RETURN_ERROR (Status) ||
+        ChunkDecodedSize != MIN (Header->ChunkSize, Header->DecodedSize - Index * Header->ChunkSize)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Status = LzmaUefiDecompress (Chunk, ChunkCompressedSize, Destination, ScratchBuffer);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    Chunk       += ChunkCompressedSize;
+    Remaining   -= ChunkCompressedSize;
+    Destination += ChunkDecodedSize;
+  }
+
+  return RETURN_SUCCESS;
+}
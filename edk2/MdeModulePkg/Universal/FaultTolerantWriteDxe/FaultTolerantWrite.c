@@ -278,20 +278,22 @@ FtwWriteRecord (
 }
 
 /**
-  Starts a target block update. This function will record data about write
-  in fault tolerant storage and will complete the write in a recoverable
-  manner, ensuring at all times that either the original contents or
-  the modified contents are available.
+  Starts a target block update of one or more writes. This function will record
+  data about the writes in one record of fault tolerant storage and will complete
+  them with one update of the spare block, in a recoverable manner, ensuring at
+  all times that either the original contents or the modified contents are
+  available.
 
-  @param This            The pointer to this protocol instance.
-  @param Lba             The logical block address of the target block.
-  @param Offset          The offset within the target block to place the data.
-  @param Length          The number of bytes to write to the target block.
+  The record covers the blocks from the first to the last block written, the
+  data of those blocks that is not written is copied from the target blocks.
+
+  @param FtwDevice       The private data of FTW driver.
   @param PrivateData     A pointer to private data that the caller requires to
                          complete any pending writes in the event of a fault.
   @param FvBlockHandle   The handle of FVB protocol that provides services for
                          reading, writing, and erasing the target block.
-  @param Buffer          The data to write.
+  @param EntryCount      The number of writes in Entries, at least 1.
+  @param Entries         The writes to do, in order.
 
   @retval EFI_SUCCESS          The function completed successfully
   @retval EFI_ABORTED          The function could not complete successfully.
@@ -302,20 +304,22 @@ FtwWriteRecord (
   @retval EFI_NOT_FOUND        Cannot find FVB protocol by handle.
 
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-FtwWrite (
-  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL     *This,
-  IN EFI_LBA                               Lba,
-  IN UINTN                                 Offset,
-  IN UINTN                                 Length,
-  IN VOID                                  *PrivateData,
-  IN EFI_HANDLE                            FvBlockHandle,
-  IN VOID                                  *Buffer
+FtwWriteEntries (
+  IN EFI_FTW_DEVICE                          *FtwDevice,
+  IN VOID                                    *PrivateData,
+  IN EFI_HANDLE                              FvBlockHandle,
+  IN UINTN                                   EntryCount,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Entries
   )
 {
   EFI_STATUS                          Status;
-  EFI_FTW_DEVICE                      *FtwDevice;
+  EFI_FAULT_TOLERANT_WRITE_PROTOCOL   *This;
+  EFI_LBA                             Lba;
+  UINTN                               Offset;
+  UINTN                               Length;
+  UINTN                               EntryOffset;
   EFI_FAULT_TOLERANT_WRITE_HEADER     *Header;
   EFI_FAULT_TOLERANT_WRITE_RECORD     *Record;
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb;
@@ -333,7 +337,7 @@ FtwWrite (
   UINTN                               NumberOfWriteBlocks;
   UINTN                               WriteLength;
 
-  FtwDevice = FTW_CONTEXT_FROM_THIS (This);
+  This      = &FtwDevice->FtwInstance;
 
   Status    = WorkSpaceRefresh (FtwDevice);
   if (EFI_ERROR (Status)) {
@@ -409,6 +413,26 @@ FtwWrite (
     return EFI_ABORTED;
   }
 
+  //
+  // The record starts at the lowest target block, and covers all the written
+  // ranges relative to that block.
+  //
+  Lba = Entries[0].Lba;
+  for (Index = 1; Index < EntryCount; Index++) {
+    Lba = MIN (Lba, Entries[Index].Lba);
+  }
+  Offset = MAX_UINTN;
+  Length = 0;
+  for (Index = 0; Index < EntryCount; Index++) {
+    if (Entries[Index].Lba - Lba >= FtwDevice->SpareAreaLength / BlockSize) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+    EntryOffset = (UINTN) (Entries[Index].Lba - Lba) * BlockSize + Entries[Index].Offset;
+    Offset      = MIN (Offset, EntryOffset);
+    Length      = MAX (Length, EntryOffset + Entries[Index].Length);
+  }
+  Length -= Offset;
+
   NumberOfWriteBlocks = FTW_BLOCKS (Offset + Length, BlockSize);
   DEBUG ((EFI_D_INFO, "Ftw: Write(), BlockSize - 0x%x, NumberOfWriteBlock - 0x%x\n", BlockSize, NumberOfWriteBlocks));
   WriteLength = NumberOfWriteBlocks * BlockSize;
@@ -484,7 +508,13 @@ FtwWrite (
   // Overwrite the updating range data with
   // the input buffer content
   //
-  CopyMem (MyBuffer + Offset, Buffer, Length);
+  for (Index = 0; Index < EntryCount; Index++) {
+    CopyMem (
+      MyBuffer + (UINTN) (Entries[Index].Lba - Lba) * BlockSize + Entries[Index].Offset,
+      Entries[Index].Buffer,
+      Entries[Index].Length
+      );
+  }
 
   //
   // Try to keep the content of spare block
@@ -612,15 +642,103 @@ FtwWrite (
 
   DEBUG (
     (EFI_D_INFO,
-    "Ftw: Write() success, (Lba:Offset)=(%lx:0x%x), Length: 0x%x\n",
+    "Ftw: Write() success, (Lba:Offset)=(%lx:0x%x), Length: 0x%x, Writes: %d\n",
     Lba,
     Offset,
-    Length)
+    Length,
+    EntryCount)
     );
 
   return EFI_SUCCESS;
 }
 
+/**
+  Starts a target block update. This function will record data about write
+  in fault tolerant storage and will complete the write in a recoverable
+  manner, ensuring at all times that either the original contents or
+  the modified contents are available.
+
+  @param This            The pointer to this protocol instance.
+  @param Lba             The logical block address of the target block.
+  @param Offset          The offset within the target block to place the data.
+  @param Length          The number of bytes to write to the target block.
+  @param PrivateData     A pointer to private data that the caller requires to
+                         complete any pending writes in the event of a fault.
+  @param FvBlockHandle   The handle of FVB protocol that provides services for
+                         reading, writing, and erasing the target block.
+  @param Buffer          The data to write.
+
+  @retval EFI_SUCCESS          The function completed successfully
+  @retval EFI_ABORTED          The function could not complete successfully.
+  @retval EFI_BAD_BUFFER_SIZE  The input data can't fit within the spare block.
+                               Offset + *NumBytes > SpareAreaLength.
+  @retval EFI_ACCESS_DENIED    No writes have been allocated.
+  @retval EFI_OUT_OF_RESOURCES Cannot allocate enough memory resource.
+  @retval EFI_NOT_FOUND        Cannot find FVB protocol by handle.
+
+**/
+EFI_STATUS
+EFIAPI
+FtwWrite (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL     *This,
+  IN EFI_LBA                               Lba,
+  IN UINTN                                 Offset,
+  IN UINTN                                 Length,
+  IN VOID                                  *PrivateData,
+  IN EFI_HANDLE                            FvBlockHandle,
+  IN VOID                                  *Buffer
+  )
+{
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  Entry;
+
+  Entry.Lba    = Lba;
+  Entry.Offset = Offset;
+  Entry.Length = Length;
+  Entry.Buffer = Buffer;
+
+  return FtwWriteEntries (FTW_CONTEXT_FROM_THIS (This), PrivateData, FvBlockHandle, 1, &Entry);
+}
+
+/**
+  Starts a target block update of several writes. The writes are recorded as
+  one write of the fault tolerant storage, and are completed with one update
+  of the spare block, in a recoverable manner, ensuring at all times that
+  either the original contents or all the modified contents are available.
+
+  @param This            The pointer to this protocol instance.
+  @param FvBlockHandle   The handle of FVB protocol that provides services for
+                         reading, writing, and erasing the target blocks.
+  @param PrivateData     A pointer to private data that the caller requires to
+                         complete any pending writes in the event of a fault.
+  @param EntryCount      The number of entries in Entries.
+  @param Entries         The writes to do, in order.
+
+  @retval EFI_SUCCESS           The function completed successfully
+  @retval EFI_INVALID_PARAMETER EntryCount is 0, or Entries is NULL.
+  @retval EFI_ABORTED           The function could not complete successfully.
+  @retval EFI_BAD_BUFFER_SIZE   The target blocks can't fit within the spare block.
+  @retval EFI_ACCESS_DENIED     No writes have been allocated.
+  @retval EFI_OUT_OF_RESOURCES  Cannot allocate enough memory resource.
+  @retval EFI_NOT_FOUND         Cannot find FVB protocol by handle.
+
+**/
+EFI_STATUS
+EFIAPI
+FtwBatchWrite (
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN VOID                                       *PrivateData,
+  IN UINTN                                      EntryCount,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Entries
+  )
+{
+  if ((EntryCount == 0) || (Entries == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return FtwWriteEntries (FTW_CONTEXT_FROM_BATCH_THIS (This), PrivateData, FvBlockHandle, EntryCount, Entries);
+}
+
 /**
   Restarts a previously interrupted write. The caller must provide the
   block protocol needed to complete the interrupted write.
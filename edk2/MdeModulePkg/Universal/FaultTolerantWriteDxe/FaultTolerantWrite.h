@@ -16,6 +16,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/SystemNvDataGuid.h>
 #include <Guid/ZeroGuid.h>
 #include <Protocol/FaultTolerantWrite.h>
+#include <Protocol/FaultTolerantWriteBatch.h>
 #include <Protocol/FirmwareVolumeBlock.h>
 #include <Protocol/SwapAddressRange.h>
 
@@ -54,6 +55,7 @@ typedef struct {
   UINTN                                   Signature;
   EFI_HANDLE                              Handle;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL       FtwInstance;
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL FtwBatchInstance;
   EFI_PHYSICAL_ADDRESS                    WorkSpaceAddress;   // Base address of working space range in flash.
   EFI_PHYSICAL_ADDRESS                    SpareAreaAddress;   // Base address of spare range in flash.
   UINTN                                   WorkSpaceLength;    // Size of working space range in flash.
@@ -83,6 +85,7 @@ typedef struct {
 } EFI_FTW_DEVICE;
 
 #define FTW_CONTEXT_FROM_THIS(a)  CR (a, EFI_FTW_DEVICE, FtwInstance, FTW_DEVICE_SIGNATURE)
+#define FTW_CONTEXT_FROM_BATCH_THIS(a)  CR (a, EFI_FTW_DEVICE, FtwBatchInstance, FTW_DEVICE_SIGNATURE)
 
 //
 // Driver entry point
@@ -197,6 +200,39 @@ FtwWrite (
   IN VOID                                  *Buffer
   );
 
+/**
+  Starts a target block update of several writes. The writes are recorded as
+  one write of the fault tolerant storage, and are completed with one update
+  of the spare block, in a recoverable manner, ensuring at all times that
+  either the original contents or all the modified contents are available.
+
+  @param This            Calling context
+  @param FvBlockHandle   The handle of FVB protocol that provides services for
+                         reading, writing, and erasing the target blocks.
+  @param PrivateData     A pointer to private data that the caller requires to
+                         complete any pending writes in the event of a fault.
+  @param EntryCount      The number of entries in Entries.
+  @param Entries         The writes to do, in order.
+
+  @retval EFI_SUCCESS           The function completed successfully
+  @retval EFI_INVALID_PARAMETER EntryCount is 0, or Entries is NULL.
+  @retval EFI_ABORTED           The function could not complete successfully.
+  @retval EFI_BAD_BUFFER_SIZE   The target blocks can't fit within the spare block.
+  @retval EFI_ACCESS_DENIED     No writes have been allocated.
+  @retval EFI_OUT_OF_RESOURCES  Cannot allocate enough memory resource.
+  @retval EFI_NOT_FOUND         Cannot find FVB protocol by handle.
+
+**/
+EFI_STATUS
+EFIAPI
+FtwBatchWrite (
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN VOID                                       *PrivateData,
+  IN UINTN                                      EntryCount,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Entries
+  );
+
 /**
   Restarts a previously interrupted write. The caller must provide the
   block protocol needed to complete the interrupted write.
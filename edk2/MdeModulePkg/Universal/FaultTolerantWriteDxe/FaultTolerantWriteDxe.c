@@ -186,11 +186,13 @@ FvbNotificationEvent (
   //
   // Install protocol interface
   //
-  Status = gBS->InstallProtocolInterface (
+  Status = gBS->InstallMultipleProtocolInterfaces (
                   &FtwDevice->Handle,
                   &gEfiFaultTolerantWriteProtocolGuid,
-                  EFI_NATIVE_INTERFACE,
-                  &FtwDevice->FtwInstance
+                  &FtwDevice->FtwInstance,
+                  &gEdkiiFaultTolerantWriteBatchProtocolGuid,
+                  &FtwDevice->FtwBatchInstance,
+                  NULL
                   );
   ASSERT_EFI_ERROR (Status);
 
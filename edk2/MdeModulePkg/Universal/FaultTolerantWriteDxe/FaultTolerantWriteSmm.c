@@ -551,6 +551,14 @@ FvbNotificationEvent (
                     );
   ASSERT_EFI_ERROR (Status);
 
+  Status = gMmst->MmInstallProtocolInterface (
+                    &mFtwDevice->Handle,
+                    &gEdkiiSmmFaultTolerantWriteBatchProtocolGuid,
+                    EFI_NATIVE_INTERFACE,
+                    &mFtwDevice->FtwBatchInstance
+                    );
+  ASSERT_EFI_ERROR (Status);
+
   ///
   /// Register SMM FTW SMI handler
   ///
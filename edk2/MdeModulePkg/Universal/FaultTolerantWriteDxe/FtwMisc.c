@@ -1372,6 +1372,7 @@ InitFtwProtocol (
   FtwDevice->FtwInstance.Restart         = FtwRestart;
   FtwDevice->FtwInstance.Abort           = FtwAbort;
   FtwDevice->FtwInstance.GetLastWrite    = FtwGetLastWrite;
+  FtwDevice->FtwBatchInstance.Write      = FtwBatchWrite;
 
   return EFI_SUCCESS;
 }
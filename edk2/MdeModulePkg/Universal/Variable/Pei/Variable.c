@@ -545,6 +545,153 @@ GetHobVariableStore (
   }
 }
 
+/**
+  Compute the hash of a variable name and vendor GUID (32-bit FNV-1a), as
+  recorded in VARIABLE_STORE_INDEX_ENTRY.
+
+  @param  VariableName  Name of the variable.
+  @param  NameSize      Size of VariableName in bytes, including the
+                        terminating null character.
+  @param  VendorGuid    Vendor GUID of the variable.
+
+  @return The hash value.
+
+**/
+UINT32
+GetVariableStoreIndexHash (
+  IN CONST CHAR16    *VariableName,
+  IN UINTN           NameSize,
+  IN CONST EFI_GUID  *VendorGuid
+  )
+{
+  CONST UINT8  *Bytes;
+  UINT32       Hash;
+  UINTN        Index;
+
+  Hash  = 0x811C9DC5;
+  Bytes = (CONST UINT8 *) VendorGuid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Bytes[Index]) * 0x01000193;
+  }
+  Bytes = (CONST UINT8 *) VariableName;
+  for (Index = 0; Index < NameSize; Index++) {
+    Hash = (Hash ^ Bytes[Index]) * 0x01000193;
+  }
+  return Hash;
+}
+
+/**
+  Get the index of the NV variable store, and build it in a GUID HOB on the
+  first access to the store.
+
+  The store is walked twice, to size the HOB and to fill it. It must not have
+  a partial backup in the spare block, so that every variable is consecutive.
+
+  @param  StoreInfo            Pointer to the store info structure.
+  @param  VariableStoreHeader  Pointer to the NV variable store header.
+
+  @return The index of the store, or NULL if the store is not indexed.
+
+**/
+VARIABLE_STORE_INDEX *
+GetVariableStoreIndex (
+  IN VARIABLE_STORE_INFO        *StoreInfo,
+  IN VARIABLE_STORE_HEADER      *VariableStoreHeader
+  )
+{
+  EFI_HOB_GUID_TYPE           *GuidHob;
+  VARIABLE_STORE_INDEX        *StoreIndex;
+  VARIABLE_STORE_INDEX_ENTRY  *Entry;
+  VARIABLE_HEADER             *Variable;
+  VARIABLE_HEADER             *NextVariable;
+  VARIABLE_HEADER             *EndPtr;
+  UINTN                       EntryCount;
+  UINTN                       VariableSize;
+  BOOLEAN                     Indexed;
+
+  GuidHob = GetFirstGuidHob (&gEdkiiVariableStoreIndexGuid);
+  if (GuidHob != NULL) {
+    StoreIndex = GET_GUID_HOB_DATA (GuidHob);
+    return (StoreIndex->StoreSize == VariableStoreHeader->Size) ? StoreIndex : NULL;
+  }
+
+  ASSERT (StoreInfo->FtwLastWriteData == NULL);
+
+  Indexed = (BOOLEAN) (GetVariableStoreStatus (VariableStoreHeader) == EfiValid &&
+                       ~VariableStoreHeader->Size != 0);
+  EndPtr  = GetEndPointer (VariableStoreHeader);
+
+  EntryCount = 0;
+  if (Indexed) {
+    for (Variable = GetStartPointer (VariableStoreHeader);
+         Variable < EndPtr && IsValidVariableHeader (Variable);
+         Variable = GetNextVariablePtr (StoreInfo, Variable, Variable)) {
+      if (Variable->State == VAR_ADDED || Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+        EntryCount++;
+      }
+    }
+    //
+    // A GUID HOB is at most 64KB.
+    //
+    if (sizeof (VARIABLE_STORE_INDEX) + EntryCount * sizeof (VARIABLE_STORE_INDEX_ENTRY) > 0xFFF8 - sizeof (EFI_HOB_GUID_TYPE)) {
+      DEBUG ((EFI_D_INFO, "PeiVariable: %d variables are too many to be indexed\n", EntryCount));
+      Indexed = FALSE;
+    }
+  }
+
+  if (!Indexed) {
+    //
+    // Record that the store is not indexed, so that it is not walked again.
+    //
+    StoreIndex = BuildGuidHob (&gEdkiiVariableStoreIndexGuid, sizeof (VARIABLE_STORE_INDEX));
+    if (StoreIndex != NULL) {
+      ZeroMem (StoreIndex, sizeof (VARIABLE_STORE_INDEX));
+      StoreIndex->Signature = VARIABLE_STORE_INDEX_SIGNATURE;
+    }
+    return NULL;
+  }
+
+  StoreIndex = BuildGuidHob (&gEdkiiVariableStoreIndexGuid, sizeof (VARIABLE_STORE_INDEX) + EntryCount * sizeof (VARIABLE_STORE_INDEX_ENTRY));
+  if (StoreIndex == NULL) {
+    return NULL;
+  }
+  ZeroMem (StoreIndex, sizeof (VARIABLE_STORE_INDEX));
+  StoreIndex->Signature  = VARIABLE_STORE_INDEX_SIGNATURE;
+  StoreIndex->StoreSize  = VariableStoreHeader->Size;
+  StoreIndex->EntryCount = (UINT32) EntryCount;
+  CopyGuid (&StoreIndex->StoreSignature, &VariableStoreHeader->Signature);
+
+  Entry    = (VARIABLE_STORE_INDEX_ENTRY *) (StoreIndex + 1);
+  Variable = GetStartPointer (VariableStoreHeader);
+  while (Variable < EndPtr && IsValidVariableHeader (Variable)) {
+    NextVariable = GetNextVariablePtr (StoreInfo, Variable, Variable);
+    VariableSize = (UINTN) NextVariable - (UINTN) Variable;
+    if ((Variable->Attributes & (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_HARDWARE_ERROR_RECORD)) == (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_HARDWARE_ERROR_RECORD)) {
+      StoreIndex->HwErrVariableTotalSize += (UINT32) VariableSize;
+    } else {
+      StoreIndex->CommonVariableTotalSize += (UINT32) VariableSize;
+    }
+
+    if (Variable->State == VAR_ADDED || Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      Entry->Hash = GetVariableStoreIndexHash (
+                      GetVariableNamePtr (Variable, StoreInfo->AuthFlag),
+                      NameSizeOfVariable (Variable, StoreInfo->AuthFlag),
+                      GetVendorGuidPtr (Variable, StoreInfo->AuthFlag)
+                      );
+      Entry->Offset = (UINT32) ((UINTN) Variable - (UINTN) VariableStoreHeader);
+      Entry++;
+    }
+
+    StoreIndex->LastOffset = (UINT32) ((UINTN) Variable - (UINTN) VariableStoreHeader);
+    Variable = NextVariable;
+  }
+  StoreIndex->EndOffset = (UINT32) ((UINTN) Variable - (UINTN) VariableStoreHeader);
+  ASSERT (Entry == (VARIABLE_STORE_INDEX_ENTRY *) (StoreIndex + 1) + EntryCount);
+
+  DEBUG ((EFI_D_INFO, "PeiVariable: indexed %d variables of the NV store\n", EntryCount));
+  return StoreIndex;
+}
+
 /**
   Return the variable store header and the store info based on the Index.
 
@@ -568,6 +715,7 @@ GetVariableStore (
   UINT32                                BackUpOffset;
 
   StoreInfo->IndexTable = NULL;
+  StoreInfo->StoreIndex = NULL;
   StoreInfo->FtwLastWriteData = NULL;
   StoreInfo->AuthFlag = FALSE;
   VariableStoreHeader = NULL;
@@ -633,6 +781,13 @@ GetVariableStore (
 
         StoreInfo->AuthFlag = (BOOLEAN) (CompareGuid (&VariableStoreHeader->Signature, &gEfiAuthenticatedVariableGuid));
 
+        if (StoreInfo->FtwLastWriteData == NULL) {
+          StoreInfo->StoreIndex = GetVariableStoreIndex (StoreInfo, VariableStoreHeader);
+          if (StoreInfo->StoreIndex != NULL) {
+            break;
+          }
+        }
+
         GuidHob = GetFirstGuidHob (&gEfiVariableIndexTableGuid);
         if (GuidHob != NULL) {
           StoreInfo->IndexTable = GET_GUID_HOB_DATA (GuidHob);
@@ -814,6 +969,8 @@ FindVariableEx (
   VARIABLE_STORE_HEADER   *VariableStoreHeader;
   VARIABLE_INDEX_TABLE    *IndexTable;
   VARIABLE_HEADER         *VariableHeader;
+  VARIABLE_STORE_INDEX_ENTRY  *Entry;
+  UINT32                  Hash;
 
   VariableStoreHeader = StoreInfo->VariableStoreHeader;
 
@@ -841,6 +998,32 @@ FindVariableEx (
   MaxIndex   = NULL;
   VariableHeader = NULL;
 
+  if (StoreInfo->StoreIndex != NULL && VariableName[0] != 0) {
+    //
+    // All the variables are indexed, only the ones with the same hash need
+    // to be compared.
+    //
+    Hash  = GetVariableStoreIndexHash (VariableName, StrSize (VariableName), VendorGuid);
+    Entry = (VARIABLE_STORE_INDEX_ENTRY *) (StoreInfo->StoreIndex + 1);
+    for (Index = 0; Index < StoreInfo->StoreIndex->EntryCount; Index++) {
+      if (Entry[Index].Hash != Hash) {
+        continue;
+      }
+      Variable = (VARIABLE_HEADER *) ((UINT8 *) VariableStoreHeader + Entry[Index].Offset);
+      GetVariableHeader (StoreInfo, Variable, &VariableHeader);
+      if (CompareWithValidVariable (StoreInfo, Variable, VariableHeader, VariableName, VendorGuid, PtrTrack) == EFI_SUCCESS) {
+        if (VariableHeader->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+          InDeletedVariable = PtrTrack->CurrPtr;
+        } else {
+          return EFI_SUCCESS;
+        }
+      }
+    }
+
+    PtrTrack->CurrPtr = InDeletedVariable;
+    return (PtrTrack->CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+  }
+
   if (IndexTable != NULL) {
     //
     // traverse the variable index table to look for varible.
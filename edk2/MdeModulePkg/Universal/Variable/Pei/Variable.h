@@ -13,6 +13,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <PiPei.h>
 #include <Ppi/ReadOnlyVariable2.h>
 
+#include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/PeimEntryPoint.h>
 #include <Library/HobLib.h>
@@ -23,6 +24,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Guid/VariableFormat.h>
 #include <Guid/VariableIndexTable.h>
+#include <Guid/VariableStoreIndex.h>
 #include <Guid/SystemNvDataGuid.h>
 #include <Guid/FaultTolerantWrite.h>
 
@@ -36,6 +38,11 @@ typedef struct {
   VARIABLE_STORE_HEADER                   *VariableStoreHeader;
   VARIABLE_INDEX_TABLE                    *IndexTable;
   //
+  // Index of all the variables of the NV store. IndexTable is not used when
+  // it is not NULL.
+  //
+  VARIABLE_STORE_INDEX                    *StoreIndex;
+  //
   // If it is not NULL, it means there may be an inconsecutive variable whose
   // partial content is still in NV storage, but another partial content is backed up
   // in spare block.
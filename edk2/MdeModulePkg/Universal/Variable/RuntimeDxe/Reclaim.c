@@ -92,6 +92,13 @@ GetLbaAndOffsetByAddress (
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
 
+  Reclaim() keeps the variables in front of the first deleted one at their
+  offsets, so the leading blocks of the store often do not change. Only the
+  store from the first block that differs from flash to its end is written,
+  and those leading blocks are not erased. The FTW spare block then holds the
+  high part of the store, which the PEI and DXE variable drivers already
+  restore from after a power failure.
+
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
 
@@ -112,6 +119,12 @@ FtwVariableSpace (
   UINTN                              VarOffset;
   UINTN                              FtwBufferSize;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
+  VARIABLE_RECLAIM_STATISTICS        *Statistics;
+  UINTN                              BlockSize;
+  UINTN                              StoreBlocks;
+  UINTN                              KeptBlocks;
+  UINTN                              Start;
+  UINTN                              End;
 
   //
   // Locate fault tolerant write protocol.
@@ -138,6 +151,37 @@ FtwVariableSpace (
   FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
   ASSERT (FtwBufferSize == VariableBuffer->Size);
 
+  //
+  // Skip the leading blocks that are the same in the buffer and in flash.
+  // BUGBUG: Assume one FV has one type of BlockLength, as GetLbaAndOffsetByAddress().
+  //
+  BlockSize   = mNvFvHeaderCache->BlockMap[0].Length;
+  StoreBlocks = (VarOffset + FtwBufferSize + BlockSize - 1) / BlockSize;
+  Start       = 0;
+  while (Start < FtwBufferSize) {
+    End = MIN (Start + BlockSize - (VarOffset + Start) % BlockSize, FtwBufferSize);
+    if (CompareMem ((UINT8 *) VariableBuffer + Start, (UINT8 *) (UINTN) VariableBase + Start, End - Start) != 0) {
+      break;
+    }
+    Start = End;
+  }
+
+  Statistics = &mVariableModuleGlobal->ReclaimStatistics;
+  Statistics->ReclaimCount++;
+  if (Start == FtwBufferSize) {
+    Statistics->BlocksKept += (UINT32) StoreBlocks;
+    return EFI_SUCCESS;
+  }
+
+  KeptBlocks = (VarOffset + Start) / BlockSize;
+  if (Start != 0) {
+    Status = GetLbaAndOffsetByAddress (VariableBase + Start, &VarLba, &VarOffset);
+    if (EFI_ERROR (Status)) {
+      return EFI_ABORTED;
+    }
+    ASSERT (VarOffset == 0);
+  }
+
   //
   // FTW write record.
   //
@@ -145,11 +189,16 @@ FtwVariableSpace (
                           FtwProtocol,
                           VarLba,         // LBA
                           VarOffset,      // Offset
-                          FtwBufferSize,  // NumBytes
+                          FtwBufferSize - Start, // NumBytes
                           NULL,           // PrivateData NULL
                           FvbHandle,      // Fvb Handle
-                          (VOID *) VariableBuffer // write buffer
+                          (UINT8 *) VariableBuffer + Start // write buffer
                           );
+  if (!EFI_ERROR (Status)) {
+    Statistics->BytesRewritten  += FtwBufferSize - Start;
+    Statistics->BlocksRewritten += (UINT32) (StoreBlocks - KeptBlocks);
+    Statistics->BlocksKept      += (UINT32) KeptBlocks;
+  }
 
   return Status;
 }
@@ -1192,6 +1192,14 @@ Reclaim (
       mVariableModuleGlobal->HwErrVariableTotalSize = HwErrVariableTotalSize;
       mVariableModuleGlobal->CommonVariableTotalSize = CommonVariableTotalSize;
       mVariableModuleGlobal->CommonUserVariableTotalSize = CommonUserVariableTotalSize;
+      DEBUG ((
+        EFI_D_INFO,
+        "Variable: reclaim %d rewrote 0x%lx bytes in %d blocks, %d block erases avoided\n",
+        mVariableModuleGlobal->ReclaimStatistics.ReclaimCount,
+        mVariableModuleGlobal->ReclaimStatistics.BytesRewritten,
+        mVariableModuleGlobal->ReclaimStatistics.BlocksRewritten,
+        mVariableModuleGlobal->ReclaimStatistics.BlocksKept
+        ));
     } else {
       mVariableModuleGlobal->HwErrVariableTotalSize = 0;
       mVariableModuleGlobal->CommonVariableTotalSize = 0;
@@ -1225,6 +1233,9 @@ Done:
     CopyMem (mNvVariableCache, (UINT8 *)(UINTN)VariableBase, VariableStoreHeader->Size);
   }
 
+  VariableHashIndexRebuild (IsVolatile ? VariableStoreTypeVolatile : VariableStoreTypeNv);
+  SynchronizeRuntimeVariableCache (IsVolatile ? VariableStoreTypeVolatile : VariableStoreTypeNv);
+
   return Status;
 }
 
@@ -1250,6 +1261,14 @@ FindVariableEx (
 {
   VARIABLE_HEADER                *InDeletedVariable;
   VOID                           *Point;
+  EFI_STATUS                     Status;
+
+  if (VariableName[0] != 0) {
+    Status = FindVariableByHashIndex (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+  }
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
@@ -2683,6 +2702,7 @@ UpdateVariable (
       }
     }
 
+    VariableHashIndexInsert (VariableStoreTypeNv, mVariableModuleGlobal->NonVolatileLastVariableOffset);
     mVariableModuleGlobal->NonVolatileLastVariableOffset += HEADER_ALIGN (VarSize);
 
     if ((Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) != 0) {
@@ -2740,6 +2760,7 @@ UpdateVariable (
       goto Done;
     }
 
+    VariableHashIndexInsert (VariableStoreTypeVolatile, mVariableModuleGlobal->VolatileLastVariableOffset);
     mVariableModuleGlobal->VolatileLastVariableOffset += HEADER_ALIGN (VarSize);
   }
 
@@ -2798,6 +2819,14 @@ UpdateVariable (
   }
 
 Done:
+  //
+  // Also on failure, a header may have been written before the error.
+  //
+  if (((Variable->CurrPtr != NULL) && !Variable->Volatile) || ((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0)) {
+    SynchronizeRuntimeVariableCache (VariableStoreTypeNv);
+  } else {
+    SynchronizeRuntimeVariableCache (VariableStoreTypeVolatile);
+  }
   return Status;
 }
 
@@ -4002,6 +4031,10 @@ InitEmuNonVolatileVariableStore (
 /**
   Init non-volatile variable store.
 
+  @param[out] NvStoreIndex      Return the index of the NV variable store built
+                                by the PEI variable driver, or NULL if there is
+                                none that matches the store.
+
   @retval EFI_SUCCESS           Function successfully executed.
   @retval EFI_OUT_OF_RESOURCES  Fail to allocate enough memory resource.
   @retval EFI_VOLUME_CORRUPTED  Variable Store or Firmware Volume for Variable Store is corrupted.
@@ -4009,7 +4042,7 @@ InitEmuNonVolatileVariableStore (
 **/
 EFI_STATUS
 InitNonVolatileVariableStore (
-  VOID
+  OUT VARIABLE_STORE_INDEX              **NvStoreIndex
   )
 {
   VARIABLE_HEADER                       *Variable;
@@ -4040,6 +4073,18 @@ InitNonVolatileVariableStore (
   mVariableModuleGlobal->MaxVariableSize = PcdGet32 (PcdMaxVariableSize);
   mVariableModuleGlobal->MaxAuthVariableSize = ((PcdGet32 (PcdMaxAuthVariableSize) != 0) ? PcdGet32 (PcdMaxAuthVariableSize) : mVariableModuleGlobal->MaxVariableSize);
 
+  //
+  // The PEI variable driver has already walked the store if it published a
+  // matching index.
+  //
+  *NvStoreIndex = GetNvVariableStoreIndex ();
+  if (*NvStoreIndex != NULL) {
+    mVariableModuleGlobal->HwErrVariableTotalSize        = (*NvStoreIndex)->HwErrVariableTotalSize;
+    mVariableModuleGlobal->CommonVariableTotalSize       = (*NvStoreIndex)->CommonVariableTotalSize;
+    mVariableModuleGlobal->NonVolatileLastVariableOffset = (*NvStoreIndex)->EndOffset;
+    return EFI_SUCCESS;
+  }
+
   //
   // Parse non-volatile variable data and get last variable offset.
   //
@@ -4152,6 +4197,7 @@ FlushHobVariableToFlash (
         FreePool ((VOID *) VariableStoreHeader);
       }
     }
+    SynchronizeRuntimeVariableCache (VariableStoreTypeHob);
   }
 
 }
@@ -4448,6 +4494,7 @@ VariableCommonInitialize (
   VARIABLE_STORE_HEADER           *VolatileVariableStore;
   UINTN                           ScratchSize;
   EFI_GUID                        *VariableGuid;
+  VARIABLE_STORE_INDEX            *NvStoreIndex;
 
   //
   // Allocate runtime memory for variable driver global structure.
@@ -4462,7 +4509,7 @@ VariableCommonInitialize (
   //
   // Init non-volatile variable store.
   //
-  Status = InitNonVolatileVariableStore ();
+  Status = InitNonVolatileVariableStore (&NvStoreIndex);
   if (EFI_ERROR (Status)) {
     FreePool (mVariableModuleGlobal);
     return Status;
@@ -4533,6 +4580,8 @@ VariableCommonInitialize (
   VolatileVariableStore->Reserved    = 0;
   VolatileVariableStore->Reserved1   = 0;
 
+  VariableHashIndexInitialize (NvStoreIndex);
+
   return EFI_SUCCESS;
 }
 
@@ -37,6 +37,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/SystemNvDataGuid.h>
 #include <Guid/FaultTolerantWrite.h>
 #include <Guid/VarErrorFlag.h>
+#include <Guid/SmmVariableCommon.h>
+#include <Guid/VariableStoreIndex.h>
 
 #include "PrivilegePolymorphic.h"
 
@@ -78,6 +80,49 @@ typedef struct {
   BOOLEAN         Volatile;
 } VARIABLE_POINTER_TRACK;
 
+///
+/// Entry of the hash index of a variable store.
+///
+typedef struct {
+  UINT32          Hash;
+  UINT32          Offset;   ///< Offset of the variable header from the variable store header.
+  UINT32          Next;     ///< Index of the next entry in the same bucket.
+} VARIABLE_HASH_INDEX_ENTRY;
+
+typedef struct {
+  UINT32                    *Buckets;
+  VARIABLE_HASH_INDEX_ENTRY *Entries;
+  UINT32                    BucketCount;
+  UINT32                    EntryCount;
+  UINT32                    UsedCount;
+  BOOLEAN                   Valid;
+} VARIABLE_HASH_INDEX;
+
+///
+/// Copy of a variable store in the runtime variable cache.
+///
+typedef struct {
+  VARIABLE_STORE_HEADER     *Store;
+  UINTN                     Size;
+  UINTN                     Length;   ///< Bytes of the store in use when it was last copied.
+  BOOLEAN                   Dirty;
+} VARIABLE_RUNTIME_CACHE;
+
+typedef struct {
+  SMM_VARIABLE_RUNTIME_CACHE_CONTROL  *Control;
+  VARIABLE_RUNTIME_CACHE              Cache[VariableStoreTypeMax];
+} VARIABLE_RUNTIME_CACHE_CONTEXT;
+
+///
+/// Flash wear of the non-volatile variable store reclaims.
+///
+typedef struct {
+  UINT32                    ReclaimCount;
+  UINT32                    BlocksRewritten;  ///< Blocks erased and programmed through FTW.
+  UINT32                    BlocksKept;       ///< Erase cycles avoided by leaving unchanged blocks.
+  UINT64                    BytesRewritten;
+} VARIABLE_RECLAIM_STATISTICS;
+
 typedef struct {
   EFI_PHYSICAL_ADDRESS  HobVariableBase;
   EFI_PHYSICAL_ADDRESS  VolatileVariableBase;
@@ -108,6 +153,9 @@ typedef struct {
   CHAR8           *PlatformLang;
   CHAR8           Lang[ISO_639_2_ENTRY_SIZE + 1];
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL *FvbInstance;
+  VARIABLE_HASH_INDEX HashIndex[VariableStoreTypeMax];
+  VARIABLE_RUNTIME_CACHE_CONTEXT RuntimeCache;
+  VARIABLE_RECLAIM_STATISTICS ReclaimStatistics;
 } VARIABLE_MODULE_GLOBAL;
 
 /**
@@ -179,6 +227,147 @@ FindVariable (
   IN  BOOLEAN                 IgnoreRtCheck
   );
 
+/**
+  Get the index of the NV variable store built by the PEI variable driver.
+
+  @return The index of the NV variable store, or NULL if there is no index
+          or it does not match the store.
+
+**/
+VARIABLE_STORE_INDEX *
+GetNvVariableStoreIndex (
+  VOID
+  );
+
+/**
+  Allocate and build the hash index of every variable store.
+
+  A store whose index can not be allocated is searched linearly.
+
+  @param[in] NvStoreIndex   The index of the NV variable store returned by
+                            GetNvVariableStoreIndex(), the NV hash index is
+                            built from it instead of the store if not NULL.
+
+**/
+VOID
+VariableHashIndexInitialize (
+  IN VARIABLE_STORE_INDEX  *NvStoreIndex OPTIONAL
+  );
+
+/**
+  Rebuild the hash index of a variable store from the headers in the store.
+
+  @param[in] Type   Variable store type.
+
+**/
+VOID
+VariableHashIndexRebuild (
+  IN VARIABLE_STORE_TYPE  Type
+  );
+
+/**
+  Add a variable header of a store to its hash index.
+
+  @param[in] Type     Variable store type.
+  @param[in] Offset   Offset of the variable header from the variable store header.
+
+**/
+VOID
+VariableHashIndexInsert (
+  IN VARIABLE_STORE_TYPE  Type,
+  IN UINTN                Offset
+  );
+
+/**
+  Find the variable in the specified variable store with its hash index.
+
+  @param[in]       VariableName        Name of the variable to be found, not empty.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+
+  @retval          EFI_SUCCESS         Variable found successfully
+  @retval          EFI_NOT_FOUND       Variable not found
+  @retval          EFI_UNSUPPORTED     The range of PtrTrack is not an indexed store,
+                                       the store must be searched linearly.
+**/
+EFI_STATUS
+FindVariableByHashIndex (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  );
+
+/**
+  Get the sizes of the variable stores to be copied in the runtime variable cache.
+
+  @param[out] Info      The store sizes and the variable header format.
+
+**/
+VOID
+GetRuntimeVariableCacheInfo (
+  OUT SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO  *Info
+  );
+
+/**
+  Start to copy the variable stores in the runtime variable cache.
+
+  The buffers of Context must have been checked by the caller, and must be
+  as large as returned by GetRuntimeVariableCacheInfo().
+
+  @param[in] Context    The buffers of the runtime variable cache.
+
+  @retval EFI_SUCCESS           The runtime variable cache is up to date.
+  @retval EFI_ALREADY_STARTED   The runtime variable cache has been initialized.
+  @retval EFI_ACCESS_DENIED     The cache is being read, it will be updated later.
+
+**/
+EFI_STATUS
+InitRuntimeVariableCache (
+  IN SMM_VARIABLE_COMMUNICATE_RUNTIME_CACHE_CONTEXT  *Context
+  );
+
+/**
+  Mark a variable store as changed, and copy it in the runtime variable cache
+  unless the cache is being read.
+
+  @param[in] Type       Variable store type.
+
+**/
+VOID
+SynchronizeRuntimeVariableCache (
+  IN VARIABLE_STORE_TYPE  Type
+  );
+
+/**
+  Copy the changed variable stores in the runtime variable cache.
+
+  @retval EFI_SUCCESS           The runtime variable cache is up to date.
+  @retval EFI_NOT_READY         There is no runtime variable cache.
+  @retval EFI_ACCESS_DENIED     The cache is being read, it will be updated later.
+
+**/
+EFI_STATUS
+FlushRuntimeVariableCache (
+  VOID
+  );
+
+/**
+
+  Gets the pointer to the first variable header in given variable store area.
+
+  @param VarStoreHeader  Pointer to the Variable Store Header.
+
+  @return Pointer to the first variable header.
+
+**/
+VARIABLE_HEADER *
+GetStartPointer (
+  IN VARIABLE_STORE_HEADER       *VarStoreHeader
+  );
+
 /**
 
   Gets the pointer to the end of the variable storage area.
@@ -207,6 +396,51 @@ GetVariableHeaderSize (
   VOID
   );
 
+/**
+
+  This code checks if variable header is valid or not.
+
+  @param Variable           Pointer to the Variable Header.
+  @param VariableStoreEnd   Pointer to the Variable Store End.
+
+  @retval TRUE              Variable header is valid.
+  @retval FALSE             Variable header is not valid.
+
+**/
+BOOLEAN
+IsValidVariableHeader (
+  IN  VARIABLE_HEADER       *Variable,
+  IN  VARIABLE_HEADER       *VariableStoreEnd
+  );
+
+/**
+
+  This code gets the size of name of variable.
+
+  @param Variable        Pointer to the Variable Header.
+
+  @return UINTN          Size of variable in bytes.
+
+**/
+UINTN
+NameSizeOfVariable (
+  IN  VARIABLE_HEADER   *Variable
+  );
+
+/**
+
+  This code gets the pointer to the next variable header.
+
+  @param Variable        Pointer to the Variable Header.
+
+  @return Pointer to next variable header.
+
+**/
+VARIABLE_HEADER *
+GetNextVariablePtr (
+  IN  VARIABLE_HEADER   *Variable
+  );
+
 /**
 
   This code gets the pointer to the variable name.
@@ -246,6 +246,10 @@ VariableClassAddressChangeEvent (
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase);
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VariableGlobal.VolatileVariableBase);
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->VariableGlobal.HobVariableBase);
+  for (Index = 0; Index < VariableStoreTypeMax; Index++) {
+    EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->HashIndex[Index].Buckets);
+    EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal->HashIndex[Index].Entries);
+  }
   EfiConvertPointer (0x0, (VOID **) &mVariableModuleGlobal);
   EfiConvertPointer (0x0, (VOID **) &mNvVariableCache);
   EfiConvertPointer (0x0, (VOID **) &mNvFvHeaderCache);
@@ -0,0 +1,468 @@
+/** @file
+  Hash index of the variable stores.
+
+  Every variable store (volatile, HOB and the NV cache) has an index that maps
+  the hash of (VendorGuid, VariableName) to the offsets of the variable headers
+  with that name in the store, so that looking a variable up does not walk the
+  whole store. The index holds offsets rather than pointers, so it stays valid
+  across SetVirtualAddressMap().
+
+  Headers are only ever appended to a store, and their state only goes from
+  ADDED to DELETED, so the index is updated when UpdateVariable() appends a
+  header and rebuilt when Reclaim() compacts the store. Headers that are
+  deleted later stay in the index until then and are filtered out on lookup.
+
+  The index of the NV store is initially built from the one published by the
+  PEI variable driver, when it matches the store, which uses the same hash.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Variable.h"
+
+//
+// The index is sized for variables with at least this many bytes of name and
+// data on average. If a store still holds more headers than that, the index
+// is marked invalid and lookups walk the store until the next rebuild.
+//
+#define VARIABLE_HASH_INDEX_PAYLOAD_SIZE  32
+
+#define VARIABLE_HASH_INDEX_END           MAX_UINT32
+
+/**
+  Get the variable store header of a variable store type.
+
+  @param[in] Type   Variable store type.
+
+  @return The variable store header, or NULL if the store does not exist.
+
+**/
+STATIC
+VARIABLE_STORE_HEADER *
+GetHashIndexStore (
+  IN VARIABLE_STORE_TYPE  Type
+  )
+{
+  switch (Type) {
+  case VariableStoreTypeVolatile:
+    return (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  case VariableStoreTypeHob:
+    return (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+  case VariableStoreTypeNv:
+    return mNvVariableCache;
+  default:
+    return NULL;
+  }
+}
+
+/**
+  Compute the hash of a variable name and vendor GUID (32-bit FNV-1a).
+
+  @param[in] VariableName   Name of the variable.
+  @param[in] NameSize       Size of VariableName in bytes, including the
+                            terminating null character.
+  @param[in] VendorGuid     Vendor GUID of the variable.
+
+  @return The hash value.
+
+**/
+STATIC
+UINT32
+VariableHashIndexHash (
+  IN CONST CHAR16    *VariableName,
+  IN UINTN           NameSize,
+  IN CONST EFI_GUID  *VendorGuid
+  )
+{
+  CONST UINT8  *Bytes;
+  UINT32       Hash;
+  UINTN        Index;
+
+  Hash  = 0x811C9DC5;
+  Bytes = (CONST UINT8 *) VendorGuid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Bytes[Index]) * 0x01000193;
+  }
+  Bytes = (CONST UINT8 *) VariableName;
+  for (Index = 0; Index < NameSize; Index++) {
+    Hash = (Hash ^ Bytes[Index]) * 0x01000193;
+  }
+  return Hash;
+}
+
+/**
+  Add a variable header of a store to its hash index, with the hash of its
+  name and vendor GUID.
+
+  @param[in] Type     Variable store type.
+  @param[in] Hash     Hash of the variable name and vendor GUID.
+  @param[in] Offset   Offset of the variable header from the variable store header.
+
+**/
+STATIC
+VOID
+VariableHashIndexAdd (
+  IN VARIABLE_STORE_TYPE  Type,
+  IN UINT32               Hash,
+  IN UINTN                Offset
+  )
+{
+  VARIABLE_HASH_INDEX        *HashIndex;
+  VARIABLE_HASH_INDEX_ENTRY  *Entry;
+  UINT32                     Bucket;
+
+  HashIndex = &mVariableModuleGlobal->HashIndex[Type];
+  if (!HashIndex->Valid) {
+    return;
+  }
+
+  if (HashIndex->UsedCount == HashIndex->EntryCount) {
+    DEBUG ((DEBUG_INFO, "Variable: hash index of store %d is full, falling back to linear search\n", Type));
+    HashIndex->Valid = FALSE;
+    return;
+  }
+
+  Entry         = &HashIndex->Entries[HashIndex->UsedCount];
+  Entry->Hash   = Hash;
+  Entry->Offset = (UINT32) Offset;
+
+  Bucket                     = Entry->Hash & (HashIndex->BucketCount - 1);
+  Entry->Next                = HashIndex->Buckets[Bucket];
+  HashIndex->Buckets[Bucket] = HashIndex->UsedCount;
+  HashIndex->UsedCount++;
+}
+
+/**
+  Add a variable header of a store to its hash index.
+
+  @param[in] Type     Variable store type.
+  @param[in] Offset   Offset of the variable header from the variable store header.
+
+**/
+VOID
+VariableHashIndexInsert (
+  IN VARIABLE_STORE_TYPE  Type,
+  IN UINTN                Offset
+  )
+{
+  VARIABLE_HEADER            *Variable;
+
+  Variable = (VARIABLE_HEADER *) ((UINTN) GetHashIndexStore (Type) + Offset);
+  VariableHashIndexAdd (
+    Type,
+    VariableHashIndexHash (GetVariableNamePtr (Variable), NameSizeOfVariable (Variable), GetVendorGuidPtr (Variable)),
+    Offset
+    );
+}
+
+/**
+  Get the index of the NV variable store built by the PEI variable driver.
+
+  The index is only returned if it still describes mNvVariableCache: the store
+  header must match, the last indexed header must end where the store ends,
+  and every entry must point to a variable header before it. Otherwise the
+  store is walked as if there were no index.
+
+  @return The index of the NV variable store, or NULL if there is no index
+          or it does not match the store.
+
+**/
+VARIABLE_STORE_INDEX *
+GetNvVariableStoreIndex (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE           *GuidHob;
+  VARIABLE_STORE_INDEX        *StoreIndex;
+  VARIABLE_STORE_INDEX_ENTRY  *Entries;
+  VARIABLE_HEADER             *StartPtr;
+  VARIABLE_HEADER             *EndPtr;
+  VARIABLE_HEADER             *Variable;
+  VARIABLE_HEADER             *LastVariable;
+  VARIABLE_HEADER             *EndVariable;
+  UINT32                      Index;
+  UINT32                      LastOffset;
+
+  if (mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
+    return NULL;
+  }
+
+  GuidHob = GetFirstGuidHob (&gEdkiiVariableStoreIndexGuid);
+  if (GuidHob == NULL) {
+    return NULL;
+  }
+  StoreIndex = GET_GUID_HOB_DATA (GuidHob);
+  if (GET_GUID_HOB_DATA_SIZE (GuidHob) < sizeof (VARIABLE_STORE_INDEX) ||
+      StoreIndex->Signature != VARIABLE_STORE_INDEX_SIGNATURE ||
+      StoreIndex->StoreSize == 0) {
+    return NULL;
+  }
+
+  StartPtr    = GetStartPointer (mNvVariableCache);
+  EndPtr      = GetEndPointer (mNvVariableCache);
+  EndVariable = (VARIABLE_HEADER *) ((UINTN) mNvVariableCache + StoreIndex->EndOffset);
+  Entries     = (VARIABLE_STORE_INDEX_ENTRY *) (StoreIndex + 1);
+
+  if (GET_GUID_HOB_DATA_SIZE (GuidHob) < sizeof (VARIABLE_STORE_INDEX) + (UINTN) StoreIndex->EntryCount * sizeof (VARIABLE_STORE_INDEX_ENTRY) ||
+      StoreIndex->StoreSize != mNvVariableCache->Size ||
+      !CompareGuid (&StoreIndex->StoreSignature, &mNvVariableCache->Signature) ||
+      StoreIndex->EndOffset > mNvVariableCache->Size ||
+      EndVariable < StartPtr ||
+      IsValidVariableHeader (EndVariable, EndPtr)) {
+    goto Mismatch;
+  }
+
+  if (StoreIndex->LastOffset == 0) {
+    if (EndVariable != StartPtr || StoreIndex->EntryCount != 0) {
+      goto Mismatch;
+    }
+  } else {
+    LastVariable = (VARIABLE_HEADER *) ((UINTN) mNvVariableCache + StoreIndex->LastOffset);
+    if (LastVariable < StartPtr || LastVariable >= EndVariable ||
+        !IsValidVariableHeader (LastVariable, EndPtr) ||
+        GetNextVariablePtr (LastVariable) != EndVariable) {
+      goto Mismatch;
+    }
+  }
+
+  //
+  // The entries must be in the order of the store, and the hash of the
+  // last one is checked to catch a different hash function.
+  //
+  LastOffset = 0;
+  for (Index = 0; Index < StoreIndex->EntryCount; Index++) {
+    Variable = (VARIABLE_HEADER *) ((UINTN) mNvVariableCache + Entries[Index].Offset);
+    if (Entries[Index].Offset <= LastOffset || Entries[Index].Offset > StoreIndex->LastOffset ||
+        Variable < StartPtr || !IsValidVariableHeader (Variable, EndPtr)) {
+      goto Mismatch;
+    }
+    LastOffset = Entries[Index].Offset;
+  }
+  if (StoreIndex->EntryCount != 0 &&
+      Entries[Index - 1].Hash != VariableHashIndexHash (GetVariableNamePtr (Variable), NameSizeOfVariable (Variable), GetVendorGuidPtr (Variable))) {
+    goto Mismatch;
+  }
+
+  return StoreIndex;
+
+Mismatch:
+  DEBUG ((DEBUG_INFO, "Variable: NV store index from PEI does not match the store, walking the store\n"));
+  return NULL;
+}
+
+/**
+  Rebuild the hash index of a variable store from the headers in the store.
+
+  @param[in] Type   Variable store type.
+
+**/
+VOID
+VariableHashIndexRebuild (
+  IN VARIABLE_STORE_TYPE  Type
+  )
+{
+  VARIABLE_HASH_INDEX    *HashIndex;
+  VARIABLE_STORE_HEADER  *VariableStoreHeader;
+  VARIABLE_HEADER        *Variable;
+
+  HashIndex = &mVariableModuleGlobal->HashIndex[Type];
+  if (HashIndex->Entries == NULL) {
+    return;
+  }
+
+  VariableStoreHeader = GetHashIndexStore (Type);
+  HashIndex->UsedCount = 0;
+  HashIndex->Valid     = (BOOLEAN) (VariableStoreHeader != NULL);
+  SetMem32 (HashIndex->Buckets, HashIndex->BucketCount * sizeof (UINT32), VARIABLE_HASH_INDEX_END);
+  if (VariableStoreHeader == NULL) {
+    return;
+  }
+
+  //
+  // Deleted headers can never become visible again, so only the ADDED and
+  // IN_DELETED_TRANSITION ones need to be indexed.
+  //
+  Variable = GetStartPointer (VariableStoreHeader);
+  while (IsValidVariableHeader (Variable, GetEndPointer (VariableStoreHeader)) && HashIndex->Valid) {
+    if (Variable->State == VAR_ADDED || Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      VariableHashIndexInsert (Type, (UINTN) Variable - (UINTN) VariableStoreHeader);
+    }
+    Variable = GetNextVariablePtr (Variable);
+  }
+}
+
+/**
+  Allocate and build the hash index of every variable store.
+
+  A store whose index can not be allocated is searched linearly.
+
+  @param[in] NvStoreIndex   The index of the NV variable store returned by
+                            GetNvVariableStoreIndex(), the NV hash index is
+                            built from it instead of the store if not NULL.
+
+**/
+VOID
+VariableHashIndexInitialize (
+  IN VARIABLE_STORE_INDEX  *NvStoreIndex OPTIONAL
+  )
+{
+  VARIABLE_STORE_INDEX_ENTRY  *Entries;
+  UINT32                      Index;
+  VARIABLE_STORE_TYPE    Type;
+  VARIABLE_STORE_HEADER  *VariableStoreHeader;
+  VARIABLE_HASH_INDEX    *HashIndex;
+  UINTN                  EntryCount;
+  UINTN                  BucketCount;
+
+  for (Type = (VARIABLE_STORE_TYPE) 0; Type < VariableStoreTypeMax; Type++) {
+    VariableStoreHeader = GetHashIndexStore (Type);
+    if (VariableStoreHeader == NULL) {
+      continue;
+    }
+
+    EntryCount  = (VariableStoreHeader->Size - sizeof (VARIABLE_STORE_HEADER)) /
+                  (GetVariableHeaderSize () + VARIABLE_HASH_INDEX_PAYLOAD_SIZE);
+    EntryCount  = MAX (EntryCount, 1);
+    BucketCount = GetPowerOfTwo32 ((UINT32) EntryCount);
+
+    HashIndex = &mVariableModuleGlobal->HashIndex[Type];
+    HashIndex->Buckets = AllocateRuntimePool (BucketCount * sizeof (UINT32) + EntryCount * sizeof (VARIABLE_HASH_INDEX_ENTRY));
+    if (HashIndex->Buckets == NULL) {
+      continue;
+    }
+    HashIndex->Entries     = (VARIABLE_HASH_INDEX_ENTRY *) (HashIndex->Buckets + BucketCount);
+    HashIndex->BucketCount = (UINT32) BucketCount;
+    HashIndex->EntryCount  = (UINT32) EntryCount;
+
+    if (Type != VariableStoreTypeNv || NvStoreIndex == NULL || NvStoreIndex->EntryCount > HashIndex->EntryCount) {
+      VariableHashIndexRebuild (Type);
+      continue;
+    }
+
+    //
+    // The PEI index holds the same headers in the same order as a rebuild
+    // would insert them, with their hash.
+    //
+    HashIndex->UsedCount = 0;
+    HashIndex->Valid     = TRUE;
+    SetMem32 (HashIndex->Buckets, HashIndex->BucketCount * sizeof (UINT32), VARIABLE_HASH_INDEX_END);
+    Entries = (VARIABLE_STORE_INDEX_ENTRY *) (NvStoreIndex + 1);
+    for (Index = 0; Index < NvStoreIndex->EntryCount; Index++) {
+      VariableHashIndexAdd (Type, Entries[Index].Hash, Entries[Index].Offset);
+    }
+  }
+}
+
+/**
+  Find the variable in the specified variable store with its hash index.
+
+  The result is the same as the one of walking the store in FindVariableEx():
+  the first ADDED variable with the name, and the IN_DELETED_TRANSITION one
+  found before it, or the last IN_DELETED_TRANSITION one if there is no ADDED
+  one.
+
+  @param[in]       VariableName        Name of the variable to be found, not empty.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+
+  @retval          EFI_SUCCESS         Variable found successfully
+  @retval          EFI_NOT_FOUND       Variable not found
+  @retval          EFI_UNSUPPORTED     The range of PtrTrack is not an indexed store,
+                                       the store must be searched linearly.
+**/
+EFI_STATUS
+FindVariableByHashIndex (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  VARIABLE_STORE_TYPE        Type;
+  VARIABLE_STORE_HEADER      *VariableStoreHeader;
+  VARIABLE_HASH_INDEX        *HashIndex;
+  VARIABLE_HASH_INDEX_ENTRY  *Entry;
+  VARIABLE_HEADER            *Variable;
+  VARIABLE_HEADER            *AddedVariable;
+  VARIABLE_HEADER            *InDeletedVariable;
+  UINT32                     Hash;
+  UINT32                     Index;
+  UINT8                      Pass;
+
+  if (mVariableModuleGlobal == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  for (Type = (VARIABLE_STORE_TYPE) 0; Type < VariableStoreTypeMax; Type++) {
+    VariableStoreHeader = GetHashIndexStore (Type);
+    if (VariableStoreHeader != NULL &&
+        PtrTrack->StartPtr == GetStartPointer (VariableStoreHeader) &&
+        PtrTrack->EndPtr == GetEndPointer (VariableStoreHeader)) {
+      break;
+    }
+  }
+  if (Type == VariableStoreTypeMax || !mVariableModuleGlobal->HashIndex[Type].Valid) {
+    return EFI_UNSUPPORTED;
+  }
+
+  HashIndex = &mVariableModuleGlobal->HashIndex[Type];
+  Hash      = VariableHashIndexHash (VariableName, StrSize (VariableName), VendorGuid);
+
+  //
+  // A bucket lists the headers from the last appended one to the first one.
+  // The first pass finds the first ADDED header, the second one the last
+  // IN_DELETED_TRANSITION header before it.
+  //
+  AddedVariable     = NULL;
+  InDeletedVariable = NULL;
+  for (Pass = 0; Pass < 2; Pass++) {
+    for (Index = HashIndex->Buckets[Hash & (HashIndex->BucketCount - 1)];
+         Index != VARIABLE_HASH_INDEX_END;
+         Index = Entry->Next) {
+      Entry = &HashIndex->Entries[Index];
+      if (Entry->Hash != Hash) {
+        continue;
+      }
+
+      Variable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Entry->Offset);
+      if (Pass == 0 && Variable->State != VAR_ADDED) {
+        continue;
+      }
+      if (Pass == 1 && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED) ||
+                        (AddedVariable != NULL && Variable > AddedVariable) ||
+                        (InDeletedVariable != NULL && Variable < InDeletedVariable))) {
+        continue;
+      }
+      if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+        continue;
+      }
+      if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable))) {
+        continue;
+      }
+      ASSERT (NameSizeOfVariable (Variable) != 0);
+      if (CompareMem (VariableName, GetVariableNamePtr (Variable), NameSizeOfVariable (Variable)) != 0) {
+        continue;
+      }
+
+      if (Pass == 0) {
+        AddedVariable = Variable;
+      } else {
+        InDeletedVariable = Variable;
+      }
+    }
+  }
+
+  if (AddedVariable != NULL) {
+    PtrTrack->CurrPtr                = AddedVariable;
+    PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+    return EFI_SUCCESS;
+  }
+
+  PtrTrack->CurrPtr                = InDeletedVariable;
+  PtrTrack->InDeletedTransitionPtr = NULL;
+  return (PtrTrack->CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
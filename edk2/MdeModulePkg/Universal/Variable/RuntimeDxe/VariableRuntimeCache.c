@@ -0,0 +1,242 @@
+/** @file
+  Runtime cache of the variable stores.
+
+  The SMM variable runtime driver allocates a copy of the HOB, volatile and
+  non-volatile variable stores in runtime memory, and GetVariable() searches
+  that copy without an SMI. Whenever a store changes in SMM, the bytes in use
+  before and after the change are copied to the runtime cache, so that space
+  released by Reclaim() is erased in the copy as well.
+
+  The runtime driver sets ReadLock while it reads the cache. An SMI that
+  changes a store in that window only marks the store dirty and sets
+  PendingUpdate; the runtime driver then requests the copy with
+  SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE before its next read.
+
+  The non-SMM variable driver never initializes the cache, so everything here
+  is a no-op in it.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "Variable.h"
+
+/**
+  Get the variable store header of a variable store type.
+
+  @param[in] Type   Variable store type.
+
+  @return The variable store header, or NULL if the store does not exist.
+
+**/
+STATIC
+VARIABLE_STORE_HEADER *
+GetRuntimeCacheSourceStore (
+  IN VARIABLE_STORE_TYPE  Type
+  )
+{
+  switch (Type) {
+  case VariableStoreTypeVolatile:
+    return (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  case VariableStoreTypeHob:
+    return (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+  case VariableStoreTypeNv:
+    return mNvVariableCache;
+  default:
+    return NULL;
+  }
+}
+
+/**
+  Get the number of bytes in use in a variable store, from the store header
+  to the end of the last variable.
+
+  @param[in] Type   Variable store type.
+  @param[in] Store  The variable store header.
+
+  @return The number of bytes in use.
+
+**/
+STATIC
+UINTN
+GetRuntimeCacheSourceLength (
+  IN VARIABLE_STORE_TYPE    Type,
+  IN VARIABLE_STORE_HEADER  *Store
+  )
+{
+  switch (Type) {
+  case VariableStoreTypeVolatile:
+    return mVariableModuleGlobal->VolatileLastVariableOffset;
+  case VariableStoreTypeNv:
+    return mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  default:
+    //
+    // The HOB store only changes when it is flushed, copy all of it.
+    //
+    return Store->Size;
+  }
+}
+
+/**
+  Get the sizes of the variable stores to be copied in the runtime variable cache.
+
+  @param[out] Info      The store sizes and the variable header format.
+
+**/
+VOID
+GetRuntimeVariableCacheInfo (
+  OUT SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO  *Info
+  )
+{
+  VARIABLE_STORE_HEADER  *Store;
+
+  Store = GetRuntimeCacheSourceStore (VariableStoreTypeHob);
+  Info->HobStoreSize      = (Store == NULL) ? 0 : Store->Size;
+  Store = GetRuntimeCacheSourceStore (VariableStoreTypeNv);
+  Info->NvStoreSize       = Store->Size;
+  Store = GetRuntimeCacheSourceStore (VariableStoreTypeVolatile);
+  Info->VolatileStoreSize = Store->Size;
+  Info->AuthFormat        = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+}
+
+/**
+  Start to copy the variable stores in the runtime variable cache.
+
+  The buffers of Context must have been checked by the caller, and must be
+  as large as returned by GetRuntimeVariableCacheInfo().
+
+  @param[in] Context    The buffers of the runtime variable cache.
+
+  @retval EFI_SUCCESS           The runtime variable cache is up to date.
+  @retval EFI_ALREADY_STARTED   The runtime variable cache has been initialized.
+  @retval EFI_ACCESS_DENIED     The cache is being read, it will be updated later.
+
+**/
+EFI_STATUS
+InitRuntimeVariableCache (
+  IN SMM_VARIABLE_COMMUNICATE_RUNTIME_CACHE_CONTEXT  *Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *RuntimeCache;
+  VARIABLE_STORE_HEADER           *Buffer[VariableStoreTypeMax];
+  VARIABLE_STORE_HEADER           *Store;
+  VARIABLE_STORE_TYPE             Type;
+
+  RuntimeCache = &mVariableModuleGlobal->RuntimeCache;
+  if (RuntimeCache->Control != NULL) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  Buffer[VariableStoreTypeVolatile] = Context->VolatileStore;
+  Buffer[VariableStoreTypeHob]      = Context->HobStore;
+  Buffer[VariableStoreTypeNv]       = Context->NvStore;
+
+  for (Type = (VARIABLE_STORE_TYPE) 0; Type < VariableStoreTypeMax; Type++) {
+    Store = GetRuntimeCacheSourceStore (Type);
+    if (Store == NULL || Buffer[Type] == NULL) {
+      RuntimeCache->Cache[Type].Store = NULL;
+      continue;
+    }
+    //
+    // Copy the whole store the first time.
+    //
+    RuntimeCache->Cache[Type].Store  = Buffer[Type];
+    RuntimeCache->Cache[Type].Size   = Store->Size;
+    RuntimeCache->Cache[Type].Length = Store->Size;
+    RuntimeCache->Cache[Type].Dirty  = TRUE;
+  }
+
+  RuntimeCache->Control                   = Context->Control;
+  RuntimeCache->Control->ReadLock         = FALSE;
+  RuntimeCache->Control->PendingUpdate    = FALSE;
+  RuntimeCache->Control->HobFlushComplete = (BOOLEAN) (RuntimeCache->Cache[VariableStoreTypeHob].Store == NULL);
+
+  return FlushRuntimeVariableCache ();
+}
+
+/**
+  Copy the changed variable stores in the runtime variable cache.
+
+  @retval EFI_SUCCESS           The runtime variable cache is up to date.
+  @retval EFI_NOT_READY         There is no runtime variable cache.
+  @retval EFI_ACCESS_DENIED     The cache is being read, it will be updated later.
+
+**/
+EFI_STATUS
+FlushRuntimeVariableCache (
+  VOID
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *RuntimeCache;
+  VARIABLE_RUNTIME_CACHE          *Cache;
+  VARIABLE_STORE_HEADER           *Store;
+  VARIABLE_STORE_TYPE             Type;
+  UINTN                           Length;
+
+  RuntimeCache = &mVariableModuleGlobal->RuntimeCache;
+  if (RuntimeCache->Control == NULL) {
+    return EFI_NOT_READY;
+  }
+
+  if (RuntimeCache->Control->ReadLock) {
+    RuntimeCache->Control->PendingUpdate = TRUE;
+    return EFI_ACCESS_DENIED;
+  }
+
+  for (Type = (VARIABLE_STORE_TYPE) 0; Type < VariableStoreTypeMax; Type++) {
+    Cache = &RuntimeCache->Cache[Type];
+    if (Cache->Store == NULL || !Cache->Dirty) {
+      continue;
+    }
+
+    Store = GetRuntimeCacheSourceStore (Type);
+    if (Store == NULL) {
+      //
+      // HobVariableBase is cleared while FlushHobVariableToFlash() runs.
+      //
+      continue;
+    }
+
+    Length = GetRuntimeCacheSourceLength (Type, Store);
+    CopyMem (Cache->Store, Store, MIN (MAX (Cache->Length, Length), Cache->Size));
+    Cache->Length = Length;
+    Cache->Dirty  = FALSE;
+  }
+
+  RuntimeCache->Control->PendingUpdate = FALSE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Mark a variable store as changed, and copy it in the runtime variable cache
+  unless the cache is being read.
+
+  @param[in] Type       Variable store type.
+
+**/
+VOID
+SynchronizeRuntimeVariableCache (
+  IN VARIABLE_STORE_TYPE  Type
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *RuntimeCache;
+
+  RuntimeCache = &mVariableModuleGlobal->RuntimeCache;
+  if (RuntimeCache->Control == NULL || RuntimeCache->Cache[Type].Store == NULL) {
+    return;
+  }
+
+  if (Type == VariableStoreTypeHob && GetRuntimeCacheSourceStore (Type) == NULL) {
+    //
+    // All HOB variables have been flushed to the NV store, and the copy of the
+    // HOB store must not be searched any more.
+    //
+    RuntimeCache->Cache[Type].Store         = NULL;
+    RuntimeCache->Control->HobFlushComplete = TRUE;
+    return;
+  }
+
+  RuntimeCache->Cache[Type].Dirty = TRUE;
+  FlushRuntimeVariableCache ();
+}
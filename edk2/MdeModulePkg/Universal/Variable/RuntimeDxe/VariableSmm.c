@@ -465,6 +465,9 @@ SmmVariableHandler (
   VARIABLE_INFO_ENTRY                              *VariableInfo;
   SMM_VARIABLE_COMMUNICATE_LOCK_VARIABLE           *VariableToLock;
   SMM_VARIABLE_COMMUNICATE_VAR_CHECK_VARIABLE_PROPERTY *CommVariableProperty;
+  SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO  *RuntimeCacheInfo;
+  SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO  StoreInfo;
+  SMM_VARIABLE_COMMUNICATE_RUNTIME_CACHE_CONTEXT   RuntimeCacheContext;
   UINTN                                            InfoSize;
   UINTN                                            NameBufferSize;
   UINTN                                            CommBufferPayloadSize;
@@ -674,6 +677,69 @@ SmmVariableHandler (
       Status = EFI_SUCCESS;
       break;
 
+    case SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO:
+      if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO)) {
+        DEBUG ((EFI_D_ERROR, "GetRuntimeCacheInfo: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+      RuntimeCacheInfo = (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO *) SmmVariableFunctionHeader->Data;
+      GetRuntimeVariableCacheInfo (RuntimeCacheInfo);
+      Status = EFI_SUCCESS;
+      break;
+
+    case SMM_VARIABLE_FUNCTION_INIT_RUNTIME_CACHE:
+      if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_RUNTIME_CACHE_CONTEXT)) {
+        DEBUG ((EFI_D_ERROR, "InitRuntimeCache: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+      if (mEndOfDxe) {
+        Status = EFI_ACCESS_DENIED;
+        break;
+      }
+      //
+      // Copy the buffer pointers to SMRAM, so that the buffers written later
+      // are the ones checked here.
+      //
+      CopyMem (&RuntimeCacheContext, SmmVariableFunctionHeader->Data, sizeof (RuntimeCacheContext));
+      GetRuntimeVariableCacheInfo (&StoreInfo);
+      if (RuntimeCacheContext.Control == NULL ||
+          RuntimeCacheContext.NvStore == NULL ||
+          RuntimeCacheContext.VolatileStore == NULL ||
+          !VariableSmmIsBufferOutsideSmmValid ((UINTN) RuntimeCacheContext.Control, sizeof (SMM_VARIABLE_RUNTIME_CACHE_CONTROL)) ||
+          !VariableSmmIsBufferOutsideSmmValid ((UINTN) RuntimeCacheContext.NvStore, StoreInfo.NvStoreSize) ||
+          !VariableSmmIsBufferOutsideSmmValid ((UINTN) RuntimeCacheContext.VolatileStore, StoreInfo.VolatileStoreSize)) {
+        DEBUG ((EFI_D_ERROR, "InitRuntimeCache: runtime cache buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        break;
+      }
+      if (StoreInfo.HobStoreSize == 0) {
+        //
+        // The HOB store may have been flushed since its size was reported.
+        //
+        RuntimeCacheContext.HobStore = NULL;
+      } else if (RuntimeCacheContext.HobStore == NULL ||
+                 !VariableSmmIsBufferOutsideSmmValid ((UINTN) RuntimeCacheContext.HobStore, StoreInfo.HobStoreSize)) {
+        DEBUG ((EFI_D_ERROR, "InitRuntimeCache: runtime cache buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        break;
+      }
+
+      //
+      // The VariableSpeculationBarrier() call here is to ensure the previous
+      // range checks for the cache buffers have been completed before the
+      // buffers are written.
+      //
+      VariableSpeculationBarrier ();
+      Status = InitRuntimeVariableCache (&RuntimeCacheContext);
+      if (Status == EFI_ACCESS_DENIED) {
+        Status = EFI_SUCCESS;
+      }
+      break;
+
+    case SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE:
+      Status = FlushRuntimeVariableCache ();
+      break;
+
     case SMM_VARIABLE_FUNCTION_READY_TO_BOOT:
       if (AtRuntime()) {
         Status = EFI_UNSUPPORTED;
@@ -34,6 +34,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugLib.h>
 #include <Library/UefiLib.h>
 #include <Library/BaseLib.h>
+#include <Library/PcdLib.h>
 
 #include <Guid/EventGroup.h>
 #include <Guid/SmmVariableCommon.h>
@@ -52,6 +53,28 @@ EFI_LOCK                         mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL     mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL         mVarCheck;
 
+//
+// Runtime copy of the variable stores, updated by the SMM variable driver.
+//
+BOOLEAN                          mVariableRuntimeCacheReady      = FALSE;
+BOOLEAN                          mVariableRuntimeCacheAuthFormat = FALSE;
+volatile SMM_VARIABLE_RUNTIME_CACHE_CONTROL *mVariableRuntimeCacheControl = NULL;
+VARIABLE_STORE_HEADER           *mVariableRuntimeHobCache        = NULL;
+VARIABLE_STORE_HEADER           *mVariableRuntimeNvCache         = NULL;
+VARIABLE_STORE_HEADER           *mVariableRuntimeVolatileCache   = NULL;
+
+///
+/// A variable parsed from the runtime variable cache.
+///
+typedef struct {
+  VARIABLE_HEADER   *Header;
+  CHAR16            *Name;
+  UINTN             NameSize;
+  EFI_GUID          *VendorGuid;
+  UINT8             *Data;
+  UINTN             DataSize;
+} RUNTIME_CACHE_VARIABLE;
+
 /**
   Some Secure Boot Policy Variable may update following other variable changes(SecureBoot follows PK change, etc).
   Record their initial State when variable write service is ready.
@@ -425,7 +448,8 @@ Done:
 }
 
 /**
-  This code finds variable in storage blocks (Volatile or Non-Volatile).
+  This code finds variable in storage blocks (Volatile or Non-Volatile) with
+  the SMM variable driver.
 
   Caution: This function may receive untrusted input.
   The data size is external input, so this function will validate it carefully to avoid buffer overflow.
@@ -444,8 +468,7 @@ Done:
 
 **/
 EFI_STATUS
-EFIAPI
-RuntimeServiceGetVariable (
+FindVariableInSmm (
   IN      CHAR16                            *VariableName,
   IN      EFI_GUID                          *VendorGuid,
   OUT     UINT32                            *Attributes OPTIONAL,
@@ -459,10 +482,6 @@ RuntimeServiceGetVariable (
   UINTN                                     TempDataSize;
   UINTN                                     VariableNameSize;
 
-  if (VariableName == NULL || VendorGuid == NULL || DataSize == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
   TempDataSize          = *DataSize;
   VariableNameSize      = StrSize (VariableName);
   SmmVariableHeader     = NULL;
@@ -474,8 +493,6 @@ RuntimeServiceGetVariable (
     return EFI_INVALID_PARAMETER;
   }
 
-  AcquireLockOnlyAtBootTime(&mVariableServicesLock);
-
   //
   // Init the communicate buffer. The buffer data size is:
   // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE + PayloadSize.
@@ -534,7 +551,287 @@ RuntimeServiceGetVariable (
   }
 
 Done:
+  return Status;
+}
+
+/**
+  Parse a variable header in the runtime variable cache.
+
+  @param[in]  Variable      The variable header.
+  @param[in]  StoreEnd      End of the variable store.
+  @param[out] Info          The name and data of the variable.
+  @param[out] NextVariable  The next variable header.
+
+  @retval TRUE              Variable is a variable header that fits in the store.
+  @retval FALSE             Variable is the end of the variables in the store.
+
+**/
+STATIC
+BOOLEAN
+GetRuntimeCacheVariable (
+  IN  VARIABLE_HEADER         *Variable,
+  IN  VARIABLE_HEADER         *StoreEnd,
+  OUT RUNTIME_CACHE_VARIABLE  *Info,
+  OUT VARIABLE_HEADER         **NextVariable
+  )
+{
+  AUTHENTICATED_VARIABLE_HEADER  *AuthVariable;
+  UINTN                          HeaderSize;
+  UINT32                         NameSize;
+  UINT32                         DataSize;
+  UINTN                          Limit;
+
+  if (mVariableRuntimeCacheAuthFormat) {
+    HeaderSize = sizeof (AUTHENTICATED_VARIABLE_HEADER);
+  } else {
+    HeaderSize = sizeof (VARIABLE_HEADER);
+  }
+
+  if ((UINTN) Variable >= (UINTN) StoreEnd ||
+      (UINTN) StoreEnd - (UINTN) Variable < HeaderSize ||
+      Variable->StartId != VARIABLE_DATA) {
+    return FALSE;
+  }
+
+  if (mVariableRuntimeCacheAuthFormat) {
+    AuthVariable     = (AUTHENTICATED_VARIABLE_HEADER *) Variable;
+    NameSize         = AuthVariable->NameSize;
+    DataSize         = AuthVariable->DataSize;
+    Info->VendorGuid = &AuthVariable->VendorGuid;
+  } else {
+    NameSize         = Variable->NameSize;
+    DataSize         = Variable->DataSize;
+    Info->VendorGuid = &Variable->VendorGuid;
+  }
+
+  //
+  // A header that was only partially written has no name and data.
+  //
+  if (Variable->State == (UINT8) (-1) ||
+      Variable->Attributes == (UINT32) (-1) ||
+      NameSize == (UINT32) (-1) ||
+      DataSize == (UINT32) (-1)) {
+    NameSize = 0;
+    DataSize = 0;
+  }
+
+  Info->Header = Variable;
+  Info->Name   = (CHAR16 *) ((UINTN) Variable + HeaderSize);
+  Limit        = (UINTN) StoreEnd - (UINTN) Info->Name;
+  if (NameSize > Limit || GET_PAD_SIZE (NameSize) > Limit - NameSize) {
+    return FALSE;
+  }
+  Limit -= NameSize + GET_PAD_SIZE (NameSize);
+  if (DataSize > Limit) {
+    return FALSE;
+  }
+
+  Info->NameSize = NameSize;
+  Info->Data     = (UINT8 *) Info->Name + NameSize + GET_PAD_SIZE (NameSize);
+  Info->DataSize = DataSize;
+  *NextVariable  = (VARIABLE_HEADER *) HEADER_ALIGN ((UINTN) Info->Data + DataSize + GET_PAD_SIZE (DataSize));
+  return TRUE;
+}
+
+/**
+  Find a variable in one variable store of the runtime variable cache.
+
+  A variable in the ADDED state is preferred over one IN_DELETED_TRANSITION,
+  the same way as in the SMM variable driver.
+
+  @param[in]  Store             The variable store in the runtime variable cache.
+  @param[in]  VariableName      Name of Variable to be found.
+  @param[in]  VariableNameSize  Size of VariableName in bytes, including the terminating null character.
+  @param[in]  VendorGuid        Variable vendor GUID.
+  @param[in]  AtRuntime         Only variables with EFI_VARIABLE_RUNTIME_ACCESS are visible.
+  @param[out] Found             The variable found.
+
+  @retval TRUE                  The variable was found.
+  @retval FALSE                 The variable is not in this store.
+
+**/
+STATIC
+BOOLEAN
+FindVariableInRuntimeCacheStore (
+  IN  VARIABLE_STORE_HEADER   *Store,
+  IN  CHAR16                  *VariableName,
+  IN  UINTN                   VariableNameSize,
+  IN  EFI_GUID                *VendorGuid,
+  IN  BOOLEAN                 AtRuntime,
+  OUT RUNTIME_CACHE_VARIABLE  *Found
+  )
+{
+  VARIABLE_HEADER         *Variable;
+  VARIABLE_HEADER         *NextVariable;
+  VARIABLE_HEADER         *StoreEnd;
+  RUNTIME_CACHE_VARIABLE  Current;
+  BOOLEAN                 InDeletedFound;
+
+  InDeletedFound = FALSE;
+  StoreEnd       = (VARIABLE_HEADER *) ((UINTN) Store + Store->Size);
+
+  for ( Variable = (VARIABLE_HEADER *) HEADER_ALIGN (Store + 1)
+      ; GetRuntimeCacheVariable (Variable, StoreEnd, &Current, &NextVariable)
+      ; Variable = NextVariable
+      ) {
+    if (Variable->State != VAR_ADDED &&
+        Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      continue;
+    }
+    if (AtRuntime && (Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0) {
+      continue;
+    }
+    if (Current.NameSize != VariableNameSize ||
+        !CompareGuid (VendorGuid, Current.VendorGuid) ||
+        CompareMem (VariableName, Current.Name, VariableNameSize) != 0) {
+      continue;
+    }
+
+    CopyMem (Found, &Current, sizeof (Current));
+    if (Variable->State == VAR_ADDED) {
+      return TRUE;
+    }
+    InDeletedFound = TRUE;
+  }
+
+  return InDeletedFound;
+}
+
+/**
+  This code finds variable in storage blocks (Volatile or Non-Volatile) in
+  the runtime variable cache, without an SMI unless an update of the cache
+  was deferred.
+
+  @param[in]      VariableName       Name of Variable to be found.
+  @param[in]      VendorGuid         Variable vendor GUID.
+  @param[out]     Attributes         Attribute value of the variable found.
+  @param[in, out] DataSize           Size of Data found. If size is less than the
+                                     data, this value contains the required size.
+  @param[out]     Data               Data pointer.
+
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_SUCCESS                Find the specified variable.
+  @retval EFI_NOT_FOUND              Not found.
+  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+
+**/
+EFI_STATUS
+FindVariableInRuntimeCache (
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid,
+  OUT     UINT32                            *Attributes OPTIONAL,
+  IN OUT  UINTN                             *DataSize,
+  OUT     VOID                              *Data
+  )
+{
+  EFI_STATUS                                Status;
+  VARIABLE_STORE_HEADER                     *Stores[3];
+  RUNTIME_CACHE_VARIABLE                    Variable;
+  UINTN                                     VariableNameSize;
+  UINTN                                     Index;
+  BOOLEAN                                   AtRuntime;
+  BOOLEAN                                   Found;
+
+  //
+  // SMM could not update the cache while it was read last time, ask it to.
+  //
+  if (mVariableRuntimeCacheControl->PendingUpdate) {
+    InitCommunicateBuffer (NULL, 0, SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE);
+    SendCommunicateBuffer (0);
+    if (mVariableRuntimeCacheControl->PendingUpdate) {
+      return FindVariableInSmm (VariableName, VendorGuid, Attributes, DataSize, Data);
+    }
+  }
+
+  //
+  // Same search order as in the SMM variable driver.
+  //
+  Stores[0] = mVariableRuntimeVolatileCache;
+  Stores[1] = mVariableRuntimeCacheControl->HobFlushComplete ? NULL : mVariableRuntimeHobCache;
+  Stores[2] = mVariableRuntimeNvCache;
+
+  VariableNameSize = StrSize (VariableName);
+  AtRuntime        = EfiAtRuntime ();
+  Found            = FALSE;
+
+  mVariableRuntimeCacheControl->ReadLock = TRUE;
+  MemoryFence ();
+
+  for (Index = 0; Index < ARRAY_SIZE (Stores) && !Found; Index++) {
+    if (Stores[Index] != NULL) {
+      Found = FindVariableInRuntimeCacheStore (Stores[Index], VariableName, VariableNameSize, VendorGuid, AtRuntime, &Variable);
+    }
+  }
+
+  if (!Found) {
+    Status = EFI_NOT_FOUND;
+  } else if (*DataSize < Variable.DataSize) {
+    *DataSize = Variable.DataSize;
+    Status    = EFI_BUFFER_TOO_SMALL;
+  } else if (Data == NULL) {
+    Status = EFI_INVALID_PARAMETER;
+  } else {
+    CopyMem (Data, Variable.Data, Variable.DataSize);
+    *DataSize = Variable.DataSize;
+    if (Attributes != NULL) {
+      *Attributes = Variable.Header->Attributes;
+    }
+    Status = EFI_SUCCESS;
+  }
+
+  MemoryFence ();
+  mVariableRuntimeCacheControl->ReadLock = FALSE;
+
+  return Status;
+}
+
+/**
+  This code finds variable in storage blocks (Volatile or Non-Volatile).
+
+  Caution: This function may receive untrusted input.
+  The data size is external input, so this function will validate it carefully to avoid buffer overflow.
+
+  @param[in]      VariableName       Name of Variable to be found.
+  @param[in]      VendorGuid         Variable vendor GUID.
+  @param[out]     Attributes         Attribute value of the variable found.
+  @param[in, out] DataSize           Size of Data found. If size is less than the
+                                     data, this value contains the required size.
+  @param[out]     Data               Data pointer.
+
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_SUCCESS                Find the specified variable.
+  @retval EFI_NOT_FOUND              Not found.
+  @retval EFI_BUFFER_TO_SMALL        DataSize is too small for the result.
+
+**/
+EFI_STATUS
+EFIAPI
+RuntimeServiceGetVariable (
+  IN      CHAR16                            *VariableName,
+  IN      EFI_GUID                          *VendorGuid,
+  OUT     UINT32                            *Attributes OPTIONAL,
+  IN OUT  UINTN                             *DataSize,
+  OUT     VOID                              *Data
+  )
+{
+  EFI_STATUS                                Status;
+
+  if (VariableName == NULL || VendorGuid == NULL || DataSize == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (VariableName[0] == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  AcquireLockOnlyAtBootTime(&mVariableServicesLock);
+  if (mVariableRuntimeCacheReady) {
+    Status = FindVariableInRuntimeCache (VariableName, VendorGuid, Attributes, DataSize, Data);
+  } else {
+    Status = FindVariableInSmm (VariableName, VendorGuid, Attributes, DataSize, Data);
+  }
   ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
+
   return Status;
 }
 
@@ -893,6 +1190,10 @@ VariableAddressChangeEvent (
 {
   EfiConvertPointer (0x0, (VOID **) &mVariableBuffer);
   EfiConvertPointer (0x0, (VOID **) &mSmmCommunication);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeCacheControl);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeHobCache);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeNvCache);
+  EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeVolatileCache);
 }
 
 /**
@@ -969,6 +1270,83 @@ Done:
   return Status;
 }
 
+/**
+  Allocate the runtime variable cache and hand it to the SMM variable driver.
+
+  GetVariable() keeps calling the SMM variable driver if this fails.
+
+**/
+VOID
+InitVariableRuntimeCache (
+  VOID
+  )
+{
+  EFI_STATUS                                       Status;
+  SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO  *CacheInfo;
+  SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO  Info;
+  SMM_VARIABLE_COMMUNICATE_RUNTIME_CACHE_CONTEXT   *CacheContext;
+
+  Status = InitCommunicateBuffer ((VOID **) &CacheInfo, sizeof (*CacheInfo), SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+  Status = SendCommunicateBuffer (sizeof (*CacheInfo));
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "Variable runtime cache is not supported - %r\n", Status));
+    return;
+  }
+  CopyMem (&Info, CacheInfo, sizeof (Info));
+
+  mVariableRuntimeCacheControl  = AllocateRuntimeZeroPool (sizeof (SMM_VARIABLE_RUNTIME_CACHE_CONTROL));
+  mVariableRuntimeNvCache       = AllocateRuntimePages (EFI_SIZE_TO_PAGES (Info.NvStoreSize));
+  mVariableRuntimeVolatileCache = AllocateRuntimePages (EFI_SIZE_TO_PAGES (Info.VolatileStoreSize));
+  if (Info.HobStoreSize != 0) {
+    mVariableRuntimeHobCache    = AllocateRuntimePages (EFI_SIZE_TO_PAGES (Info.HobStoreSize));
+  }
+  if (mVariableRuntimeCacheControl == NULL ||
+      mVariableRuntimeNvCache == NULL ||
+      mVariableRuntimeVolatileCache == NULL ||
+      (Info.HobStoreSize != 0 && mVariableRuntimeHobCache == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Status = InitCommunicateBuffer ((VOID **) &CacheContext, sizeof (*CacheContext), SMM_VARIABLE_FUNCTION_INIT_RUNTIME_CACHE);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+  CacheContext->Control       = (SMM_VARIABLE_RUNTIME_CACHE_CONTROL *) mVariableRuntimeCacheControl;
+  CacheContext->HobStore      = mVariableRuntimeHobCache;
+  CacheContext->NvStore       = mVariableRuntimeNvCache;
+  CacheContext->VolatileStore = mVariableRuntimeVolatileCache;
+  Status = SendCommunicateBuffer (sizeof (*CacheContext));
+
+Done:
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Variable runtime cache is disabled - %r\n", Status));
+    if (mVariableRuntimeCacheControl != NULL) {
+      FreePool ((VOID *) mVariableRuntimeCacheControl);
+      mVariableRuntimeCacheControl = NULL;
+    }
+    if (mVariableRuntimeNvCache != NULL) {
+      FreePages (mVariableRuntimeNvCache, EFI_SIZE_TO_PAGES (Info.NvStoreSize));
+      mVariableRuntimeNvCache = NULL;
+    }
+    if (mVariableRuntimeVolatileCache != NULL) {
+      FreePages (mVariableRuntimeVolatileCache, EFI_SIZE_TO_PAGES (Info.VolatileStoreSize));
+      mVariableRuntimeVolatileCache = NULL;
+    }
+    if (mVariableRuntimeHobCache != NULL) {
+      FreePages (mVariableRuntimeHobCache, EFI_SIZE_TO_PAGES (Info.HobStoreSize));
+      mVariableRuntimeHobCache = NULL;
+    }
+    return;
+  }
+
+  mVariableRuntimeCacheAuthFormat = Info.AuthFormat;
+  mVariableRuntimeCacheReady      = TRUE;
+}
+
 /**
   Initialize variable service and install Variable Architectural protocol.
 
@@ -1007,6 +1385,10 @@ SmmVariableReady (
   //
   mVariableBufferPhysical = mVariableBuffer;
 
+  if (FeaturePcdGet (PcdEnableVariableRuntimeCache)) {
+    InitVariableRuntimeCache ();
+  }
+
   gRT->GetVariable         = RuntimeServiceGetVariable;
   gRT->GetNextVariableName = RuntimeServiceGetNextVariableName;
   gRT->SetVariable         = RuntimeServiceSetVariable;
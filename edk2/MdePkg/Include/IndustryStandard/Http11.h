@@ -76,6 +76,20 @@
 ///
 #define HTTP_HEADER_ACCEPT_RANGES      "Accept-Ranges"
 
+///
+/// Range Request Header
+/// The Range request-header field requests only the given byte ranges
+/// of the entity, as in "bytes=0-499".
+///
+#define HTTP_HEADER_RANGE              "Range"
+
+///
+/// Content-Range Header
+/// The Content-Range entity-header field is sent with a partial entity-body
+/// to specify where in the full entity-body it belongs, as in "bytes 0-499/1234".
+///
+#define HTTP_HEADER_CONTENT_RANGE      "Content-Range"
+
 
 ///
 /// Accept-Encoding Request Header
@@ -205,6 +219,14 @@
 ///
 #define HTTP_HEADER_IF_NONE_MATCH     "If-None-Match"
 
+///
+/// The If-Modified-Since request-header field is used with a method to make it
+/// conditional: if the requested variant has not been modified since the time
+/// specified in this field, the server returns a 304 (not modified) response
+/// without any message-body.
+///
+#define HTTP_HEADER_IF_MODIFIED_SINCE "If-Modified-Since"
+
 
 
 ///
@@ -222,6 +244,13 @@
 ///
 #define HTTP_HEADER_ETAG              "ETag"
 
+///
+/// Last-Modified Response Header
+/// The Last-Modified entity-header field indicates the date and time at
+/// which the origin server believes the variant was last modified.
+///
+#define HTTP_HEADER_LAST_MODIFIED     "Last-Modified"
+
 ///
 /// Custom header field checked by the iLO web server to
 /// specify a client session key.
@@ -580,21 +580,24 @@ HttpBootHttpIoCallback (
 }
 
 /**
-  Create a HttpIo instance for the file download.
+  Create a HttpIo instance on the station address of the driver.
 
   @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    Callback       Callback function of the HttpIo, or NULL.
+  @param[out]   HttpIo         The HttpIo instance to create.
 
   @retval EFI_SUCCESS          Successfully created.
   @retval Others               Failed to create HttpIo.
 
 **/
 EFI_STATUS
-HttpBootCreateHttpIo (
-  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+HttpBootOpenHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_IO_CALLBACK             Callback  OPTIONAL,
+     OUT HTTP_IO                      *HttpIo
   )
 {
   HTTP_IO_CONFIG_DATA          ConfigData;
-  EFI_STATUS                   Status;
   EFI_HANDLE                   ImageHandle;
 
   ASSERT (Private != NULL);
@@ -613,15 +616,34 @@ HttpBootCreateHttpIo (
     ImageHandle = Private->Ip6Nic->ImageHandle;
   }
 
-  Status = HttpIoCreateIo (
-             ImageHandle,
-             Private->Controller,
-             Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
-             &ConfigData,
-             HttpBootHttpIoCallback,
-             (VOID *) Private,
-             &Private->HttpIo
-             );
+  return HttpIoCreateIo (
+           ImageHandle,
+           Private->Controller,
+           Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
+           &ConfigData,
+           Callback,
+           (VOID *) Private,
+           HttpIo
+           );
+}
+
+/**
+  Create a HttpIo instance for the file download.
+
+  @param[in]    Private        The pointer to the driver's private data.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootCreateHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+  )
+{
+  EFI_STATUS                   Status;
+
+  Status = HttpBootOpenHttpIo (Private, HttpBootHttpIoCallback, &Private->HttpIo);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -920,6 +942,9 @@ HttpBootGetBootFile (
   CHAR16                     *Url;
   BOOLEAN                    IdentityMode;
   UINTN                      ReceivedSize;
+  EFI_HTTP_HEADER            *Header;
+  HTTP_BOOT_DISK_CACHE_HEADER DiskCacheEntry;
+  BOOLEAN                    DiskCacheFound;
 
   ASSERT (Private != NULL);
   ASSERT (Private->HttpCreated);
@@ -947,6 +972,33 @@ HttpBootGetBootFile (
       FreePool (Url);
       return Status;
     }
+
+    //
+    // The HEAD request found the copy of the file in the disk cache still
+    // valid, download the file if it can't be read.
+    //
+    if (Private->DiskCacheHit) {
+      Status = HttpBootReadDiskCache (Private, BufferSize, Buffer);
+      if (Status == EFI_SUCCESS || Status == EFI_BUFFER_TOO_SMALL) {
+        *ImageType = Private->ImageType;
+        FreePool (Url);
+        return Status;
+      }
+      Private->DiskCacheHit = FALSE;
+    }
+
+    //
+    // Download a large file in ranges over several connections, if the server
+    // accepts range requests.
+    //
+    Status = HttpBootGetBootFileByRange (Private, Url, BufferSize, Buffer);
+    if (Status != EFI_UNSUPPORTED) {
+      if (!EFI_ERROR (Status)) {
+        *ImageType = Private->ImageType;
+      }
+      FreePool (Url);
+      return Status;
+    }
   }
 
   //
@@ -976,8 +1028,11 @@ HttpBootGetBootFile (
   //       Host
   //       Accept
   //       User-Agent
+  //     and 2 more to revalidate a copy of the file in the disk cache:
+  //       If-None-Match
+  //       If-Modified-Since
   //
-  HttpIoHeader = HttpBootCreateHeader (3);
+  HttpIoHeader = HttpBootCreateHeader (5);
   if (HttpIoHeader == NULL) {
     Status = EFI_OUT_OF_RESOURCES;
     goto ERROR_2;
@@ -1029,6 +1084,19 @@ HttpBootGetBootFile (
     goto ERROR_3;
   }
 
+  //
+  // Add the conditional header fields if the file is in the disk cache, the
+  // server answers 304 if the copy in the cache is still valid.
+  //
+  DiskCacheFound = FALSE;
+  if (HeaderOnly && !EFI_ERROR (HttpBootLookupDiskCache (Private, &DiskCacheEntry))) {
+    Status = HttpBootSetConditionalHeaders (HttpIoHeader, &DiskCacheEntry);
+    if (EFI_ERROR (Status)) {
+      goto ERROR_3;
+    }
+    DiskCacheFound = TRUE;
+  }
+
   //
   // 2.2 Build the rest of HTTP request info.
   //
@@ -1080,6 +1148,26 @@ HttpBootGetBootFile (
              TRUE,
              ResponseData
              );
+  if (DiskCacheFound && !EFI_ERROR (Status) &&
+      ResponseData->Response.StatusCode == HTTP_STATUS_304_NOT_MODIFIED) {
+    //
+    // The copy of the file in the disk cache is still valid, it will be read
+    // instead of downloading the file. Nothing more to receive, release the
+    // request and the response.
+    //
+    Private->DiskCacheHit = TRUE;
+    *ImageType = (HTTP_BOOT_IMAGE_TYPE) DiskCacheEntry.ImageType;
+    if (*BufferSize < DiskCacheEntry.FileSize) {
+      Status = EFI_BUFFER_TOO_SMALL;
+    } else {
+      Status = EFI_SUCCESS;
+    }
+    *BufferSize = (UINTN) DiskCacheEntry.FileSize;
+    if (ResponseData->Headers != NULL) {
+      HttpFreeHeaderFields (ResponseData->Headers, ResponseData->HeaderCount);
+    }
+    goto ERROR_5;
+  }
   if (EFI_ERROR (Status) || EFI_ERROR (ResponseData->Status)) {
     if (EFI_ERROR (ResponseData->Status)) {
       StatusCode = HttpIo->RspToken.Message->Data.Response->StatusCode;
@@ -1103,6 +1191,25 @@ HttpBootGetBootFile (
     goto ERROR_5;
   }
 
+  //
+  // Record whether the server accepts range requests for the file.
+  //
+  if (HeaderOnly) {
+    Header = HttpFindHeader (
+               ResponseData->HeaderCount,
+               ResponseData->Headers,
+               HTTP_HEADER_ACCEPT_RANGES
+               );
+    Private->AcceptRanges = (BOOLEAN) (Header != NULL &&
+                                       AsciiStriCmp (Header->FieldValue, "bytes") == 0);
+
+    HttpBootRecordDiskCacheValidators (
+      Private,
+      ResponseData->HeaderCount,
+      ResponseData->Headers
+      );
+  }
+
   //
   // 3.2 Cache the response header.
   //
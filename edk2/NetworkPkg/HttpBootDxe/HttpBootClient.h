@@ -13,6 +13,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define HTTP_BOOT_REQUEST_TIMEOUT            5000      // 5 seconds in uints of millisecond.
 #define HTTP_BOOT_RESPONSE_TIMEOUT           5000      // 5 seconds in uints of millisecond.
 #define HTTP_BOOT_BLOCK_SIZE                 1500
+#define HTTP_BOOT_RANGE_SIZE                 SIZE_8MB  // Size of the ranges a large boot file is downloaded in.
 
 
 
@@ -62,6 +63,30 @@ typedef struct {
   HTTP_BOOT_PRIVATE_DATA     *Private;
 } HTTP_BOOT_CALLBACK_DATA;
 
+//
+// State of a connection downloading ranges of the boot file.
+//
+typedef enum {
+  HttpBootRangeIdle,        // No range assigned.
+  HttpBootRangeRequest,     // Sending the GET request of the range.
+  HttpBootRangeHeader,      // Receiving the response header.
+  HttpBootRangeBody         // Receiving the range into the caller's buffer.
+} HTTP_BOOT_RANGE_STATE;
+
+//
+// A connection downloading ranges of the boot file.
+//
+typedef struct {
+  HTTP_IO                    HttpIo;
+  BOOLEAN                    HttpCreated;
+  HTTP_BOOT_RANGE_STATE      State;
+  HTTP_IO_HEADER             *Header;         // Host, Accept, User-Agent and Range.
+  EFI_HTTP_REQUEST_DATA      RequestData;
+  EFI_HTTP_RESPONSE_DATA     Response;
+  UINTN                      Offset;          // Offset of the next byte of the range to receive.
+  UINTN                      End;             // Offset of the end of the range.
+} HTTP_BOOT_RANGE_CONNECTION;
+
 /**
   Discover all the boot information for boot file.
 
@@ -76,6 +101,24 @@ HttpBootDiscoverBootInfo (
   IN OUT HTTP_BOOT_PRIVATE_DATA   *Private
   );
 
+/**
+  Create a HttpIo instance on the station address of the driver.
+
+  @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    Callback       Callback function of the HttpIo, or NULL.
+  @param[out]   HttpIo         The HttpIo instance to create.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootOpenHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_IO_CALLBACK             Callback  OPTIONAL,
+     OUT HTTP_IO                      *HttpIo
+  );
+
 /**
   Create a HttpIo instance for the file download.
 
@@ -90,6 +133,45 @@ HttpBootCreateHttpIo (
   IN     HTTP_BOOT_PRIVATE_DATA       *Private
   );
 
+/**
+  Download the boot file in ranges over several parallel connections.
+
+  The file is split in ranges of HTTP_BOOT_RANGE_SIZE bytes, and each of the
+  PcdHttpBootRangeConnections connections requests the next range that is not
+  assigned yet when it is done with its previous one, so a slow connection
+  doesn't hold back the others. The ranges are received directly into Buffer.
+
+  The size of the file must have been retrieved with a HEAD request, whose
+  response told that the server accepts range requests. The HTTP boot callback
+  is given the entity body only, in the order the ranges are received. Once it
+  has been given a part of the file, the download can't fall back to a single
+  GET request anymore, or the callback would be given the same data twice.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Url             The URL of the boot file.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The file can't be or shouldn't be downloaded in ranges, the
+                                   caller should download it with a single GET request. This is
+                                   only returned before any part of the file has been given to
+                                   the HTTP boot callback.
+  @retval EFI_PROTOCOL_ERROR       The server stopped answering with the requested ranges after
+                                   a part of the file was given to the HTTP boot callback.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileByRange (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN     CHAR16                   *Url,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer
+  );
+
 /**
   This function download the boot file by using UEFI HTTP protocol.
 
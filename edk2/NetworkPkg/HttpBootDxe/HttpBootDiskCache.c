@@ -0,0 +1,635 @@
+/** @file
+  Persistent cache of the boot files on a local file system volume.
+
+  The disk cache is the HTTP_BOOT_DISK_CACHE_DIRECTORY directory of the first
+  non-removable file system volume that has one, so creating the directory on
+  a fixed disk volume (the ESP, or a RAM disk) designates it for the cache.
+  Removable media are never used: a copy read from the cache is booted without
+  the integrity that HTTPS gives the download, so whoever can write the volume
+  chooses the boot image. All the files in the directory belong to the cache,
+  one per boot file URI.
+
+  The HEAD request that retrieves the size of the boot file carries the
+  validators of the cached copy, and the copy is read instead of downloading
+  the boot file if the server answers 304 (Not Modified).
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "HttpBootDxe.h"
+
+/**
+  Open the disk cache directory.
+
+  @param[out]      Directory       The disk cache directory.
+
+  @retval EFI_SUCCESS              The directory was opened.
+  @retval EFI_NOT_FOUND            The disk cache is disabled, or no volume has the directory.
+
+**/
+EFI_STATUS
+HttpBootOpenDiskCache (
+     OUT EFI_FILE_PROTOCOL        **Directory
+  )
+{
+  EFI_STATUS                      Status;
+  EFI_HANDLE                      *Handles;
+  UINTN                           HandleCount;
+  UINTN                           Index;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *FileSystem;
+  EFI_BLOCK_IO_PROTOCOL           *BlockIo;
+  EFI_FILE_PROTOCOL               *Root;
+
+  if (PcdGet64 (PcdHttpBootDiskCacheSize) == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiSimpleFileSystemProtocolGuid,
+                  NULL,
+                  &HandleCount,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  for (Index = 0; Index < HandleCount; Index++) {
+    //
+    // Only a volume on a fixed block device can hold the cache.
+    //
+    Status = gBS->HandleProtocol (
+                    Handles[Index],
+                    &gEfiBlockIoProtocolGuid,
+                    (VOID **) &BlockIo
+                    );
+    if (EFI_ERROR (Status) || BlockIo->Media->RemovableMedia) {
+      continue;
+    }
+
+    Status = gBS->HandleProtocol (
+                    Handles[Index],
+                    &gEfiSimpleFileSystemProtocolGuid,
+                    (VOID **) &FileSystem
+                    );
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    Status = FileSystem->OpenVolume (FileSystem, &Root);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    Status = Root->Open (
+                     Root,
+                     Directory,
+                     HTTP_BOOT_DISK_CACHE_DIRECTORY,
+                     EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE,
+                     0
+                     );
+    Root->Close (Root);
+    if (!EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  FreePool (Handles);
+
+  return (Index < HandleCount) ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
+
+/**
+  Open the file of a boot file URI in the disk cache, and read its header.
+
+  On success the position of the file is at the start of the boot file.
+
+  @param[in]       Directory       The disk cache directory.
+  @param[in]       Uri             The URI of the boot file.
+  @param[in]       OpenMode        The mode to open the file with.
+  @param[out]      File            The file of the URI in the disk cache.
+  @param[out]      Entry           The header of the file.
+
+  @retval EFI_SUCCESS              The file was opened.
+  @retval EFI_NOT_FOUND            The boot file is not in the disk cache.
+
+**/
+EFI_STATUS
+HttpBootOpenDiskCacheEntry (
+  IN     EFI_FILE_PROTOCOL              *Directory,
+  IN     CHAR8                          *Uri,
+  IN     UINT64                         OpenMode,
+     OUT EFI_FILE_PROTOCOL              **File,
+     OUT HTTP_BOOT_DISK_CACHE_HEADER    *Entry
+  )
+{
+  EFI_STATUS                 Status;
+  CHAR16                     FileName[HTTP_BOOT_DISK_CACHE_NAME_SIZE];
+  CHAR8                      *EntryUri;
+  UINTN                      Size;
+
+  UnicodeSPrint (
+    FileName,
+    sizeof (FileName),
+    L"%08x.bin",
+    CalculateCrc32 (Uri, AsciiStrLen (Uri))
+    );
+  Status = Directory->Open (Directory, File, FileName, OpenMode, 0);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Files that are not completely written, and files of another URI with the
+  // same CRC are ignored.
+  //
+  EntryUri = NULL;
+  Size = sizeof (HTTP_BOOT_DISK_CACHE_HEADER);
+  Status = (*File)->Read (*File, &Size, Entry);
+  if (EFI_ERROR (Status) || Size != sizeof (HTTP_BOOT_DISK_CACHE_HEADER) ||
+      Entry->Signature != HTTP_BOOT_DISK_CACHE_SIGNATURE ||
+      Entry->UriSize != AsciiStrSize (Uri)) {
+    goto ON_ERROR;
+  }
+
+  EntryUri = AllocatePool (Entry->UriSize);
+  if (EntryUri == NULL) {
+    goto ON_ERROR;
+  }
+  Size = Entry->UriSize;
+  Status = (*File)->Read (*File, &Size, EntryUri);
+  if (EFI_ERROR (Status) || Size != Entry->UriSize ||
+      CompareMem (EntryUri, Uri, Size) != 0) {
+    goto ON_ERROR;
+  }
+
+  FreePool (EntryUri);
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  if (EntryUri != NULL) {
+    FreePool (EntryUri);
+  }
+  (*File)->Close (*File);
+  *File = NULL;
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Get the current time as an integer that increases with the time.
+
+  @return  The current time, or 0 if the time is not available.
+
+**/
+UINT64
+HttpBootDiskCacheTime (
+  VOID
+  )
+{
+  EFI_TIME                   Time;
+
+  if (EFI_ERROR (gRT->GetTime (&Time, NULL))) {
+    return 0;
+  }
+
+  return LShiftU64 (Time.Year, 40) | LShiftU64 (Time.Month, 32) |
+         LShiftU64 (Time.Day, 24) | LShiftU64 (Time.Hour, 16) |
+         LShiftU64 (Time.Minute, 8) | Time.Second;
+}
+
+/**
+  Evict the least recently used files from the disk cache until a new file
+  of EntrySize bytes fits in PcdHttpBootDiskCacheSize bytes.
+
+  Files without a valid header (incompletely written ones) are evicted first.
+
+  @param[in]       Directory       The disk cache directory.
+  @param[in]       EntrySize       The size of the new file in bytes.
+
+**/
+VOID
+HttpBootEvictDiskCache (
+  IN     EFI_FILE_PROTOCOL        *Directory,
+  IN     UINT64                   EntrySize
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_FILE_INFO               *FileInfo;
+  UINTN                       FileInfoSize;
+  EFI_FILE_PROTOCOL           *File;
+  HTTP_BOOT_DISK_CACHE_HEADER Entry;
+  UINTN                       Size;
+  UINT64                      TotalSize;
+  UINT64                      LastUsed;
+  UINT64                      OldestLastUsed;
+  CHAR16                      OldestName[256];
+
+  FileInfoSize = SIZE_OF_EFI_FILE_INFO + sizeof (OldestName);
+  FileInfo     = AllocatePool (FileInfoSize);
+  if (FileInfo == NULL) {
+    return;
+  }
+
+  while (TRUE) {
+    TotalSize      = 0;
+    OldestLastUsed = MAX_UINT64;
+    OldestName[0]  = L'\0';
+
+    Directory->SetPosition (Directory, 0);
+    while (TRUE) {
+      Size = FileInfoSize;
+      Status = Directory->Read (Directory, &Size, FileInfo);
+      if (EFI_ERROR (Status) || Size == 0) {
+        break;
+      }
+      if ((FileInfo->Attribute & EFI_FILE_DIRECTORY) != 0) {
+        continue;
+      }
+      TotalSize += FileInfo->FileSize;
+
+      LastUsed = 0;
+      Status = Directory->Open (Directory, &File, FileInfo->FileName, EFI_FILE_MODE_READ, 0);
+      if (!EFI_ERROR (Status)) {
+        Size = sizeof (HTTP_BOOT_DISK_CACHE_HEADER);
+        Status = File->Read (File, &Size, &Entry);
+        if (!EFI_ERROR (Status) && Size == sizeof (HTTP_BOOT_DISK_CACHE_HEADER) &&
+            Entry.Signature == HTTP_BOOT_DISK_CACHE_SIGNATURE) {
+          LastUsed = Entry.LastUsed;
+        }
+        File->Close (File);
+      }
+
+      if (LastUsed < OldestLastUsed) {
+        OldestLastUsed = LastUsed;
+        StrCpyS (OldestName, ARRAY_SIZE (OldestName), FileInfo->FileName);
+      }
+    }
+
+    if (TotalSize + EntrySize <= PcdGet64 (PcdHttpBootDiskCacheSize) || OldestName[0] == L'\0') {
+      break;
+    }
+
+    DEBUG ((DEBUG_INFO, "HttpBootEvictDiskCache: %s\n", OldestName));
+    Status = Directory->Open (
+                          Directory,
+                          &File,
+                          OldestName,
+                          EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE,
+                          0
+                          );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    //
+    // Delete returns EFI_WARN_DELETE_FAILURE when the file could not be
+    // deleted (a read-only volume), it would be picked again forever.
+    //
+    if (File->Delete (File) != EFI_SUCCESS) {
+      break;
+    }
+  }
+
+  FreePool (FileInfo);
+}
+
+/**
+  Look up the boot file in the disk cache.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[out]      Entry           The header of the copy of the boot file in the cache.
+
+  @retval EFI_SUCCESS              The boot file is in the disk cache.
+  @retval EFI_NOT_FOUND            The disk cache is disabled, or the boot file is not in it.
+
+**/
+EFI_STATUS
+HttpBootLookupDiskCache (
+  IN     HTTP_BOOT_PRIVATE_DATA         *Private,
+     OUT HTTP_BOOT_DISK_CACHE_HEADER    *Entry
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_FILE_PROTOCOL          *Directory;
+  EFI_FILE_PROTOCOL          *File;
+
+  Status = HttpBootOpenDiskCache (&Directory);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpBootOpenDiskCacheEntry (
+             Directory,
+             Private->BootFileUri,
+             EFI_FILE_MODE_READ,
+             &File,
+             Entry
+             );
+  if (!EFI_ERROR (Status)) {
+    File->Close (File);
+  }
+
+  Directory->Close (Directory);
+  return Status;
+}
+
+/**
+  Add the If-None-Match and If-Modified-Since header fields, so that the server
+  answers 304 if the copy of the boot file in the disk cache is still valid.
+
+  @param[in]       HttpIoHeader    The header of the request.
+  @param[in]       Entry           The header of the copy of the boot file in the cache.
+
+  @retval EFI_SUCCESS              The header fields were added.
+  @retval Others                   Failed to add the header fields.
+
+**/
+EFI_STATUS
+HttpBootSetConditionalHeaders (
+  IN     HTTP_IO_HEADER                 *HttpIoHeader,
+  IN     HTTP_BOOT_DISK_CACHE_HEADER    *Entry
+  )
+{
+  EFI_STATUS                 Status;
+
+  if (Entry->ETag[0] != '\0') {
+    Status = HttpBootSetHeader (HttpIoHeader, HTTP_HEADER_IF_NONE_MATCH, Entry->ETag);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (Entry->LastModified[0] != '\0') {
+    Status = HttpBootSetHeader (HttpIoHeader, HTTP_HEADER_IF_MODIFIED_SINCE, Entry->LastModified);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Record the validators (ETag and Last-Modified) of the boot file from the
+  response header of the server, to store them with the boot file in the disk
+  cache.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       HeaderCount     Number of HTTP header structures in Headers.
+  @param[in]       Headers         Array containing list of HTTP headers.
+
+**/
+VOID
+HttpBootRecordDiskCacheValidators (
+  IN     HTTP_BOOT_PRIVATE_DATA         *Private,
+  IN     UINTN                          HeaderCount,
+  IN     EFI_HTTP_HEADER                *Headers
+  )
+{
+  EFI_HTTP_HEADER            *Header;
+
+  Private->DiskCacheHit             = FALSE;
+  Private->DiskCacheETag[0]         = '\0';
+  Private->DiskCacheLastModified[0] = '\0';
+
+  //
+  // A truncated validator would never match, don't record it.
+  //
+  Header = HttpFindHeader (HeaderCount, Headers, HTTP_HEADER_ETAG);
+  if (Header != NULL && AsciiStrSize (Header->FieldValue) <= sizeof (Private->DiskCacheETag)) {
+    AsciiStrCpyS (Private->DiskCacheETag, sizeof (Private->DiskCacheETag), Header->FieldValue);
+  }
+
+  Header = HttpFindHeader (HeaderCount, Headers, HTTP_HEADER_LAST_MODIFIED);
+  if (Header != NULL && AsciiStrSize (Header->FieldValue) <= sizeof (Private->DiskCacheLastModified)) {
+    AsciiStrCpyS (Private->DiskCacheLastModified, sizeof (Private->DiskCacheLastModified), Header->FieldValue);
+  }
+}
+
+/**
+  Read the boot file from the disk cache.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer. On output with a return code of EFI_BUFFER_TOO_SMALL,
+                                   the size of Buffer required to retrieve the requested file.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was read from the disk cache.
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small to read the file.
+  @retval EFI_NOT_FOUND            The file is not in the disk cache.
+  @retval Others                   Failed to read the file.
+
+**/
+EFI_STATUS
+HttpBootReadDiskCache (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_FILE_PROTOCOL           *Directory;
+  EFI_FILE_PROTOCOL           *File;
+  HTTP_BOOT_DISK_CACHE_HEADER Entry;
+  UINTN                       Size;
+
+  Status = HttpBootOpenDiskCache (&Directory);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpBootOpenDiskCacheEntry (
+             Directory,
+             Private->BootFileUri,
+             EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE,
+             &File,
+             &Entry
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  if (Entry.FileSize > MAX_UINTN || *BufferSize < Entry.FileSize) {
+    *BufferSize = (UINTN) MIN (Entry.FileSize, MAX_UINTN);
+    Status = EFI_BUFFER_TOO_SMALL;
+    goto CLOSE_FILE;
+  }
+
+  Size = (UINTN) Entry.FileSize;
+  Status = File->Read (File, &Size, Buffer);
+  if (EFI_ERROR (Status)) {
+    goto CLOSE_FILE;
+  }
+  //
+  // A truncated or corrupted copy is a cache miss, the file is downloaded
+  // again and replaces it.
+  //
+  if (Size != Entry.FileSize || CalculateCrc32 (Buffer, Size) != Entry.FileCrc) {
+    DEBUG ((DEBUG_WARN, "HttpBootReadDiskCache: %a is corrupted\n", Private->BootFileUri));
+    Status = EFI_NOT_FOUND;
+    goto CLOSE_FILE;
+  }
+  *BufferSize = Size;
+
+  //
+  // Refresh the time of the last use, for the LRU eviction.
+  //
+  Entry.LastUsed = HttpBootDiskCacheTime ();
+  Size = sizeof (HTTP_BOOT_DISK_CACHE_HEADER);
+  if (!EFI_ERROR (File->SetPosition (File, 0))) {
+    File->Write (File, &Size, &Entry);
+  }
+
+  DEBUG ((DEBUG_INFO, "HttpBootReadDiskCache: %a, %Lu bytes\n", Private->BootFileUri, Entry.FileSize));
+
+CLOSE_FILE:
+  File->Close (File);
+
+ON_EXIT:
+  Directory->Close (Directory);
+  return Status;
+}
+
+/**
+  Store the downloaded boot file in the disk cache, evicting the least recently
+  used files to keep the cache within PcdHttpBootDiskCacheSize bytes.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Buffer          The boot file.
+  @param[in]       BufferSize      The size of the boot file in bytes.
+  @param[in]       ImageType       The image type of the boot file.
+
+  @retval EFI_SUCCESS              The file was stored in the disk cache.
+  @retval EFI_UNSUPPORTED          The disk cache is disabled, the file is too large for it, or
+                                   the server gave no validator to revalidate the file with.
+  @retval Others                   Failed to store the file.
+
+**/
+EFI_STATUS
+HttpBootStoreDiskCache (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN     UINT8                    *Buffer,
+  IN     UINTN                    BufferSize,
+  IN     HTTP_BOOT_IMAGE_TYPE     ImageType
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_FILE_PROTOCOL           *Directory;
+  EFI_FILE_PROTOCOL           *File;
+  HTTP_BOOT_DISK_CACHE_HEADER Entry;
+  CHAR16                      FileName[HTTP_BOOT_DISK_CACHE_NAME_SIZE];
+  UINT64                      EntrySize;
+  UINTN                       Size;
+
+  if (Private->DiskCacheETag[0] == '\0' && Private->DiskCacheLastModified[0] == '\0') {
+    return EFI_UNSUPPORTED;
+  }
+
+  EntrySize = sizeof (HTTP_BOOT_DISK_CACHE_HEADER) + AsciiStrSize (Private->BootFileUri) + (UINT64) BufferSize;
+  if (EntrySize > PcdGet64 (PcdHttpBootDiskCacheSize)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = HttpBootOpenDiskCache (&Directory);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Replace the stale copy, if any, and make room for the new one.
+  //
+  UnicodeSPrint (
+    FileName,
+    sizeof (FileName),
+    L"%08x.bin",
+    CalculateCrc32 (Private->BootFileUri, AsciiStrLen (Private->BootFileUri))
+    );
+  Status = Directory->Open (
+                        Directory,
+                        &File,
+                        FileName,
+                        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE,
+                        0
+                        );
+  if (!EFI_ERROR (Status)) {
+    File->Delete (File);
+  }
+
+  HttpBootEvictDiskCache (Directory, EntrySize);
+
+  Status = Directory->Open (
+                        Directory,
+                        &File,
+                        FileName,
+                        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+                        0
+                        );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  //
+  // The signature is written last, so that a file interrupted by a reset is
+  // never used.
+  //
+  ZeroMem (&Entry, sizeof (Entry));
+  Entry.UriSize   = (UINT32) AsciiStrSize (Private->BootFileUri);
+  Entry.FileSize  = BufferSize;
+  Entry.FileCrc   = CalculateCrc32 (Buffer, BufferSize);
+  Entry.LastUsed  = HttpBootDiskCacheTime ();
+  Entry.ImageType = ImageType;
+  CopyMem (Entry.ETag, Private->DiskCacheETag, sizeof (Entry.ETag));
+  CopyMem (Entry.LastModified, Private->DiskCacheLastModified, sizeof (Entry.LastModified));
+
+  Size = sizeof (HTTP_BOOT_DISK_CACHE_HEADER);
+  Status = File->Write (File, &Size, &Entry);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Size = Entry.UriSize;
+  Status = File->Write (File, &Size, Private->BootFileUri);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Size = BufferSize;
+  Status = File->Write (File, &Size, Buffer);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = File->SetPosition (File, 0);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+  Entry.Signature = HTTP_BOOT_DISK_CACHE_SIGNATURE;
+  Size = sizeof (HTTP_BOOT_DISK_CACHE_HEADER);
+  Status = File->Write (File, &Size, &Entry);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = File->Flush (File);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  DEBUG ((DEBUG_INFO, "HttpBootStoreDiskCache: %a, %Lu bytes\n", Private->BootFileUri, (UINT64) BufferSize));
+  File->Close (File);
+  goto ON_EXIT;
+
+ON_ERROR:
+  DEBUG ((DEBUG_WARN, "HttpBootStoreDiskCache: %a: %r\n", Private->BootFileUri, Status));
+  File->Delete (File);
+
+ON_EXIT:
+  Directory->Close (Directory);
+  return Status;
+}
@@ -0,0 +1,133 @@
+/** @file
+  Declaration of the persistent cache of the boot files on a local volume.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EFI_HTTP_BOOT_DISK_CACHE_H__
+#define __EFI_HTTP_BOOT_DISK_CACHE_H__
+
+//
+// The disk cache is the directory of this name on the first non-removable
+// file system volume that has one.
+//
+#define HTTP_BOOT_DISK_CACHE_DIRECTORY        L"\\EFI\\HttpBootCache"
+
+#define HTTP_BOOT_DISK_CACHE_SIGNATURE        SIGNATURE_32 ('H', 'B', 'D', 'C')
+#define HTTP_BOOT_DISK_CACHE_VALIDATOR_SIZE   128
+#define HTTP_BOOT_DISK_CACHE_NAME_SIZE        13        // "xxxxxxxx.bin" and the null terminator.
+
+//
+// Header of a file in the disk cache, followed by the null-terminated URI of
+// the boot file, and by the boot file.
+//
+typedef struct {
+  UINT32                     Signature;       // Set once the file is completely written.
+  UINT32                     UriSize;         // Size of the URI in bytes, with the null terminator.
+  UINT64                     FileSize;        // Size of the boot file in bytes.
+  UINT64                     LastUsed;        // Time of the last use, for the LRU eviction.
+  UINT32                     ImageType;       // HTTP_BOOT_IMAGE_TYPE of the boot file.
+  UINT32                     FileCrc;         // CRC32 of the boot file.
+  CHAR8                      ETag[HTTP_BOOT_DISK_CACHE_VALIDATOR_SIZE];
+  CHAR8                      LastModified[HTTP_BOOT_DISK_CACHE_VALIDATOR_SIZE];
+} HTTP_BOOT_DISK_CACHE_HEADER;
+
+/**
+  Look up the boot file in the disk cache.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[out]      Entry           The header of the copy of the boot file in the cache.
+
+  @retval EFI_SUCCESS              The boot file is in the disk cache.
+  @retval EFI_NOT_FOUND            The disk cache is disabled, or the boot file is not in it.
+
+**/
+EFI_STATUS
+HttpBootLookupDiskCache (
+  IN     HTTP_BOOT_PRIVATE_DATA         *Private,
+     OUT HTTP_BOOT_DISK_CACHE_HEADER    *Entry
+  );
+
+/**
+  Add the If-None-Match and If-Modified-Since header fields, so that the server
+  answers 304 if the copy of the boot file in the disk cache is still valid.
+
+  @param[in]       HttpIoHeader    The header of the request.
+  @param[in]       Entry           The header of the copy of the boot file in the cache.
+
+  @retval EFI_SUCCESS              The header fields were added.
+  @retval Others                   Failed to add the header fields.
+
+**/
+EFI_STATUS
+HttpBootSetConditionalHeaders (
+  IN     HTTP_IO_HEADER                 *HttpIoHeader,
+  IN     HTTP_BOOT_DISK_CACHE_HEADER    *Entry
+  );
+
+/**
+  Record the validators (ETag and Last-Modified) of the boot file from the
+  response header of the server, to store them with the boot file in the disk
+  cache.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       HeaderCount     Number of HTTP header structures in Headers.
+  @param[in]       Headers         Array containing list of HTTP headers.
+
+**/
+VOID
+HttpBootRecordDiskCacheValidators (
+  IN     HTTP_BOOT_PRIVATE_DATA         *Private,
+  IN     UINTN                          HeaderCount,
+  IN     EFI_HTTP_HEADER                *Headers
+  );
+
+/**
+  Read the boot file from the disk cache.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer. On output with a return code of EFI_BUFFER_TOO_SMALL,
+                                   the size of Buffer required to retrieve the requested file.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was read from the disk cache.
+  @retval EFI_BUFFER_TOO_SMALL     The BufferSize is too small to read the file.
+  @retval EFI_NOT_FOUND            The file is not in the disk cache.
+  @retval Others                   Failed to read the file.
+
+**/
+EFI_STATUS
+HttpBootReadDiskCache (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer
+  );
+
+/**
+  Store the downloaded boot file in the disk cache, evicting the least recently
+  used files to keep the cache within PcdHttpBootDiskCacheSize bytes.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Buffer          The boot file.
+  @param[in]       BufferSize      The size of the boot file in bytes.
+  @param[in]       ImageType       The image type of the boot file.
+
+  @retval EFI_SUCCESS              The file was stored in the disk cache.
+  @retval EFI_UNSUPPORTED          The disk cache is disabled, the file is too large for it, or
+                                   the server gave no validator to revalidate the file with.
+  @retval Others                   Failed to store the file.
+
+**/
+EFI_STATUS
+HttpBootStoreDiskCache (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN     UINT8                    *Buffer,
+  IN     UINTN                    BufferSize,
+  IN     HTTP_BOOT_IMAGE_TYPE     ImageType
+  );
+
+#endif
@@ -53,6 +53,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/Ip6Config.h>
 #include <Protocol/RamDisk.h>
 #include <Protocol/AdapterInformation.h>
+#include <Protocol/SimpleFileSystem.h>
+#include <Protocol/BlockIo.h>
 
 //
 // Produced Protocols
@@ -64,6 +66,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Consumed Guids
 //
 #include <Guid/HttpBootConfigHii.h>
+#include <Guid/FileInfo.h>
 
 //
 // Driver Version
@@ -107,6 +110,7 @@ typedef enum  {
 #include "HttpBootImpl.h"
 #include "HttpBootSupport.h"
 #include "HttpBootClient.h"
+#include "HttpBootDiskCache.h"
 #include "HttpBootConfig.h"
 
 typedef union {
@@ -208,6 +212,15 @@ struct _HTTP_BOOT_PRIVATE_DATA {
   CHAR8                                     *BootFileUri;
   VOID                                      *BootFileUriParser;
   UINTN                                     BootFileSize;
+  BOOLEAN                                   AcceptRanges;
+
+  //
+  // The copy of the boot file in the disk cache was found valid, or the
+  // validators of the boot file to store in the disk cache with it.
+  //
+  BOOLEAN                                   DiskCacheHit;
+  CHAR8                                     DiskCacheETag[HTTP_BOOT_DISK_CACHE_VALIDATOR_SIZE];
+  CHAR8                                     DiskCacheLastModified[HTTP_BOOT_DISK_CACHE_VALIDATOR_SIZE];
   BOOLEAN                                   NoGateway;
   HTTP_BOOT_IMAGE_TYPE                      ImageType;
 
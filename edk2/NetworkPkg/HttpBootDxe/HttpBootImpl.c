@@ -391,6 +391,12 @@ HttpBootLoadFile (
              Buffer,
              ImageType
              );
+  if (!EFI_ERROR (Status) && !Private->DiskCacheHit) {
+    //
+    // Keep the boot file for the next boots, failing to do so is harmless.
+    //
+    HttpBootStoreDiskCache (Private, Buffer, *BufferSize, *ImageType);
+  }
 
 ON_EXIT:
   HttpBootUninstallCallback (Private);
@@ -455,6 +461,10 @@ HttpBootStop (
   Private->BootFileUri = NULL;
   Private->BootFileUriParser = NULL;
   Private->BootFileSize = 0;
+  Private->AcceptRanges = FALSE;
+  Private->DiskCacheHit = FALSE;
+  Private->DiskCacheETag[0] = '\0';
+  Private->DiskCacheLastModified[0] = '\0';
   Private->SelectIndex = 0;
   Private->SelectProxyType = HttpOfferTypeMax;
 
@@ -0,0 +1,531 @@
+/** @file
+  Download of a large boot file in ranges over several parallel connections.
+
+Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "HttpBootDxe.h"
+
+/**
+  Create a connection to download ranges of the boot file.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Url             The URL of the boot file.
+  @param[out]      Connection      The connection to create.
+
+  @retval EFI_SUCCESS              The connection was created.
+  @retval EFI_OUT_OF_RESOURCES     Could not allocate needed resources.
+  @retval Others                   Failed to create the HttpIo of the connection.
+
+**/
+EFI_STATUS
+HttpBootCreateRangeConnection (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     CHAR16                       *Url,
+     OUT HTTP_BOOT_RANGE_CONNECTION   *Connection
+  )
+{
+  EFI_STATUS                 Status;
+  CHAR8                      *HostName;
+
+  ZeroMem (Connection, sizeof (HTTP_BOOT_RANGE_CONNECTION));
+  Connection->State = HttpBootRangeIdle;
+
+  //
+  // Build the header of the range requests, the Range field is updated for
+  // each range.
+  //
+  Connection->Header = HttpBootCreateHeader (4);
+  if (Connection->Header == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  HostName = NULL;
+  Status = HttpUrlGetHostName (
+             Private->BootFileUri,
+             Private->BootFileUriParser,
+             &HostName
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+  Status = HttpBootSetHeader (Connection->Header, HTTP_HEADER_HOST, HostName);
+  FreePool (HostName);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = HttpBootSetHeader (Connection->Header, HTTP_HEADER_ACCEPT, "*/*");
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Status = HttpBootSetHeader (
+             Connection->Header,
+             HTTP_HEADER_USER_AGENT,
+             HTTP_USER_AGENT_EFI_HTTP_BOOT
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  Connection->RequestData.Method = HttpMethodGet;
+  Connection->RequestData.Url    = Url;
+
+  //
+  // The response headers of the ranges are not reported to the HTTP boot
+  // callback, the one of the HEAD request already told the size of the file.
+  //
+  Status = HttpBootOpenHttpIo (Private, NULL, &Connection->HttpIo);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+  Connection->HttpCreated = TRUE;
+
+  return EFI_SUCCESS;
+
+ON_ERROR:
+  HttpBootFreeHeader (Connection->Header);
+  Connection->Header = NULL;
+
+  return Status;
+}
+
+/**
+  Abort the pending operations of a range connection and destroy it.
+
+  @param[in]       Connection      The connection to destroy.
+
+**/
+VOID
+HttpBootDestroyRangeConnection (
+  IN     HTTP_BOOT_RANGE_CONNECTION   *Connection
+  )
+{
+  if (Connection->HttpCreated) {
+    gBS->SetTimer (Connection->HttpIo.TimeoutEvent, TimerCancel, 0);
+    if (Connection->State != HttpBootRangeIdle) {
+      Connection->HttpIo.Http->Cancel (Connection->HttpIo.Http, NULL);
+    }
+    HttpIoDestroyIo (&Connection->HttpIo);
+    Connection->HttpCreated = FALSE;
+  }
+
+  HttpBootFreeHeader (Connection->Header);
+  Connection->Header = NULL;
+}
+
+/**
+  Queue the response token of a range connection, to receive either the
+  response header or a part of the range.
+
+  @param[in]       Connection      The range connection.
+  @param[in]       Body            The buffer to receive the range into, or NULL to
+                                   receive the response header.
+  @param[in]       BodyLength      The length of Body in bytes.
+
+  @retval EFI_SUCCESS              The response token was queued.
+  @retval Others                   Failed to queue the response token.
+
+**/
+EFI_STATUS
+HttpBootRangeRecvResponse (
+  IN     HTTP_BOOT_RANGE_CONNECTION   *Connection,
+  IN     UINT8                        *Body        OPTIONAL,
+  IN     UINTN                        BodyLength
+  )
+{
+  HTTP_IO                    *HttpIo;
+  EFI_STATUS                 Status;
+
+  HttpIo = &Connection->HttpIo;
+
+  Status = gBS->SetTimer (HttpIo->TimeoutEvent, TimerRelative, HTTP_BOOT_RESPONSE_TIMEOUT * TICKS_PER_MS);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  HttpIo->RspToken.Status = EFI_NOT_READY;
+  if (Body == NULL) {
+    HttpIo->RspToken.Message->Data.Response = &Connection->Response;
+  } else {
+    HttpIo->RspToken.Message->Data.Response = NULL;
+  }
+  HttpIo->RspToken.Message->HeaderCount = 0;
+  HttpIo->RspToken.Message->Headers     = NULL;
+  HttpIo->RspToken.Message->BodyLength  = BodyLength;
+  HttpIo->RspToken.Message->Body        = Body;
+
+  HttpIo->IsRxDone = FALSE;
+  Status = HttpIo->Http->Response (HttpIo->Http, &HttpIo->RspToken);
+  if (EFI_ERROR (Status)) {
+    gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+  }
+
+  return Status;
+}
+
+/**
+  Check that the response header of a range connection carries the requested
+  range of the file.
+
+  @param[in]       Connection      The range connection.
+  @param[in]       FileSize        The size of the boot file.
+
+  @retval EFI_SUCCESS              The response carries the requested range.
+  @retval EFI_UNSUPPORTED          The server didn't answer with the requested range.
+  @retval Others                   Failed to receive the response header.
+
+**/
+EFI_STATUS
+HttpBootCheckRangeResponse (
+  IN     HTTP_BOOT_RANGE_CONNECTION   *Connection,
+  IN     UINTN                        FileSize
+  )
+{
+  EFI_HTTP_TOKEN             *RspToken;
+  EFI_HTTP_HEADER            *Header;
+  CHAR8                      ContentRange[64];
+
+  RspToken = &Connection->HttpIo.RspToken;
+  if (EFI_ERROR (RspToken->Status) && RspToken->Status != EFI_HTTP_ERROR) {
+    return RspToken->Status;
+  }
+
+  //
+  // A server that ignores the Range field answers with the whole file, and
+  // a server that can't serve the range answers with an error; the file is
+  // downloaded with a single GET request then, which reports the error if
+  // there's one.
+  //
+  if (Connection->Response.StatusCode != HTTP_STATUS_206_PARTIAL_CONTENT) {
+    DEBUG ((
+      DEBUG_WARN,
+      "HttpBootCheckRangeResponse: status %d for range %Lu-%Lu\n",
+      Connection->Response.StatusCode,
+      (UINT64) Connection->Offset,
+      (UINT64) Connection->End - 1
+      ));
+    return EFI_UNSUPPORTED;
+  }
+
+  AsciiSPrint (
+    ContentRange,
+    sizeof (ContentRange),
+    "bytes %Lu-%Lu/%Lu",
+    (UINT64) Connection->Offset,
+    (UINT64) Connection->End - 1,
+    (UINT64) FileSize
+    );
+  Header = HttpFindHeader (
+             RspToken->Message->HeaderCount,
+             RspToken->Message->Headers,
+             HTTP_HEADER_CONTENT_RANGE
+             );
+  if (Header == NULL || AsciiStrCmp (Header->FieldValue, ContentRange) != 0) {
+    DEBUG ((
+      DEBUG_WARN,
+      "HttpBootCheckRangeResponse: Content-Range \"%a\" doesn't match \"%a\"\n",
+      Header == NULL ? "" : Header->FieldValue,
+      ContentRange
+      ));
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Advance the download of a range connection without blocking.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Connection      The range connection.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+  @param[in]       FileSize        The size of the boot file.
+  @param[in, out]  NextOffset      The offset of the first range not assigned to
+                                   a connection yet.
+  @param[in, out]  ReceivedSize    The number of bytes of the file received.
+
+  @retval EFI_SUCCESS              The download goes on.
+  @retval EFI_UNSUPPORTED          The server didn't answer with the requested range.
+  @retval EFI_TIMEOUT              The server didn't answer in time.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootPollRangeConnection (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_BOOT_RANGE_CONNECTION   *Connection,
+     OUT UINT8                        *Buffer,
+  IN     UINTN                        FileSize,
+  IN OUT UINTN                        *NextOffset,
+  IN OUT UINTN                        *ReceivedSize
+  )
+{
+  HTTP_IO                    *HttpIo;
+  EFI_HTTP_PROTOCOL          *Http;
+  EFI_STATUS                 Status;
+  CHAR8                      Range[48];
+  UINTN                      Length;
+
+  HttpIo = &Connection->HttpIo;
+  Http   = HttpIo->Http;
+
+  switch (Connection->State) {
+  case HttpBootRangeIdle:
+    if (*NextOffset == FileSize) {
+      return EFI_SUCCESS;
+    }
+
+    //
+    // Request the next range that is not assigned yet.
+    //
+    Connection->Offset = *NextOffset;
+    Connection->End    = *NextOffset + MIN (FileSize - *NextOffset, HTTP_BOOT_RANGE_SIZE);
+    *NextOffset        = Connection->End;
+
+    AsciiSPrint (
+      Range,
+      sizeof (Range),
+      "bytes=%Lu-%Lu",
+      (UINT64) Connection->Offset,
+      (UINT64) Connection->End - 1
+      );
+    Status = HttpBootSetHeader (Connection->Header, HTTP_HEADER_RANGE, Range);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    HttpIo->ReqToken.Status = EFI_NOT_READY;
+    HttpIo->ReqToken.Message->Data.Request = &Connection->RequestData;
+    HttpIo->ReqToken.Message->HeaderCount  = Connection->Header->HeaderCount;
+    HttpIo->ReqToken.Message->Headers      = Connection->Header->Headers;
+    HttpIo->ReqToken.Message->BodyLength   = 0;
+    HttpIo->ReqToken.Message->Body         = NULL;
+
+    HttpIo->IsTxDone = FALSE;
+    Status = Http->Request (Http, &HttpIo->ReqToken);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Connection->State = HttpBootRangeRequest;
+    break;
+
+  case HttpBootRangeRequest:
+    if (!HttpIo->IsTxDone) {
+      break;
+    }
+    if (EFI_ERROR (HttpIo->ReqToken.Status)) {
+      return HttpIo->ReqToken.Status;
+    }
+
+    Status = HttpBootRangeRecvResponse (Connection, NULL, 0);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    Connection->State = HttpBootRangeHeader;
+    break;
+
+  case HttpBootRangeHeader:
+  case HttpBootRangeBody:
+    if (!HttpIo->IsRxDone) {
+      if (!EFI_ERROR (gBS->CheckEvent (HttpIo->TimeoutEvent))) {
+        return EFI_TIMEOUT;
+      }
+      break;
+    }
+    gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
+
+    if (Connection->State == HttpBootRangeHeader) {
+      Status = HttpBootCheckRangeResponse (Connection, FileSize);
+      if (HttpIo->RspToken.Message->Headers != NULL) {
+        HttpFreeHeaderFields (
+          HttpIo->RspToken.Message->Headers,
+          HttpIo->RspToken.Message->HeaderCount
+          );
+        HttpIo->RspToken.Message->Headers = NULL;
+      }
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      Connection->State = HttpBootRangeBody;
+    } else {
+      if (EFI_ERROR (HttpIo->RspToken.Status)) {
+        return HttpIo->RspToken.Status;
+      }
+
+      Length = HttpIo->RspToken.Message->BodyLength;
+      if (Private->HttpBootCallback != NULL) {
+        Status = Private->HttpBootCallback->Callback (
+                   Private->HttpBootCallback,
+                   HttpBootHttpEntityBody,
+                   TRUE,
+                   (UINT32) Length,
+                   Buffer + Connection->Offset
+                   );
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+      Connection->Offset += Length;
+      *ReceivedSize      += Length;
+
+      if (Connection->Offset == Connection->End) {
+        Connection->State = HttpBootRangeIdle;
+        break;
+      }
+    }
+
+    //
+    // Receive the rest of the range directly into the caller's buffer.
+    //
+    Status = HttpBootRangeRecvResponse (
+               Connection,
+               Buffer + Connection->Offset,
+               Connection->End - Connection->Offset
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    break;
+
+  default:
+    ASSERT (FALSE);
+    return EFI_DEVICE_ERROR;
+  }
+
+  Http->Poll (Http);
+  return EFI_SUCCESS;
+}
+
+/**
+  Download the boot file in ranges over several parallel connections.
+
+  The file is split in ranges of HTTP_BOOT_RANGE_SIZE bytes, and each of the
+  PcdHttpBootRangeConnections connections requests the next range that is not
+  assigned yet when it is done with its previous one, so a slow connection
+  doesn't hold back the others. The ranges are received directly into Buffer.
+
+  The size of the file must have been retrieved with a HEAD request, whose
+  response told that the server accepts range requests. The HTTP boot callback
+  is given the entity body only, in the order the ranges are received. Once it
+  has been given a part of the file, the download can't fall back to a single
+  GET request anymore, or the callback would be given the same data twice.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Url             The URL of the boot file.
+  @param[in, out]  BufferSize      On input the size of Buffer in bytes. On output with a return
+                                   code of EFI_SUCCESS, the amount of data transferred to
+                                   Buffer.
+  @param[out]      Buffer          The memory buffer to transfer the file to.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The file can't be or shouldn't be downloaded in ranges, the
+                                   caller should download it with a single GET request. This is
+                                   only returned before any part of the file has been given to
+                                   the HTTP boot callback.
+  @retval EFI_PROTOCOL_ERROR       The server stopped answering with the requested ranges after
+                                   a part of the file was given to the HTTP boot callback.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileByRange (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN     CHAR16                   *Url,
+  IN OUT UINTN                    *BufferSize,
+     OUT UINT8                    *Buffer
+  )
+{
+  HTTP_BOOT_RANGE_CONNECTION *Connections;
+  UINTN                      Count;
+  UINTN                      Index;
+  UINTN                      FileSize;
+  UINTN                      NextOffset;
+  UINTN                      ReceivedSize;
+  EFI_STATUS                 Status;
+
+  FileSize = Private->BootFileSize;
+  Count    = PcdGet8 (PcdHttpBootRangeConnections);
+  if (!Private->AcceptRanges || Count < 2 ||
+      FileSize <= HTTP_BOOT_RANGE_SIZE || *BufferSize < FileSize) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // No more connections than ranges.
+  //
+  Count = MIN (Count, (FileSize + HTTP_BOOT_RANGE_SIZE - 1) / HTTP_BOOT_RANGE_SIZE);
+
+  Connections = AllocateZeroPool (Count * sizeof (HTTP_BOOT_RANGE_CONNECTION));
+  if (Connections == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Go on with fewer connections if the HTTP driver can't open all of them.
+  //
+  for (Index = 0; Index < Count; Index++) {
+    Status = HttpBootCreateRangeConnection (Private, Url, &Connections[Index]);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((
+        DEBUG_WARN,
+        "HttpBootGetBootFileByRange: connection %d: %r\n",
+        Index,
+        Status
+        ));
+      break;
+    }
+  }
+  Count = Index;
+  if (Count < 2) {
+    Status = EFI_UNSUPPORTED;
+    goto ON_EXIT;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "HttpBootGetBootFileByRange: %Lu bytes over %d connections\n",
+    (UINT64) FileSize,
+    Count
+    ));
+
+  NextOffset   = 0;
+  ReceivedSize = 0;
+  Status       = EFI_SUCCESS;
+  while (ReceivedSize < FileSize) {
+    for (Index = 0; Index < Count; Index++) {
+      Status = HttpBootPollRangeConnection (
+                 Private,
+                 &Connections[Index],
+                 Buffer,
+                 FileSize,
+                 &NextOffset,
+                 &ReceivedSize
+                 );
+      if (EFI_ERROR (Status)) {
+        if (Status == EFI_UNSUPPORTED && ReceivedSize != 0 && Private->HttpBootCallback != NULL) {
+          DEBUG ((
+            DEBUG_ERROR,
+            "HttpBootGetBootFileByRange: range refused after %Lu bytes were reported\n",
+            (UINT64) ReceivedSize
+            ));
+          Status = EFI_PROTOCOL_ERROR;
+        }
+        goto ON_EXIT;
+      }
+    }
+  }
+
+  *BufferSize = FileSize;
+
+ON_EXIT:
+  for (Index = 0; Index < Count; Index++) {
+    HttpBootDestroyRangeConnection (&Connections[Index]);
+  }
+  FreePool (Connections);
+
+  return Status;
+}
@@ -1547,6 +1547,7 @@ NetLibIp6ToStr (
 #define  NET_BUF_HEAD         1    // Trim or allocate space from head
 #define  NET_BUF_TAIL         0    // Trim or allocate space from tail
 #define  NET_VECTOR_OWN_FIRST 0x01  // We allocated the 1st block in the vector
+#define  NET_VECTOR_CACHED    0x02  // NetbufAlloc may recycle the vector and its block
 
 #define NET_CHECK_SIGNATURE(PData, SIGNATURE) \
   ASSERT (((PData) != NULL) && ((PData)->Signature == (SIGNATURE)))
@@ -1667,6 +1668,24 @@ typedef struct {
   UINT8               *Bulk;
 } NET_FRAGMENT;
 
+//
+// NetbufAlloc recycles the freed single block buffers of each driver in
+// caches of these many block size classes.
+//
+#define NET_BUF_CACHE_CLASSES   4
+
+//
+// Statistics of a block size class of the NetbufAlloc cache.
+//
+typedef struct {
+  UINT32              BlockSize;  // Size of the blocks of the class
+  UINT32              Cached;     // Buffers in the cache
+  UINT32              MaxCached;  // Most buffers ever in the cache
+  UINT64              Allocated;  // Buffers allocated in the class
+  UINT64              Recycled;   // Allocations served from the cache
+  UINT64              Trimmed;    // Buffers freed to keep the cache small
+} NET_BUF_CACHE_STATISTICS;
+
 #define NET_GET_REF(PData)      ((PData)->RefCnt++)
 #define NET_PUT_REF(PData)      ((PData)->RefCnt--)
 #define NETBUF_FROM_PROTODATA(Info) BASE_CR((Info), NET_BUF, ProtoData)
@@ -1720,6 +1739,19 @@ NetbufFree (
   IN NET_BUF                *Nbuf
   );
 
+/**
+  Get the statistics of the caches that NetbufAlloc recycles the freed
+  single block buffers of the driver in.
+
+  @param[out]  Statistics           The statistics of each block size class.
+
+**/
+VOID
+EFIAPI
+NetbufGetCacheStatistics (
+  OUT NET_BUF_CACHE_STATISTICS  Statistics[NET_BUF_CACHE_CLASSES]
+  );
+
 /**
   Get the index of NET_BLOCK_OP that contains the byte at Offset in the net
   buffer.
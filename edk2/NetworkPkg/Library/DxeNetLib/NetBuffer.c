@@ -13,6 +13,32 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+
+//
+// The block sizes of the classes of the NetbufAlloc cache. A block is
+// allocated with the size of the smallest class that holds it, or with
+// its own size if it is larger than all of them.
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT32  mNetbufCacheBlockSize[NET_BUF_CACHE_CLASSES] = {
+  128,
+  512,
+  2048,
+  8192
+};
+
+//
+// The freed buffers of each class, linked by their List. Being a library,
+// every driver has caches of its own.
+//
+GLOBAL_REMOVE_IF_UNREFERENCED LIST_ENTRY  mNetbufCache[NET_BUF_CACHE_CLASSES] = {
+  INITIALIZE_LIST_HEAD_VARIABLE (mNetbufCache[0]),
+  INITIALIZE_LIST_HEAD_VARIABLE (mNetbufCache[1]),
+  INITIALIZE_LIST_HEAD_VARIABLE (mNetbufCache[2]),
+  INITIALIZE_LIST_HEAD_VARIABLE (mNetbufCache[3])
+};
+
+GLOBAL_REMOVE_IF_UNREFERENCED NET_BUF_CACHE_STATISTICS  mNetbufCacheStatistics[NET_BUF_CACHE_CLASSES];
 
 
 /**
@@ -76,6 +102,230 @@ FreeNbuf:
 }
 
 
+/**
+  Get the class of the NetbufAlloc cache for a block.
+
+  @param[in]  Len              The length of the block.
+
+  @return                      The index of the class, or NET_BUF_CACHE_CLASSES if
+                               the block isn't cached.
+
+**/
+UINTN
+NetbufCacheClass (
+  IN UINT32                 Len
+  )
+{
+  UINTN                     Class;
+
+  if (PcdGet32 (PcdNetBufCacheHighWater) == 0) {
+    return NET_BUF_CACHE_CLASSES;
+  }
+
+  for (Class = 0; Class < NET_BUF_CACHE_CLASSES; Class++) {
+    if (Len <= mNetbufCacheBlockSize[Class]) {
+      break;
+    }
+  }
+
+  return Class;
+}
+
+
+/**
+  Take a freed buffer out of a class of the NetbufAlloc cache. The allocation
+  is counted in the statistics of the class, whether it is served from the
+  cache or not.
+
+  The NET_BUF is reset as NetbufAllocStruct (1, 1) would build it, and keeps
+  its vector and block.
+
+  @param[in]  Class            The class of the cache.
+
+  @return                      Pointer to the NET_BUF, or NULL if the class has
+                               no freed buffer.
+
+**/
+NET_BUF *
+NetbufCacheGet (
+  IN UINTN                  Class
+  )
+{
+  NET_BUF                   *Nbuf;
+  NET_VECTOR                *Vector;
+  EFI_TPL                   OldTpl;
+
+  //
+  // Buffers are allocated and freed from event notify functions too.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  mNetbufCacheStatistics[Class].Allocated++;
+
+  if (IsListEmpty (&mNetbufCache[Class])) {
+    gBS->RestoreTPL (OldTpl);
+    return NULL;
+  }
+
+  Nbuf = NET_LIST_HEAD (&mNetbufCache[Class], NET_BUF, List);
+  RemoveEntryList (&Nbuf->List);
+
+  mNetbufCacheStatistics[Class].Cached--;
+  mNetbufCacheStatistics[Class].Recycled++;
+
+  gBS->RestoreTPL (OldTpl);
+
+  Vector = Nbuf->Vector;
+  ZeroMem (Nbuf, NET_BUF_SIZE (1));
+
+  Nbuf->Signature           = NET_BUF_SIGNATURE;
+  Nbuf->RefCnt              = 1;
+  Nbuf->BlockOpNum          = 1;
+  Nbuf->Vector              = Vector;
+  InitializeListHead (&Nbuf->List);
+
+  return Nbuf;
+}
+
+
+/**
+  Put a freed buffer of NetbufAlloc in the cache of its class, and trim the
+  class to PcdNetBufCacheLowWater buffers once it holds more than
+  PcdNetBufCacheHighWater.
+
+  @param[in]  Nbuf             Pointer to the NET_BUF, which has one block op and
+                               doesn't share its vector.
+
+**/
+VOID
+NetbufCachePut (
+  IN NET_BUF                *Nbuf
+  )
+{
+  NET_BUF_CACHE_STATISTICS  *Statistics;
+  LIST_ENTRY                Trimmed;
+  LIST_ENTRY                *Entry;
+  LIST_ENTRY                *Next;
+  UINTN                     Class;
+  UINT32                    LowWater;
+  EFI_TPL                   OldTpl;
+
+  Class = NetbufCacheClass (Nbuf->Vector->Block[0].Len);
+  ASSERT (Class < NET_BUF_CACHE_CLASSES);
+
+  Statistics = &mNetbufCacheStatistics[Class];
+  LowWater   = MIN (PcdGet32 (PcdNetBufCacheLowWater), PcdGet32 (PcdNetBufCacheHighWater));
+  InitializeListHead (&Trimmed);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  //
+  // The most recently freed buffer is allocated first, while it is still
+  // in the processor cache. The trimming frees the oldest ones.
+  //
+  InsertHeadList (&mNetbufCache[Class], &Nbuf->List);
+  Statistics->Cached++;
+  Statistics->MaxCached = MAX (Statistics->MaxCached, Statistics->Cached);
+
+  if (Statistics->Cached > PcdGet32 (PcdNetBufCacheHighWater)) {
+    while (Statistics->Cached > LowWater) {
+      Entry = GetPreviousNode (&mNetbufCache[Class], &mNetbufCache[Class]);
+      RemoveEntryList (Entry);
+      InsertTailList (&Trimmed, Entry);
+
+      Statistics->Cached--;
+      Statistics->Trimmed++;
+    }
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  NET_LIST_FOR_EACH_SAFE (Entry, Next, &Trimmed) {
+    Nbuf = NET_LIST_USER_STRUCT (Entry, NET_BUF, List);
+
+    FreePool (Nbuf->Vector->Block[0].Bulk);
+    FreePool (Nbuf->Vector);
+    FreePool (Nbuf);
+  }
+}
+
+
+/**
+  Get the statistics of the caches that NetbufAlloc recycles the freed
+  single block buffers of the driver in.
+
+  @param[out]  Statistics           The statistics of each block size class.
+
+**/
+VOID
+EFIAPI
+NetbufGetCacheStatistics (
+  OUT NET_BUF_CACHE_STATISTICS  Statistics[NET_BUF_CACHE_CLASSES]
+  )
+{
+  UINTN                     Class;
+  EFI_TPL                   OldTpl;
+
+  ASSERT (Statistics != NULL);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  CopyMem (Statistics, mNetbufCacheStatistics, sizeof (mNetbufCacheStatistics));
+  gBS->RestoreTPL (OldTpl);
+
+  for (Class = 0; Class < NET_BUF_CACHE_CLASSES; Class++) {
+    Statistics[Class].BlockSize = mNetbufCacheBlockSize[Class];
+  }
+}
+
+
+/**
+  Free the buffers in the NetbufAlloc cache when the driver is unloaded.
+
+  @param[in]  ImageHandle          The image handle of the driver.
+  @param[in]  SystemTable          The system table.
+
+  @retval EFI_SUCCESS              The cache is freed.
+
+**/
+EFI_STATUS
+EFIAPI
+NetbufCacheDestructor (
+  IN EFI_HANDLE             ImageHandle,
+  IN EFI_SYSTEM_TABLE       *SystemTable
+  )
+{
+  NET_BUF                   *Nbuf;
+  LIST_ENTRY                *Entry;
+  LIST_ENTRY                *Next;
+  UINTN                     Class;
+
+  for (Class = 0; Class < NET_BUF_CACHE_CLASSES; Class++) {
+    DEBUG ((
+      DEBUG_INFO,
+      "NetbufCache: %d-byte class allocated %ld, recycled %ld, trimmed %ld, at most %d cached\n",
+      mNetbufCacheBlockSize[Class],
+      mNetbufCacheStatistics[Class].Allocated,
+      mNetbufCacheStatistics[Class].Recycled,
+      mNetbufCacheStatistics[Class].Trimmed,
+      mNetbufCacheStatistics[Class].MaxCached
+      ));
+
+    NET_LIST_FOR_EACH_SAFE (Entry, Next, &mNetbufCache[Class]) {
+      Nbuf = NET_LIST_USER_STRUCT (Entry, NET_BUF, List);
+      RemoveEntryList (Entry);
+
+      FreePool (Nbuf->Vector->Block[0].Bulk);
+      FreePool (Nbuf->Vector);
+      FreePool (Nbuf);
+    }
+
+    mNetbufCacheStatistics[Class].Cached = 0;
+  }
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   Allocate a single block NET_BUF. Upon allocation, all the
   free space is in the tail room.
@@ -95,25 +345,43 @@ NetbufAlloc (
   NET_BUF                   *Nbuf;
   NET_VECTOR                *Vector;
   UINT8                     *Bulk;
+  UINTN                     Class;
 
   ASSERT (Len > 0);
 
-  Nbuf = NetbufAllocStruct (1, 1);
+  Nbuf  = NULL;
+  Class = NetbufCacheClass (Len);
 
-  if (Nbuf == NULL) {
-    return NULL;
+  if (Class < NET_BUF_CACHE_CLASSES) {
+    Nbuf = NetbufCacheGet (Class);
   }
 
-  Bulk = AllocatePool (Len);
+  if (Nbuf == NULL) {
+    Nbuf = NetbufAllocStruct (1, 1);
 
-  if (Bulk == NULL) {
-    goto FreeNBuf;
+    if (Nbuf == NULL) {
+      return NULL;
+    }
+
+    if (Class < NET_BUF_CACHE_CLASSES) {
+      Bulk = AllocatePool (mNetbufCacheBlockSize[Class]);
+      Nbuf->Vector->Flag = NET_VECTOR_CACHED;
+    } else {
+      Bulk = AllocatePool (Len);
+    }
+
+    if (Bulk == NULL) {
+      goto FreeNBuf;
+    }
+
+    Nbuf->Vector->Block[0].Bulk = Bulk;
   }
 
   Vector = Nbuf->Vector;
+  Bulk   = Vector->Block[0].Bulk;
   Vector->Len                 = Len;
+  Vector->RefCnt              = 1;
 
-  Vector->Block[0].Bulk       = Bulk;
   Vector->Block[0].Len        = Len;
 
   Nbuf->BlockOp[0].BlockHead  = Bulk;
@@ -126,6 +394,7 @@ NetbufAlloc (
   return Nbuf;
 
 FreeNBuf:
+  FreePool (Nbuf->Vector);
   FreePool (Nbuf);
   return NULL;
 }
@@ -207,6 +476,17 @@ NetbufFree (
   Nbuf->RefCnt--;
 
   if (Nbuf->RefCnt == 0) {
+    //
+    // Recycle a buffer of NetbufAlloc for the next allocation of its
+    // class, unless another NET_BUF still shares its vector.
+    //
+    if ((Nbuf->BlockOpNum == 1) &&
+        (Nbuf->Vector->RefCnt == 1) &&
+        ((Nbuf->Vector->Flag & NET_VECTOR_CACHED) != 0)) {
+      NetbufCachePut (Nbuf);
+      return;
+    }
+
     //
     // Update Vector only when NBuf is to be released. That is,
     // all the sharing of Nbuf increse Vector's RefCnt by one
@@ -1639,9 +1919,41 @@ NetbufQueFlush (
 }
 
 
+/**
+  Fold a 64-bit sum of 16-bit or 32-bit words to a 16-bit ones' complement
+  checksum.
+
+  @param[in]   Sum                   The sum to fold.
+
+  @return    The folded checksum.
+
+**/
+UINT16
+NetFoldChecksum (
+  IN UINT64                 Sum
+  )
+{
+  UINT32                    Sum32;
+
+  Sum   = (Sum & 0xffffffff) + RShiftU64 (Sum, 32);
+  Sum32 = (UINT32) ((Sum & 0xffffffff) + RShiftU64 (Sum, 32));
+
+  while ((Sum32 >> 16) != 0) {
+    Sum32 = (Sum32 & 0xffff) + (Sum32 >> 16);
+  }
+
+  return (UINT16) Sum32;
+}
+
+
 /**
   Compute the checksum for a bulk of data.
 
+  The data is summed 32 bits at a time into a 64-bit accumulator, which is
+  folded to 16 bits once at the end. The ones' complement sum doesn't depend
+  on the width of the words summed, as long as they are in the same byte order,
+  see RFC 1071.
+
   @param[in]   Bulk                  Pointer to the data.
   @param[in]   Len                   Length of the data, in bytes.
 
@@ -1655,32 +1967,61 @@ NetblockChecksum (
   IN UINT32                 Len
   )
 {
-  register UINT32           Sum;
+  UINT64                    Sum;
+  UINT32                    *Words;
+
+  if (Len == 0) {
+    return 0;
+  }
+
+  if (((UINTN) Bulk & 0x01) != 0) {
+    //
+    // Sum the data from the next byte, which is 16-bit aligned. This swaps
+    // the bytes of the checksum, then add the first byte as the low byte.
+    //
+    return NetAddChecksum (SwapBytes16 (NetblockChecksum (Bulk + 1, Len - 1)), *Bulk);
+  }
 
   Sum = 0;
 
-  //
-  // Add left-over byte, if any
-  //
-  if (Len % 2 != 0) {
-    Sum += *(Bulk + Len - 1);
+  if ((((UINTN) Bulk & 0x02) != 0) && (Len >= 2)) {
+    Sum  += *(UINT16 *) Bulk;
+    Bulk += 2;
+    Len  -= 2;
+  }
+
+  Words = (UINT32 *) Bulk;
+
+  while (Len >= 16) {
+    Sum   += Words[0];
+    Sum   += Words[1];
+    Sum   += Words[2];
+    Sum   += Words[3];
+    Words += 4;
+    Len   -= 16;
+  }
+
+  while (Len >= 4) {
+    Sum += *Words++;
+    Len -= 4;
   }
 
-  while (Len > 1) {
-    Sum += *(UINT16 *) Bulk;
+  Bulk = (UINT8 *) Words;
+
+  if (Len >= 2) {
+    Sum  += *(UINT16 *) Bulk;
     Bulk += 2;
-    Len -= 2;
+    Len  -= 2;
   }
 
   //
-  // Fold 32-bit sum to 16 bits
+  // Add left-over byte, if any
   //
-  while ((Sum >> 16) != 0) {
-    Sum = (Sum & 0xffff) + (Sum >> 16);
-
+  if (Len != 0) {
+    Sum += *Bulk;
   }
 
-  return (UINT16) Sum;
+  return NetFoldChecksum (Sum);
 }
 
 
@@ -184,19 +184,26 @@ MnpFreeNbuf (
   NET_PUT_REF (Nbuf);
 
   if (Nbuf->RefCnt == 1) {
-    //
-    // Trim all buffer contained in the Nbuf, then append it to the NbufQue.
-    //
-    NetbufTrim (Nbuf, Nbuf->TotalSize, NET_BUF_TAIL);
-
-    if (NetbufAllocSpace (Nbuf, NET_VLAN_TAG_LEN, NET_BUF_HEAD) != NULL) {
+    if (MNP_IS_LENT_NBUF (Nbuf)) {
       //
-      // There is space reserved for vlan tag in the head, reclaim it
+      // The buffer is lent by SNP, free the Nbuf to give it back.
       //
-      NetbufTrim (Nbuf, NET_VLAN_TAG_LEN, NET_BUF_TAIL);
-    }
+      NetbufFree (Nbuf);
+    } else {
+      //
+      // Trim all buffer contained in the Nbuf, then append it to the NbufQue.
+      //
+      NetbufTrim (Nbuf, Nbuf->TotalSize, NET_BUF_TAIL);
 
-    NetbufQueAppend (&MnpDeviceData->FreeNbufQue, Nbuf);
+      if (NetbufAllocSpace (Nbuf, NET_VLAN_TAG_LEN, NET_BUF_HEAD) != NULL) {
+        //
+        // There is space reserved for vlan tag in the head, reclaim it
+        //
+        NetbufTrim (Nbuf, NET_VLAN_TAG_LEN, NET_BUF_TAIL);
+      }
+
+      NetbufQueAppend (&MnpDeviceData->FreeNbufQue, Nbuf);
+    }
   }
 
   gBS->RestoreTPL (OldTpl);
@@ -458,6 +465,38 @@ MnpInitializeDeviceData (
   SnpMode            = Snp->Mode;
   MnpDeviceData->Snp = Snp;
 
+  //
+  // Check whether SNP lends its receive buffers, to avoid copying the
+  // received packets.
+  //
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEdkiiSimpleNetworkRxLoanProtocolGuid,
+                  (VOID **) &MnpDeviceData->RxLoan,
+                  ImageHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (EFI_ERROR (Status)) {
+    MnpDeviceData->RxLoan = NULL;
+  }
+
+  //
+  // Check whether SNP can tell when packets are received, to receive them
+  // without waiting for the system poll.
+  //
+  Status = gBS->OpenProtocol (
+                  ControllerHandle,
+                  &gEdkiiSimpleNetworkRxNotifyProtocolGuid,
+                  (VOID **) &MnpDeviceData->RxNotify,
+                  ImageHandle,
+                  ControllerHandle,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (EFI_ERROR (Status)) {
+    MnpDeviceData->RxNotify = NULL;
+  }
+
   //
   // Initialize the lists.
   //
@@ -529,6 +568,24 @@ MnpInitializeDeviceData (
     goto ERROR;
   }
 
+  if (MnpDeviceData->RxNotify != NULL) {
+    //
+    // Create the event SNP signals when packets are received.
+    //
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    MnpSystemPoll,
+                    MnpDeviceData,
+                    &MnpDeviceData->RxNotifyEvent
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "MnpInitializeDeviceData: CreateEvent for receive notify failed.\n"));
+
+      goto ERROR;
+    }
+  }
+
   //
   // Create the timer for packet timeout check.
   //
@@ -582,6 +639,10 @@ ERROR:
       gBS->CloseEvent (MnpDeviceData->PollTimer);
     }
 
+    if (MnpDeviceData->RxNotifyEvent != NULL) {
+      gBS->CloseEvent (MnpDeviceData->RxNotifyEvent);
+    }
+
     if (MnpDeviceData->RxNbufCache != NULL) {
       MnpFreeNbuf (MnpDeviceData, MnpDeviceData->RxNbufCache);
     }
@@ -636,12 +697,21 @@ MnpDestroyDeviceData (
   //
   ASSERT (IsListEmpty (&MnpDeviceData->GroupAddressList));
 
+  //
+  // No receive buffer may be lent anymore, MnpRecycleRxLoan uses the device
+  // data.
+  //
+  ASSERT (MnpDeviceData->RxLoanCount == 0);
+
   //
   // Close the event.
   //
   gBS->CloseEvent (MnpDeviceData->TimeoutCheckTimer);
   gBS->CloseEvent (MnpDeviceData->MediaDetectTimer);
   gBS->CloseEvent (MnpDeviceData->PollTimer);
+  if (MnpDeviceData->RxNotifyEvent != NULL) {
+    gBS->CloseEvent (MnpDeviceData->RxNotifyEvent);
+  }
 
   //
   // Free the Tx buffer pool.
@@ -1165,6 +1235,41 @@ MnpStopSnp (
     return Status;
   }
 
+  DEBUG (
+    (EFI_D_NET,
+    "MnpStopSnp: %Lu bytes received, %Lu bytes copied, %d buffers still lent.\n",
+    MnpDeviceData->RxBytes,
+    MnpDeviceData->RxCopiedBytes,
+    MnpDeviceData->RxLoanCount)
+    );
+
+  DEBUG (
+    (EFI_D_NET,
+    "MnpStopSnp: %d receive polls, batches of 1:%d 2-3:%d 4-7:%d 8-15:%d 16-31:%d 32:%d, %d packets dropped from full queues.\n",
+    MnpDeviceData->RxPollCount,
+    MnpDeviceData->RxBatchHistogram[0],
+    MnpDeviceData->RxBatchHistogram[1],
+    MnpDeviceData->RxBatchHistogram[2],
+    MnpDeviceData->RxBatchHistogram[3],
+    MnpDeviceData->RxBatchHistogram[4],
+    MnpDeviceData->RxBatchHistogram[5],
+    MnpDeviceData->RxQueueDropped)
+    );
+
+  //
+  // The frames dropped by SNP include those dropped because its receive
+  // ring was full, if it keeps the statistics.
+  //
+  DEBUG_CODE_BEGIN ();
+    EFI_NETWORK_STATISTICS          Statistics;
+    UINTN                           StatisticsSize;
+
+    StatisticsSize = sizeof (Statistics);
+    if (!EFI_ERROR (Snp->Statistics (Snp, FALSE, &StatisticsSize, &Statistics))) {
+      DEBUG ((EFI_D_NET, "MnpStopSnp: %Lu frames dropped by SNP.\n", Statistics.RxDroppedFrames));
+    }
+  DEBUG_CODE_END ();
+
   //
   // Shut down the simple network.
   //
@@ -1180,6 +1285,43 @@ MnpStopSnp (
 }
 
 
+/**
+  Register or unregister the event SNP signals when packets are received, if
+  SNP can tell when packets are received.
+
+  @param[in, out]  MnpDeviceData        Pointer to the MNP_DEVICE_DATA.
+  @param[in]       Enable               TRUE to register the event, FALSE to
+                                        unregister it.
+
+**/
+VOID
+MnpEnableRxNotify (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     BOOLEAN           Enable
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((MnpDeviceData->RxNotify == NULL) || (MnpDeviceData->RxNotifyEnabled == Enable)) {
+    return;
+  }
+
+  Status = MnpDeviceData->RxNotify->Register (
+                                      MnpDeviceData->RxNotify,
+                                      Enable ? MnpDeviceData->RxNotifyEvent : NULL
+                                      );
+  if (EFI_ERROR (Status)) {
+    //
+    // Keep polling with the adaptive system poll.
+    //
+    DEBUG ((EFI_D_WARN, "MnpEnableRxNotify: Register() = %r.\n", Status));
+    return;
+  }
+
+  MnpDeviceData->RxNotifyEnabled = Enable;
+}
+
+
 /**
   Start the managed network, this function is called when one instance is configured
   or reconfigured.
@@ -1272,7 +1414,8 @@ MnpStart (
     //
     TimerOpType = EnableSystemPoll ? TimerPeriodic : TimerCancel;
 
-    Status      = gBS->SetTimer (MnpDeviceData->PollTimer, TimerOpType, MNP_SYS_POLL_INTERVAL);
+    MnpDeviceData->PollInterval = MNP_SYS_POLL_INTERVAL;
+    Status      = gBS->SetTimer (MnpDeviceData->PollTimer, TimerOpType, MnpDeviceData->PollInterval);
     if (EFI_ERROR (Status)) {
       DEBUG ((EFI_D_ERROR, "MnpStart: gBS->SetTimer for PollTimer failed, %r.\n", Status));
 
@@ -1280,6 +1423,7 @@ MnpStart (
     }
 
     MnpDeviceData->EnableSystemPoll = EnableSystemPoll;
+    MnpEnableRxNotify (MnpDeviceData, EnableSystemPoll);
   }
 
   //
@@ -1340,6 +1484,7 @@ MnpStop (
     //
     Status  = gBS->SetTimer (MnpDeviceData->PollTimer, TimerCancel, 0);
     MnpDeviceData->EnableSystemPoll = FALSE;
+    MnpEnableRxNotify (MnpDeviceData, FALSE);
   }
 
   //
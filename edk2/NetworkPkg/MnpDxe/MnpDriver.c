@@ -367,6 +367,20 @@ MnpDriverBindingStop (
       return EFI_DEVICE_ERROR;
     }
 
+    //
+    // The receive buffers lent to the upper layers are given back when the
+    // MNP children are destroyed. If a driver still holds one, keep the
+    // device data, which the recycle of the buffer uses, and fail the stop.
+    //
+    if (MnpDeviceData->RxLoanCount != 0) {
+      DEBUG ((
+        EFI_D_ERROR,
+        "MnpDriverBindingStop: %d receive buffers still lent.\n",
+        MnpDeviceData->RxLoanCount
+        ));
+      return EFI_DEVICE_ERROR;
+    }
+
     //
     // Uninstall the VLAN Config Protocol if any
     //
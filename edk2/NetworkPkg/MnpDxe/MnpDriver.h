@@ -15,6 +15,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/SimpleNetwork.h>
 #include <Protocol/ServiceBinding.h>
 #include <Protocol/VlanConfig.h>
+#include <Protocol/SimpleNetworkRxLoan.h>
+#include <Protocol/SimpleNetworkRxNotify.h>
 
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -32,6 +34,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define MNP_DEVICE_DATA_SIGNATURE  SIGNATURE_32 ('M', 'n', 'p', 'D')
 
+//
+// Number of buckets of the histogram of the receive batch sizes, for 1,
+// 2 - 3, 4 - 7, ... packets, the last bucket counts all the larger batches.
+//
+#define MNP_RX_BATCH_HISTOGRAM_SIZE  6
+
 //
 // Global Variables
 //
@@ -47,6 +55,11 @@ typedef struct {
   UINTN                         NumberOfVlan;
   CHAR16                        *MacString;
   EFI_SIMPLE_NETWORK_PROTOCOL   *Snp;
+  //
+  // The receive loan protocol of the SNP, or NULL if SNP doesn't lend
+  // its receive buffers.
+  //
+  EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL *RxLoan;
 
   //
   // List of MNP_SERVICE_DATA
@@ -69,6 +82,20 @@ typedef struct {
 
   EFI_EVENT                     PollTimer;
   BOOLEAN                       EnableSystemPoll;
+  //
+  // Current period of the PollTimer, shortened while packets are received
+  // and lengthened while the network is idle.
+  //
+  UINT64                        PollInterval;
+
+  //
+  // The receive notify protocol of the SNP, or NULL if SNP can't tell when
+  // packets are received. RxNotifyEvent is signaled by SNP when packets are
+  // received while RxNotifyEnabled is TRUE.
+  //
+  EDKII_SIMPLE_NETWORK_RX_NOTIFY_PROTOCOL *RxNotify;
+  EFI_EVENT                     RxNotifyEvent;
+  BOOLEAN                       RxNotifyEnabled;
 
   EFI_EVENT                     TimeoutCheckTimer;
   EFI_EVENT                     MediaDetectTimer;
@@ -85,6 +112,27 @@ typedef struct {
   UINT32                        BufferLength;
   UINT32                        PaddingSize;
   NET_BUF                       *RxNbufCache;
+
+  //
+  // Number of the receive buffers lent by SNP that are not given back yet.
+  //
+  UINT32                        RxLoanCount;
+  //
+  // Number of bytes received from SNP, and number of bytes copied to
+  // receive them, either by SNP into the RxNbufCache or by MNP to give
+  // a private copy to each instance.
+  //
+  UINT64                        RxBytes;
+  UINT64                        RxCopiedBytes;
+
+  //
+  // Number of polls that received packets, histogram of the number of
+  // packets received by these polls, and number of packets dropped because
+  // the receive queue of an instance is full.
+  //
+  UINT32                        RxPollCount;
+  UINT32                        RxBatchHistogram[MNP_RX_BATCH_HISTOGRAM_SIZE];
+  UINT32                        RxQueueDropped;
 } MNP_DEVICE_DATA;
 
 #define MNP_DEVICE_DATA_FROM_THIS(a) \
@@ -14,6 +14,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define NET_ETHER_FCS_SIZE            4
 
 #define MNP_SYS_POLL_INTERVAL         (10 * TICKS_PER_MS)   // 10 milliseconds
+#define MNP_SYS_POLL_MIN_INTERVAL     (1 * TICKS_PER_MS)    // 1 millisecond
 #define MNP_TIMEOUT_CHECK_INTERVAL    (50 * TICKS_PER_MS)   // 50 milliseconds
 #define MNP_MEDIA_DETECT_INTERVAL     (500 * TICKS_PER_MS)  // 500 milliseconds
 #define MNP_TX_TIMEOUT_TIME           (500 * TICKS_PER_MS)  // 500 milliseconds
@@ -24,6 +25,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MNP_MAX_TX_BUFFER_NUM         65536
 
 #define MNP_MAX_RCVD_PACKET_QUE_SIZE  256
+#define MNP_MAX_RX_BATCH              32    // Packets received at most by one poll.
 
 #define MNP_RECEIVE_UNICAST           0x01
 #define MNP_RECEIVE_BROADCAST         0x02
@@ -87,6 +89,16 @@ typedef struct {
   UINT64                            TimeoutTick;
 } MNP_RXDATA_WRAP;
 
+//
+// A receive buffer lent by SNP, wrapped in a NET_BUF.
+//
+typedef struct {
+  MNP_DEVICE_DATA                   *MnpDeviceData;
+  VOID                              *Token;
+} MNP_RX_LOAN;
+
+#define MNP_IS_LENT_NBUF(Nbuf)      ((Nbuf)->Vector->Free == MnpRecycleRxLoan)
+
 #define MNP_TX_BUF_WRAP_SIGNATURE   SIGNATURE_32 ('M', 'T', 'B', 'W')
 
 typedef struct {
@@ -414,6 +426,18 @@ MnpRecycleRxData (
   IN VOID          *Context
   );
 
+/**
+  Give a receive buffer back to SNP when the NET_BUF which wraps it is freed.
+
+  @param[in]  Arg                   Pointer to the MNP_RX_LOAN of the buffer.
+
+**/
+VOID
+EFIAPI
+MnpRecycleRxLoan (
+  IN VOID          *Arg
+  );
+
 /**
   Try to receive a packet and deliver it.
 
@@ -430,6 +454,25 @@ MnpReceivePacket (
   IN OUT MNP_DEVICE_DATA   *MnpDeviceData
   );
 
+/**
+  Try to receive the packets available and deliver them, up to MNP_MAX_RX_BATCH
+  packets.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[out]      Count                The number of packets received.
+
+  @retval EFI_SUCCESS           At least one packet is received.
+  @retval EFI_NOT_STARTED       The simple network protocol is not started.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_DEVICE_ERROR      An unexpected error occurs.
+
+**/
+EFI_STATUS
+MnpReceivePacketBatch (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+     OUT UINTN             *Count
+  );
+
 /**
   Allocate a free NET_BUF from MnpDeviceData->FreeNbufQue. If there is none
   in the queue, first try to allocate some and add them into the queue, then
@@ -518,8 +561,23 @@ MnpCheckMediaStatus (
   );
 
 /**
-  Poll to receive the packets from Snp. This function is either called by upperlayer
-  protocols/applications or the system poll timer notify mechanism.
+  Register or unregister the event SNP signals when packets are received, if
+  SNP can tell when packets are received.
+
+  @param[in, out]  MnpDeviceData        Pointer to the MNP_DEVICE_DATA.
+  @param[in]       Enable               TRUE to register the event, FALSE to
+                                        unregister it.
+
+**/
+VOID
+MnpEnableRxNotify (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+  IN     BOOLEAN           Enable
+  );
+
+/**
+  Poll to receive the packets from Snp. This function is the notify function of
+  the system poll timer, and of the event SNP signals when packets are received.
 
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
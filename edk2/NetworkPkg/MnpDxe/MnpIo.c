@@ -347,6 +347,7 @@ MnpInstanceDeliverPacket (
     // Duplicate the net buffer.
     //
     NetbufDuplicate (RxDataWrap->Nbuf, DupNbuf, 0);
+    MnpDeviceData->RxCopiedBytes += DupNbuf->TotalSize;
     MnpFreeNbuf (MnpDeviceData, RxDataWrap->Nbuf);
     RxDataWrap->Nbuf = DupNbuf;
   }
@@ -489,6 +490,7 @@ MnpQueueRcvdPacket (
   if (Instance->RcvdPacketQueueSize == MNP_MAX_RCVD_PACKET_QUE_SIZE) {
 
     DEBUG ((EFI_D_WARN, "MnpQueueRcvdPacket: Drop one packet bcz queue size limit reached.\n"));
+    Instance->MnpServiceData->MnpDeviceData->RxQueueDropped++;
 
     //
     // Get the oldest packet.
@@ -831,6 +833,123 @@ MnpEnqueuePacket (
 }
 
 
+/**
+  Give a receive buffer back to SNP when the NET_BUF which wraps it is freed.
+
+  @param[in]  Arg                   Pointer to the MNP_RX_LOAN of the buffer.
+
+**/
+VOID
+EFIAPI
+MnpRecycleRxLoan (
+  IN VOID          *Arg
+  )
+{
+  MNP_RX_LOAN      *Loan;
+  MNP_DEVICE_DATA  *MnpDeviceData;
+
+  Loan          = (MNP_RX_LOAN *) Arg;
+  MnpDeviceData = Loan->MnpDeviceData;
+  NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
+
+  MnpDeviceData->RxLoan->Recycle (MnpDeviceData->RxLoan, Loan->Token);
+  MnpDeviceData->RxLoanCount--;
+
+  FreePool (Loan);
+}
+
+
+/**
+  Try to receive a packet in a buffer lent by SNP, so that the packet is
+  delivered without being copied.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[out]      Nbuf                 Pointer to the NET_BUF which wraps the
+                                        lent buffer, with the same references as
+                                        a NET_BUF allocated by MnpAllocNbuf().
+
+  @retval EFI_SUCCESS           A packet is received in a lent buffer.
+  @retval EFI_UNSUPPORTED       SNP doesn't lend its receive buffers, or it lends
+                                no more, the packet must be received by copy.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_OUT_OF_RESOURCES  The packet is dropped due to lack of memory.
+  @retval EFI_DEVICE_ERROR      An unexpected error occurs.
+
+**/
+EFI_STATUS
+MnpReceiveLentPacket (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+     OUT NET_BUF           **Nbuf
+  )
+{
+  EFI_STATUS                            Status;
+  EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL *RxLoan;
+  MNP_RX_LOAN                           *Loan;
+  NET_FRAGMENT                          Fragment;
+  UINTN                                 HeaderSize;
+  UINTN                                 BufLen;
+  VOID                                  *Buffer;
+  VOID                                  *Token;
+
+  RxLoan = MnpDeviceData->RxLoan;
+  if (RxLoan == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = RxLoan->Receive (RxLoan, &HeaderSize, &BufLen, &Buffer, &Token);
+  if (Status == EFI_OUT_OF_RESOURCES) {
+    //
+    // All the buffers SNP can lend are in use, copy the packet instead.
+    //
+    return EFI_UNSUPPORTED;
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((HeaderSize != MnpDeviceData->Snp->Mode->MediaHeaderSize) || (BufLen < HeaderSize)) {
+    DEBUG (
+      (EFI_D_WARN,
+      "MnpReceiveLentPacket: Size error, HL:TL = %d:%d.\n",
+      HeaderSize,
+      BufLen)
+      );
+    RxLoan->Recycle (RxLoan, Token);
+    return EFI_DEVICE_ERROR;
+  }
+
+  Loan = AllocatePool (sizeof (MNP_RX_LOAN));
+  if (Loan == NULL) {
+    RxLoan->Recycle (RxLoan, Token);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Loan->MnpDeviceData = MnpDeviceData;
+  Loan->Token         = Token;
+
+  Fragment.Bulk = (UINT8 *) Buffer;
+  Fragment.Len  = (UINT32) BufLen;
+
+  *Nbuf = NetbufFromExt (&Fragment, 1, 0, 0, MnpRecycleRxLoan, Loan);
+  if (*Nbuf == NULL) {
+    RxLoan->Recycle (RxLoan, Token);
+    FreePool (Loan);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  MnpDeviceData->RxLoanCount++;
+
+  //
+  // Take the reference the free queue holds on the NET_BUFs of the pool,
+  // MnpFreeNbuf() gives the buffer back to SNP when it is the last one.
+  //
+  NET_GET_REF (*Nbuf);
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   Try to receive a packet and deliver it.
 
@@ -857,6 +976,7 @@ MnpReceivePacket (
   MNP_SERVICE_DATA            *MnpServiceData;
   UINT16                      VlanId;
   BOOLEAN                     IsVlanPacket;
+  BOOLEAN                     Lent;
 
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
@@ -868,67 +988,82 @@ MnpReceivePacket (
     return EFI_NOT_STARTED;
   }
 
-  if (MnpDeviceData->RxNbufCache == NULL) {
-    //
-    // Try to get a new buffer as there may be buffers recycled.
-    //
-    MnpDeviceData->RxNbufCache = MnpAllocNbuf (MnpDeviceData);
+  //
+  // Receive the packet in a buffer lent by SNP if possible, or else let SNP
+  // copy it into the RxNbufCache.
+  //
+  Trimmed = 0;
+  Status  = MnpReceiveLentPacket (MnpDeviceData, &Nbuf);
+  Lent    = (BOOLEAN) !EFI_ERROR (Status);
 
+  if (Status == EFI_UNSUPPORTED) {
     if (MnpDeviceData->RxNbufCache == NULL) {
       //
-      // No available buffer in the buffer pool.
+      // Try to get a new buffer as there may be buffers recycled.
       //
-      return EFI_DEVICE_ERROR;
-    }
+      MnpDeviceData->RxNbufCache = MnpAllocNbuf (MnpDeviceData);
 
-    NetbufAllocSpace (
-      MnpDeviceData->RxNbufCache,
-      MnpDeviceData->BufferLength,
-      NET_BUF_TAIL
-      );
-  }
-
-  Nbuf    = MnpDeviceData->RxNbufCache;
-  BufLen  = Nbuf->TotalSize;
-  BufPtr  = NetbufGetByte (Nbuf, 0, NULL);
-  ASSERT (BufPtr != NULL);
-
-  //
-  // Receive packet through Snp.
-  //
-  Status = Snp->Receive (Snp, &HeaderSize, &BufLen, BufPtr, NULL, NULL, NULL);
-  if (EFI_ERROR (Status)) {
-    DEBUG_CODE (
-      if (Status != EFI_NOT_READY) {
-        DEBUG ((EFI_D_WARN, "MnpReceivePacket: Snp->Receive() = %r.\n", Status));
+      if (MnpDeviceData->RxNbufCache == NULL) {
+        //
+        // No available buffer in the buffer pool.
+        //
+        return EFI_DEVICE_ERROR;
       }
-    );
 
-    return Status;
-  }
+      NetbufAllocSpace (
+        MnpDeviceData->RxNbufCache,
+        MnpDeviceData->BufferLength,
+        NET_BUF_TAIL
+        );
+    }
 
-  //
-  // Sanity check.
-  //
-  if ((HeaderSize != Snp->Mode->MediaHeaderSize) || (BufLen < HeaderSize)) {
-    DEBUG (
-      (EFI_D_WARN,
-      "MnpReceivePacket: Size error, HL:TL = %d:%d.\n",
-      HeaderSize,
-      BufLen)
+    Nbuf    = MnpDeviceData->RxNbufCache;
+    BufLen  = Nbuf->TotalSize;
+    BufPtr  = NetbufGetByte (Nbuf, 0, NULL);
+    ASSERT (BufPtr != NULL);
+
+    //
+    // Receive packet through Snp.
+    //
+    Status = Snp->Receive (Snp, &HeaderSize, &BufLen, BufPtr, NULL, NULL, NULL);
+    if (EFI_ERROR (Status)) {
+      DEBUG_CODE (
+        if (Status != EFI_NOT_READY) {
+          DEBUG ((EFI_D_WARN, "MnpReceivePacket: Snp->Receive() = %r.\n", Status));
+        }
       );
-    return EFI_DEVICE_ERROR;
-  }
 
-  Trimmed = 0;
-  if (Nbuf->TotalSize != BufLen) {
+      return Status;
+    }
+
     //
-    // Trim the packet from tail.
+    // Sanity check.
     //
-    Trimmed = NetbufTrim (Nbuf, Nbuf->TotalSize - (UINT32) BufLen, NET_BUF_TAIL);
-    ASSERT (Nbuf->TotalSize == BufLen);
+    if ((HeaderSize != Snp->Mode->MediaHeaderSize) || (BufLen < HeaderSize)) {
+      DEBUG (
+        (EFI_D_WARN,
+        "MnpReceivePacket: Size error, HL:TL = %d:%d.\n",
+        HeaderSize,
+        BufLen)
+        );
+      return EFI_DEVICE_ERROR;
+    }
+
+    if (Nbuf->TotalSize != BufLen) {
+      //
+      // Trim the packet from tail.
+      //
+      Trimmed = NetbufTrim (Nbuf, Nbuf->TotalSize - (UINT32) BufLen, NET_BUF_TAIL);
+      ASSERT (Nbuf->TotalSize == BufLen);
+    }
+
+    MnpDeviceData->RxCopiedBytes += BufLen;
+  } else if (EFI_ERROR (Status)) {
+    return Status;
   }
 
+  MnpDeviceData->RxBytes += Nbuf->TotalSize;
+
   VlanId = 0;
   if (MnpDeviceData->NumberOfVlan != 0) {
     //
@@ -944,6 +1079,11 @@ MnpReceivePacket (
     //
     // VLAN is not set for this tagged frame, ignore this packet
     //
+    if (Lent) {
+      MnpFreeNbuf (MnpDeviceData, Nbuf);
+      return Status;
+    }
+
     if (Trimmed > 0) {
       NetbufAllocSpace (Nbuf, Trimmed, NET_BUF_TAIL);
     }
@@ -963,22 +1103,30 @@ MnpReceivePacket (
   if (Nbuf->RefCnt > 2) {
     //
     // RefCnt > 2 indicates there is at least one receiver of this packet.
-    // Free the current RxNbufCache and allocate a new one.
+    // Free the current RxNbufCache and allocate a new one, a lent buffer
+    // is only released.
     //
     MnpFreeNbuf (MnpDeviceData, Nbuf);
 
-    Nbuf                       = MnpAllocNbuf (MnpDeviceData);
-    MnpDeviceData->RxNbufCache = Nbuf;
-    if (Nbuf == NULL) {
-      DEBUG ((EFI_D_ERROR, "MnpReceivePacket: Alloc packet for receiving cache failed.\n"));
-      return EFI_DEVICE_ERROR;
-    }
+    if (!Lent) {
+      Nbuf                       = MnpAllocNbuf (MnpDeviceData);
+      MnpDeviceData->RxNbufCache = Nbuf;
+      if (Nbuf == NULL) {
+        DEBUG ((EFI_D_ERROR, "MnpReceivePacket: Alloc packet for receiving cache failed.\n"));
+        return EFI_DEVICE_ERROR;
+      }
 
-    NetbufAllocSpace (Nbuf, MnpDeviceData->BufferLength, NET_BUF_TAIL);
+      NetbufAllocSpace (Nbuf, MnpDeviceData->BufferLength, NET_BUF_TAIL);
+    }
   } else {
     //
     // No receiver for this packet.
     //
+    if (Lent) {
+      MnpFreeNbuf (MnpDeviceData, Nbuf);
+      return Status;
+    }
+
     if (Trimmed > 0) {
       NetbufAllocSpace (Nbuf, Trimmed, NET_BUF_TAIL);
     }
@@ -995,12 +1143,57 @@ MnpReceivePacket (
 
 EXIT:
 
-  ASSERT (Nbuf->TotalSize == MnpDeviceData->BufferLength);
+  ASSERT (Lent || (Nbuf->TotalSize == MnpDeviceData->BufferLength));
 
   return Status;
 }
 
 
+/**
+  Try to receive the packets available and deliver them, up to MNP_MAX_RX_BATCH
+  packets.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[out]      Count                The number of packets received.
+
+  @retval EFI_SUCCESS           At least one packet is received.
+  @retval EFI_NOT_STARTED       The simple network protocol is not started.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_DEVICE_ERROR      An unexpected error occurs.
+
+**/
+EFI_STATUS
+MnpReceivePacketBatch (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+     OUT UINTN             *Count
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Bucket;
+
+  Status = EFI_NOT_READY;
+  for (*Count = 0; *Count < MNP_MAX_RX_BATCH; (*Count)++) {
+    Status = MnpReceivePacket (MnpDeviceData);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (*Count == 0) {
+    return Status;
+  }
+
+  //
+  // Account the batch in the bucket of its highest bit.
+  //
+  Bucket = (UINTN) HighBitSet32 ((UINT32) *Count);
+  MnpDeviceData->RxPollCount++;
+  MnpDeviceData->RxBatchHistogram[MIN (Bucket, MNP_RX_BATCH_HISTOGRAM_SIZE - 1)]++;
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   Remove the received packets if timeout occurs.
 
@@ -1102,8 +1295,8 @@ MnpCheckMediaStatus (
 }
 
 /**
-  Poll to receive the packets from Snp. This function is either called by upperlayer
-  protocols/applications or the system poll timer notify mechanism.
+  Poll to receive the packets from Snp. This function is the notify function of
+  the system poll timer, and of the event SNP signals when packets are received.
 
   @param[in]  Event        The event this notify function registered to.
   @param[in]  Context      Pointer to the context data registered to the event.
@@ -1117,6 +1310,8 @@ MnpSystemPoll (
   )
 {
   MNP_DEVICE_DATA  *MnpDeviceData;
+  UINTN            Count;
+  UINT64           Interval;
 
   MnpDeviceData = (MNP_DEVICE_DATA *) Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
@@ -1124,7 +1319,30 @@ MnpSystemPoll (
   //
   // Try to receive packets from Snp.
   //
-  MnpReceivePacket (MnpDeviceData);
+  MnpReceivePacketBatch (MnpDeviceData, &Count);
+
+  if ((Event == MnpDeviceData->PollTimer) && !MnpDeviceData->RxNotifyEnabled) {
+    //
+    // Poll again sooner if packets were received, right away at the minimum
+    // interval if more packets may be pending, and back off when idle. When
+    // SNP notifies the received packets, the timer only polls at the maximum
+    // interval in case a notification is lost.
+    //
+    Interval = MnpDeviceData->PollInterval;
+    if (Count == MNP_MAX_RX_BATCH) {
+      Interval = MNP_SYS_POLL_MIN_INTERVAL;
+    } else if (Count > 0) {
+      Interval = MAX (Interval / 2, MNP_SYS_POLL_MIN_INTERVAL);
+    } else {
+      Interval = MIN (Interval * 2, MNP_SYS_POLL_INTERVAL);
+    }
+
+    if (Interval != MnpDeviceData->PollInterval) {
+      if (!EFI_ERROR (gBS->SetTimer (MnpDeviceData->PollTimer, TimerPeriodic, Interval))) {
+        MnpDeviceData->PollInterval = Interval;
+      }
+    }
+  }
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
@@ -77,6 +77,8 @@ Mtftp4CleanOperation (
   Instance->WindowSize    = 1;
   Instance->TotalBlock    = 0;
   Instance->AckedBlock    = 0;
+  Instance->UnexpectedBlock = 0;
+  Instance->LostBlock     = -1;
   Instance->LastBlock     = 0;
   Instance->ServerIp      = 0;
   Instance->ListeningPort = 0;
@@ -442,6 +444,8 @@ Mtftp4Start (
   Instance->Token         = Token;
   Instance->BlkSize       = MTFTP4_DEFAULT_BLKSIZE;
   Instance->WindowSize    = MTFTP4_DEFAULT_WINDOWSIZE;
+  Instance->UnexpectedBlock = 0;
+  Instance->LostBlock     = -1;
 
   CopyMem (&Instance->ServerIp, &Config->ServerIp, sizeof (IP4_ADDR));
   Instance->ServerIp      = NTOHL (Instance->ServerIp);
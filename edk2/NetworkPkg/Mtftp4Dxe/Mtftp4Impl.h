@@ -129,6 +129,18 @@ struct _MTFTP4_PROTOCOL {
   //
   UINT64                        AckedBlock;
 
+  //
+  // Record the blocks received since the last ACK that were not expected:
+  // duplicates, and blocks after a missing one.
+  //
+  UINT64                        UnexpectedBlock;
+
+  //
+  // The expected block that the server was last told is missing, or -1.
+  // The server is told only once per hole in a window.
+  //
+  INTN                          LostBlock;
+
   //
   // The server's communication end point: IP and two ports. one for
   // initial request, one for its selected port.
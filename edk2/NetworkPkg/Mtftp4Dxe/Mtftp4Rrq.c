@@ -114,7 +114,8 @@ Mtftp4RrqSendAck (
 
   Status = Mtftp4SendPacket (Instance, Packet);
   if (!EFI_ERROR (Status)) {
-    Instance->AckedBlock = Instance->TotalBlock;
+    Instance->AckedBlock      = Instance->TotalBlock;
+    Instance->UnexpectedBlock = 0;
   }
 
   return Status;
@@ -180,6 +181,11 @@ Mtftp4RrqSaveBlock (
     return Status;
   }
 
+  //
+  // Record the total received and saved block number.
+  //
+  Instance->TotalBlock++;
+
   if (Token->CheckPacket != NULL) {
     Status = Token->CheckPacket (&Instance->Mtftp4, Token, (UINT16) Len, Packet);
 
@@ -257,6 +263,7 @@ Mtftp4RrqHandleData (
   EFI_STATUS                Status;
   UINT16                    BlockNum;
   INTN                      Expected;
+  BOOLEAN                   HoleFilled;
 
   *Completed  = FALSE;
   Status      = EFI_SUCCESS;
@@ -271,9 +278,52 @@ Mtftp4RrqHandleData (
   // expected one. If we are passive (Slave), save the block.
   //
   if (Instance->Master && (Expected != BlockNum)) {
+    Instance->UnexpectedBlock++;
+
+    if ((UINT16) (Expected - BlockNum) < 0x8000) {
+      //
+      // A block we already have, from a window the server sent again. It
+      // only needs the ACK again once it has resent a whole window: then
+      // our last ACK was lost.
+      //
+      if (Instance->UnexpectedBlock < Instance->WindowSize) {
+        return EFI_SUCCESS;
+      }
+
+      //
+      // If Expected is 0, (UINT16) (Expected - 1) is also the expected Ack number (65535).
+      //
+      return Mtftp4RrqSendAck (Instance,  (UINT16) (Expected - 1));
+    }
+
+    //
+    // A block is missing. With a window, keep the blocks after it, so
+    // that the server only has to send again from the missing one, and
+    // ACK the last block in order once: the server restarts the window
+    // from there (RFC 7440). Blocks are only kept out of order when they
+    // go to the user's buffer; without one, CheckPacket gets them in order.
+    //
+    if ((Instance->Token->Buffer != NULL) &&
+        (BlockNum > Expected) &&
+        (BlockNum - Expected < Instance->WindowSize)) {
+      Status = Mtftp4RrqSaveBlock (Instance, Packet, Len);
+
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
     //
-    // If Expected is 0, (UINT16) (Expected - 1) is also the expected Ack number (65535).
+    // ACK once per hole. If the block the server sends again is lost too,
+    // the rest of its window still arrives: ACK again then, rather than
+    // wait for the server to time out.
     //
+    if ((Instance->LostBlock == Expected) &&
+        (Instance->UnexpectedBlock + 1 < Instance->WindowSize)) {
+      return EFI_SUCCESS;
+    }
+
+    Instance->LostBlock = Expected;
     return Mtftp4RrqSendAck (Instance,  (UINT16) (Expected - 1));
   }
 
@@ -283,11 +333,6 @@ Mtftp4RrqHandleData (
     return Status;
   }
 
-  //
-  // Record the total received and saved block number.
-  //
-  Instance->TotalBlock ++;
-
   //
   // Reset the passive client's timer whenever it received a
   // valid data packet.
@@ -302,7 +347,8 @@ Mtftp4RrqHandleData (
   // If we have received all the blocks, send an ACK even if we are passive
   // to tell the server that we are done.
   //
-  Expected = Mtftp4GetNextBlockNum (&Instance->Blocks);
+  Expected   = Mtftp4GetNextBlockNum (&Instance->Blocks);
+  HoleFilled = (BOOLEAN) ((Expected >= 0) && ((UINT16) Expected != (UINT16) (BlockNum + 1)));
 
   if (Instance->Master || (Expected < 0)) {
     if (Expected < 0) {
@@ -319,7 +365,12 @@ Mtftp4RrqHandleData (
       BlockNum = (UINT16) (Expected - 1);
     }
 
-    if (Instance->WindowSize == (Instance->TotalBlock - Instance->AckedBlock) || Expected < 0) {
+    //
+    // ACK at the end of the window, and at once when the block filled a
+    // hole before blocks already kept, so that the server goes on after them.
+    //
+    if ((Instance->WindowSize <= (Instance->TotalBlock - Instance->AckedBlock)) ||
+        (Expected < 0) || HoleFilled) {
       Status = Mtftp4RrqSendAck (Instance, BlockNum);
     }
 
@@ -86,6 +86,18 @@ struct _MTFTP6_INSTANCE {
   //
   UINT64                        AckedBlock;
 
+  //
+  // Record the blocks received since the last ACK that were not expected:
+  // duplicates, and blocks after a missing one.
+  //
+  UINT64                        UnexpectedBlock;
+
+  //
+  // The expected block that the server was last told is missing, or -1.
+  // The server is told only once per hole in a window.
+  //
+  INTN                          LostBlock;
+
   EFI_IPv6_ADDRESS              ServerIp;
   UINT16                        ServerCmdPort;
   UINT16                        ServerDataPort;
@@ -60,7 +60,8 @@ Mtftp6RrqSendAck (
 
   Status = Mtftp6TransmitPacket (Instance, Packet);
   if (!EFI_ERROR (Status)) {
-    Instance->AckedBlock = Instance->TotalBlock;
+    Instance->AckedBlock      = Instance->TotalBlock;
+    Instance->UnexpectedBlock = 0;
   }
 
   return Status;
@@ -128,6 +129,11 @@ Mtftp6RrqSaveBlock (
     return Status;
   }
 
+  //
+  // Record the total received and saved block number.
+  //
+  Instance->TotalBlock++;
+
   if (Token->CheckPacket != NULL) {
     //
     // Callback to the check packet routine with the received packet.
@@ -224,6 +230,7 @@ Mtftp6RrqHandleData (
   EFI_STATUS                Status;
   UINT16                    BlockNum;
   INTN                      Expected;
+  BOOLEAN                   HoleFilled;
 
   *IsCompleted = FALSE;
   Status       = EFI_SUCCESS;
@@ -238,6 +245,48 @@ Mtftp6RrqHandleData (
   // expected one. If we are passive (Slave), save the block.
   //
   if (Instance->IsMaster && (Expected != BlockNum)) {
+    Instance->UnexpectedBlock++;
+
+    if ((UINT16) (Expected - BlockNum) < 0x8000) {
+      //
+      // A block we already have, from a window the server sent again. It
+      // only needs the ACK again once it has resent a whole window: then
+      // our last ACK was lost.
+      //
+      if (Instance->UnexpectedBlock < Instance->WindowSize) {
+        return EFI_SUCCESS;
+      }
+    } else {
+      //
+      // A block is missing. With a window, keep the blocks after it, so
+      // that the server only has to send again from the missing one, and
+      // ACK the last block in order once: the server restarts the window
+      // from there (RFC 7440). Blocks are only kept out of order when they
+      // go to the user's buffer; without one, CheckPacket gets them in order.
+      //
+      if ((Instance->Token->Buffer != NULL) &&
+          (BlockNum > Expected) &&
+          (BlockNum - Expected < Instance->WindowSize)) {
+        Status = Mtftp6RrqSaveBlock (Instance, Packet, Len, UdpPacket);
+
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+
+      //
+      // ACK once per hole. If the block the server sends again is lost too,
+      // the rest of its window still arrives: ACK again then, rather than
+      // wait for the server to time out.
+      //
+      if ((Instance->LostBlock == Expected) &&
+          (Instance->UnexpectedBlock + 1 < Instance->WindowSize)) {
+        return EFI_SUCCESS;
+      }
+
+      Instance->LostBlock = Expected;
+    }
+
     //
     // Free the received packet before send new packet in ReceiveNotify,
     // since the udpio might need to be reconfigured.
@@ -257,11 +306,6 @@ Mtftp6RrqHandleData (
     return Status;
   }
 
-  //
-  // Record the total received and saved block number.
-  //
-  Instance->TotalBlock ++;
-
   //
   // Reset the passive client's timer whenever it received a valid data packet.
   //
@@ -275,7 +319,8 @@ Mtftp6RrqHandleData (
   // If we have received all the blocks, send an ACK even if we are passive
   // to tell the server that we are done.
   //
-  Expected = Mtftp6GetNextBlockNum (&Instance->BlkList);
+  Expected   = Mtftp6GetNextBlockNum (&Instance->BlkList);
+  HoleFilled = (BOOLEAN) ((Expected >= 0) && ((UINT16) Expected != (UINT16) (BlockNum + 1)));
 
   if (Instance->IsMaster || Expected < 0) {
     if (Expected < 0) {
@@ -298,7 +343,12 @@ Mtftp6RrqHandleData (
     NetbufFree (*UdpPacket);
     *UdpPacket = NULL;
 
-    if (Instance->WindowSize == (Instance->TotalBlock - Instance->AckedBlock) || Expected < 0) {
+    //
+    // ACK at the end of the window, and at once when the block filled a
+    // hole before blocks already kept, so that the server goes on after them.
+    //
+    if ((Instance->WindowSize <= (Instance->TotalBlock - Instance->AckedBlock)) ||
+        (Expected < 0) || HoleFilled) {
       Status = Mtftp6RrqSendAck (Instance, BlockNum);
     }
   }
@@ -198,27 +198,40 @@ Mtftp6RemoveBlockNum (
     //    if End == Num, only need to decrease the End by one because
     //    we have (Start < Num) && (Num == End), so (Start <= End - 1).
     //    if (End > Num), the hold is splited into two holes, with
-    //    [Start, Num - 1] and [Num + 1, End].
+    //    [Start, Num - 1] and [Num + 1, End]. But if End == Num is the
+    //    bound of the last hole and Num isn't the last block, the upper
+    //    hole is [0, Bound] of the next round: once the lower hole is
+    //    filled, it carries the roll-over.
     //
     if (Range->Start > Num) {
       return EFI_NOT_FOUND;
+    }
 
-    } else if (Range->Start == Num) {
-      Range->Start++;
+    //
+    // Num is in the round of the first hole: blocks are only received out
+    // of order within the window after it. A hole of a later round lies
+    // after that whole round, so Num has been removed already.
+    //
+    if (Range->Round != NET_LIST_HEAD (Head, MTFTP6_BLOCK_RANGE, Link)->Round) {
+      return EFI_NOT_FOUND;
+    }
 
-      //
-      // Note that: RFC 1350 does not mention block counter roll-over,
-      // but several TFTP hosts implement the roll-over be able to accept
-      // transfers of unlimited size. There is no consensus, however, whether
-      // the counter should wrap around to zero or to one. Many implementations
-      // wrap to zero, because this is the simplest to implement. Here we choose
-      // this solution.
-      //
-      *BlockCounter  = Num;
+    //
+    // Note that: RFC 1350 does not mention block counter roll-over,
+    // but several TFTP hosts implement the roll-over be able to accept
+    // transfers of unlimited size. There is no consensus, however, whether
+    // the counter should wrap around to zero or to one. Many implementations
+    // wrap to zero, because this is the simplest to implement. Here we choose
+    // this solution.
+    //
+    *BlockCounter  = Num;
 
-      if (Range->Round > 0) {
-        *BlockCounter += Range->Bound +  MultU64x32 (Range->Round - 1, (UINT32)(Range->Bound + 1)) + 1;
-      }
+    if (Range->Round > 0) {
+      *BlockCounter += Range->Bound +  MultU64x32 (Range->Round - 1, (UINT32)(Range->Bound + 1)) + 1;
+    }
+
+    if (Range->Start == Num) {
+      Range->Start++;
 
       if (Range->Start > Range->Bound) {
         Range->Start = 0;
@@ -233,15 +246,26 @@ Mtftp6RemoveBlockNum (
       return EFI_SUCCESS;
 
     } else {
-      if (Range->End == Num) {
+      if ((Range->End == Num) && ((Num < Range->Bound) || Completed)) {
         Range->End--;
       } else {
-        NewRange = Mtftp6AllocateRange ((UINT16) (Num + 1), (UINT16) Range->End);
+        if (Range->End == Num) {
+          NewRange = Mtftp6AllocateRange (0, (UINT16) Range->Bound);
+        } else {
+          NewRange = Mtftp6AllocateRange ((UINT16) (Num + 1), (UINT16) Range->End);
+        }
 
         if (NewRange == NULL) {
           return EFI_OUT_OF_RESOURCES;
         }
 
+        //
+        // The upper hole rolls over at the same bound as the block, and is
+        // in the same round unless it is the whole next one.
+        //
+        NewRange->Bound = Range->Bound;
+        NewRange->Round = (Range->End == Num) ? Range->Round + 1 : Range->Round;
+
         Range->End = Num - 1;
         NetListInsertAfter (&Range->Link, &NewRange->Link);
       }
@@ -977,6 +1001,8 @@ Mtftp6OperationClean (
   Instance->WindowSize     = 1;
   Instance->TotalBlock     = 0;
   Instance->AckedBlock     = 0;
+  Instance->UnexpectedBlock = 0;
+  Instance->LostBlock      = -1;
   Instance->LastBlk        = 0;
   Instance->PacketToLive   = 0;
   Instance->MaxRetry       = 0;
@@ -1109,6 +1135,8 @@ Mtftp6OperationStart (
   if (Instance->WindowSize == 0) {
     Instance->WindowSize = MTFTP6_DEFAULT_WINDOWSIZE;
   }
+  Instance->UnexpectedBlock = 0;
+  Instance->LostBlock       = -1;
   if (Instance->MaxRetry == 0) {
     Instance->MaxRetry = MTFTP6_DEFAULT_MAX_RETRY;
   }
@@ -0,0 +1,310 @@
+/** @file
+  TCP congestion control algorithms.
+
+  The slow start, the fast retransmission and the fast recovery are common to
+  all the algorithms. They differ in how the congestion window grows in the
+  congestion avoidance, and in how much it is reduced when a loss is detected.
+  PcdTcpCongestionControl selects the algorithm of the new connections.
+
+  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "TcpMain.h"
+
+//
+// CUBIC constants of RFC8312, as fractions. C is 0.4 segment per second
+// cubed, that is 0.0032 segment per TCP tick cubed. The multiplicative
+// decrease factor beta is 0.7.
+//
+#define TCP_CUBIC_C_NUM          4
+#define TCP_CUBIC_C_DEN          1250
+#define TCP_CUBIC_BETA_NUM       7
+#define TCP_CUBIC_BETA_DEN       10
+
+//
+// Bound of the time from the plateau of the cubic function, to keep its cube
+// within 64 bits. The window is saturated long before.
+//
+#define TCP_CUBIC_MAX_TIME       (60 * 60 * TCP_TICK_HZ)
+
+//
+// Maximum congestion window, the largest window the peer can advertise.
+//
+#define TCP_CUBIC_MAX_WND        ((UINT32) TCP_MAX_WIN << TCP_OPTION_MAX_WS)
+
+/**
+  Initialize the Reno congestion control state of a new connection.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpRenoInit (
+  IN OUT TCP_CB *Tcb
+  )
+{
+}
+
+/**
+  Open the congestion window in congestion avoidance, by about one SMSS per
+  RTT as specified in RFC5681.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly ACKed.
+
+**/
+VOID
+TcpRenoCongestionAvoid (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  )
+{
+  Tcb->CWnd += MAX (Tcb->SndMss * Tcb->SndMss / Tcb->CWnd, 1);
+}
+
+/**
+  Compute the Reno slow start threshold when a loss is detected, half of the
+  amount of data that has been sent but not yet ACKed.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold.
+
+**/
+UINT32
+TcpRenoSsthresh (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  UINT32  FlightSize;
+
+  FlightSize = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
+
+  return MAX (FlightSize >> 1, (UINT32) (2 * Tcb->SndMss));
+}
+
+/**
+  Compute the integer cube root of a value.
+
+  @param[in]  Value    The value.
+
+  @return The largest integer whose cube is not greater than Value.
+
+**/
+UINT32
+TcpCubicRoot (
+  IN UINT64 Value
+  )
+{
+  UINT32  Low;
+  UINT32  High;
+  UINT32  Mid;
+
+  Low  = 0;
+  High = 1 << 21;
+
+  while (Low < High) {
+    Mid = (Low + High + 1) >> 1;
+
+    if (MultU64x32 (MultU64x32 (Mid, Mid), Mid) <= Value) {
+      Low = Mid;
+    } else {
+      High = Mid - 1;
+    }
+  }
+
+  return Low;
+}
+
+/**
+  Initialize the CUBIC congestion control state of a new connection.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpCubicInit (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  ZeroMem (&Tcb->Cubic, sizeof (TCP_CUBIC));
+}
+
+/**
+  Open the congestion window in congestion avoidance, toward the window of the
+  cubic function of RFC8312 one RTT later, and not less than the window of the
+  standard TCP in the same conditions.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly ACKed.
+
+**/
+VOID
+TcpCubicCongestionAvoid (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  )
+{
+  TCP_CUBIC  *Cubic;
+  UINT32     Mss;
+  INT64      Time;
+  INT64      Target;
+  UINT32     Increase;
+
+  Cubic = &Tcb->Cubic;
+  Mss   = Tcb->SndMss;
+
+  if (!Cubic->EpochOn) {
+    //
+    // Start a new epoch, the window grows back to the window before
+    // the last reduction in K ticks.
+    //
+    Cubic->EpochOn    = TRUE;
+    Cubic->EpochStart = mTcpTick;
+    Cubic->WEst       = Tcb->CWnd;
+
+    if (Tcb->CWnd < Cubic->WMax) {
+      Cubic->K      = TcpCubicRoot (
+                        DivU64x32 (
+                          MultU64x32 (Cubic->WMax - Tcb->CWnd, TCP_CUBIC_C_DEN),
+                          TCP_CUBIC_C_NUM * Mss
+                          )
+                        );
+      Cubic->Origin = Cubic->WMax;
+    } else {
+      Cubic->K      = 0;
+      Cubic->Origin = Tcb->CWnd;
+    }
+  }
+
+  //
+  // W(t) = C * (t - K) ^ 3 + Origin, with t one RTT from now.
+  //
+  Time = (INT64) TCP_SUB_TIME (mTcpTick, Cubic->EpochStart) + (Tcb->SRtt >> TCP_RTT_SHIFT) - Cubic->K;
+  Time = MIN (MAX (Time, -TCP_CUBIC_MAX_TIME), TCP_CUBIC_MAX_TIME);
+
+  Target = DivS64x64Remainder (
+             MultS64x64 (MultS64x64 (MultS64x64 (Time, Time), Time), TCP_CUBIC_C_NUM * Mss),
+             TCP_CUBIC_C_DEN,
+             NULL
+             );
+  Target = MIN (MAX (Target + Cubic->Origin, Mss), TCP_CUBIC_MAX_WND);
+
+  //
+  // TCP friendly region: the standard TCP with the same decrease factor
+  // grows by 3 * (1 - beta) / (1 + beta), that is 9/17 SMSS per RTT.
+  //
+  Cubic->WEst += (UINT32) DivU64x64Remainder (
+                            MultU64x32 (MultU64x32 (Acked, Mss), 9),
+                            MultU64x32 (Tcb->CWnd, 17),
+                            NULL
+                            );
+  Cubic->WEst  = MIN (Cubic->WEst, TCP_CUBIC_MAX_WND);
+
+  if (Target < Cubic->WEst) {
+    Target = Cubic->WEst;
+  }
+
+  if (Target > Tcb->CWnd) {
+    //
+    // Reach the target in one RTT, but don't grow faster than 1.5 times
+    // per RTT as slow start would.
+    //
+    Increase = (UINT32) DivU64x64Remainder (
+                          MultU64x32 ((UINT64) (Target - Tcb->CWnd), Acked),
+                          Tcb->CWnd,
+                          NULL
+                          );
+    Increase = MIN (Increase, Acked >> 1);
+  } else {
+    //
+    // At the plateau, grow by one SMSS every 100 RTTs.
+    //
+    Increase = (UINT32) DivU64x64Remainder (
+                          MultU64x32 (Acked, Mss),
+                          MultU64x32 (Tcb->CWnd, 100),
+                          NULL
+                          );
+  }
+
+  Tcb->CWnd += Increase;
+}
+
+/**
+  Compute the CUBIC slow start threshold when a loss is detected, beta times
+  the congestion window, and remember the window for the next epoch.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold.
+
+**/
+UINT32
+TcpCubicSsthresh (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  TCP_CUBIC  *Cubic;
+
+  Cubic          = &Tcb->Cubic;
+  Cubic->EpochOn = FALSE;
+
+  //
+  // Fast convergence: if the window didn't grow back to the window before
+  // the last reduction, other flows are competing, release some bandwidth.
+  //
+  if (Tcb->CWnd < Cubic->WMax) {
+    Cubic->WMax = (UINT32) DivU64x32 (
+                             MultU64x32 (Tcb->CWnd, TCP_CUBIC_BETA_DEN + TCP_CUBIC_BETA_NUM),
+                             2 * TCP_CUBIC_BETA_DEN
+                             );
+  } else {
+    Cubic->WMax = Tcb->CWnd;
+  }
+
+  return MAX (
+           (UINT32) DivU64x32 (MultU64x32 (Tcb->CWnd, TCP_CUBIC_BETA_NUM), TCP_CUBIC_BETA_DEN),
+           (UINT32) (2 * Tcb->SndMss)
+           );
+}
+
+//
+// The congestion control algorithms, indexed by PcdTcpCongestionControl.
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST TCP_CONGESTION_OPS  mTcpCongestionOps[] = {
+  {
+    TcpRenoInit,
+    TcpRenoCongestionAvoid,
+    TcpRenoSsthresh
+  },
+  {
+    TcpCubicInit,
+    TcpCubicCongestionAvoid,
+    TcpCubicSsthresh
+  }
+};
+
+/**
+  Get the congestion control algorithm of the new connections.
+
+  @return Pointer to the congestion control algorithm selected by
+          PcdTcpCongestionControl, or to Reno if the PCD is invalid.
+
+**/
+CONST TCP_CONGESTION_OPS *
+TcpGetCongestionOps (
+  VOID
+  )
+{
+  UINT8  Index;
+
+  Index = PcdGet8 (PcdTcpCongestionControl);
+  if (Index >= ARRAY_SIZE (mTcpCongestionOps)) {
+    Index = TCP_CONGESTION_RENO;
+  }
+
+  return &mTcpCongestionOps[Index];
+}
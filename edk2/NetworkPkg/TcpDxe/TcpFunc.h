@@ -328,6 +328,20 @@ TcpGetMaxSndNxt (
   IN TCP_CB *Tcb
   );
 
+/**
+  Get the maximum length of data to put in a segment. This is the SndMss,
+  less the SACK option the segment carries.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+
+  @return The maximum length of data in a segment.
+
+**/
+UINT32
+TcpGetSegmentMss (
+  IN TCP_CB *Tcb
+  );
+
 /**
   Compute how much data to send.
 
@@ -499,6 +513,22 @@ TcpInput (
   IN UINT8           Version
   );
 
+//
+// Functions in TcpCongestion.c
+//
+
+/**
+  Get the congestion control algorithm of the new connections.
+
+  @return Pointer to the congestion control algorithm selected by
+          PcdTcpCongestionControl, or to Reno if the PCD is invalid.
+
+**/
+CONST TCP_CONGESTION_OPS *
+TcpGetCongestionOps (
+  VOID
+  );
+
 //
 // Functions in TcpTimer.c
 //
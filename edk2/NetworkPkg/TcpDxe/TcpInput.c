@@ -29,6 +29,164 @@ TcpSeqAcceptable (
           TCP_SEQ_LT (Seg->Seq, Tcb->RcvWl2 + Tcb->RcvWnd));
 }
 
+/**
+  Update the SACK scoreboard with the SACK blocks received from the peer, as
+  specified in RFC6675. The blocks at or below the ACK are removed, and the
+  blocks received are merged in the scoreboard.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Ack      The ACK field of the received segment.
+  @param[in]       Option   Pointer to the options of the received segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_SEQNO  Ack,
+  IN     TCP_OPTION *Option
+  )
+{
+  TCP_SACK_BLOCK  Block;
+  UINT8           Index;
+  UINT8           Cur;
+  UINT8           Count;
+
+  //
+  // Remove the data ACKed cumulatively.
+  //
+  Count = 0;
+  for (Cur = 0; Cur < Tcb->SndSackCount; Cur++) {
+    if (TCP_SEQ_LEQ (Tcb->SndSack[Cur].Right, Ack)) {
+      continue;
+    }
+
+    Tcb->SndSack[Count] = Tcb->SndSack[Cur];
+    if (TCP_SEQ_LT (Tcb->SndSack[Count].Left, Ack)) {
+      Tcb->SndSack[Count].Left = Ack;
+    }
+
+    Count++;
+  }
+
+  Tcb->SndSackCount = Count;
+
+  for (Index = 0; Index < Option->SackCount; Index++) {
+    Block = Option->Sack[Index];
+
+    //
+    // Ignore the blocks that are ACKed already, such as D-SACK
+    // blocks, or that are not sent yet.
+    //
+    if (TCP_SEQ_GEQ (Block.Left, Block.Right) ||
+        TCP_SEQ_LEQ (Block.Left, Ack) ||
+        TCP_SEQ_GT (Block.Right, Tcb->SndNxt)) {
+      continue;
+    }
+
+    //
+    // Merge the blocks that overlap with, or are adjacent to the new
+    // block, and find where to insert it to keep the sequence order.
+    //
+    Count = 0;
+    for (Cur = 0; Cur < Tcb->SndSackCount; Cur++) {
+      if (TCP_SEQ_LEQ (Tcb->SndSack[Cur].Left, Block.Right) &&
+          TCP_SEQ_LEQ (Block.Left, Tcb->SndSack[Cur].Right)) {
+
+        if (TCP_SEQ_LT (Tcb->SndSack[Cur].Left, Block.Left)) {
+          Block.Left = Tcb->SndSack[Cur].Left;
+        }
+
+        if (TCP_SEQ_GT (Tcb->SndSack[Cur].Right, Block.Right)) {
+          Block.Right = Tcb->SndSack[Cur].Right;
+        }
+
+        continue;
+      }
+
+      Tcb->SndSack[Count++] = Tcb->SndSack[Cur];
+    }
+
+    Tcb->SndSackCount = Count;
+
+    for (Cur = 0; Cur < Count; Cur++) {
+      if (TCP_SEQ_LT (Block.Left, Tcb->SndSack[Cur].Left)) {
+        break;
+      }
+    }
+
+    //
+    // If the scoreboard is full, forget the highest block. It is
+    // the least useful one to find the holes to retransmit.
+    //
+    if (Count == TCP_SND_SACK_BLOCKS) {
+      if (Cur == Count) {
+        continue;
+      }
+
+      Count--;
+    }
+
+    CopyMem (
+      &Tcb->SndSack[Cur + 1],
+      &Tcb->SndSack[Cur],
+      (Count - Cur) * sizeof (TCP_SACK_BLOCK)
+      );
+
+    Tcb->SndSack[Cur] = Block;
+    Tcb->SndSackCount = (UINT8) (Count + 1);
+  }
+}
+
+/**
+  Retransmit the first hole of the SACK scoreboard that is above Seq and that
+  is not retransmitted yet in this fast recovery, as specified in RFC6675.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Seq      The first sequence number not ACKed.
+
+  @retval TRUE     A hole is retransmitted.
+  @retval FALSE    No hole is left to retransmit.
+
+**/
+BOOLEAN
+TcpSackRetransmit (
+  IN OUT TCP_CB    *Tcb,
+  IN     TCP_SEQNO Seq
+  )
+{
+  UINT8  Index;
+
+  if (TCP_SEQ_LT (Seq, Tcb->HighRxt)) {
+    Seq = Tcb->HighRxt;
+  }
+
+  //
+  // The holes are the gaps below the highest SACK block, data above it
+  // may still be in flight.
+  //
+  for (Index = 0; Index < Tcb->SndSackCount; Index++) {
+    if (TCP_SEQ_LT (Seq, Tcb->SndSack[Index].Left)) {
+      TcpRetransmit (Tcb, Seq);
+      Tcb->HighRxt = Seq + MIN (TcpGetSegmentMss (Tcb), TCP_SUB_SEQ (Tcb->SndSack[Index].Left, Seq));
+
+      DEBUG (
+        (EFI_D_NET,
+        "TcpSackRetransmit: retransmit the hole at %d for TCB %p\n",
+        Seq,
+        Tcb)
+        );
+
+      return TRUE;
+    }
+
+    if (TCP_SEQ_LT (Seq, Tcb->SndSack[Index].Right)) {
+      Seq = Tcb->SndSack[Index].Right;
+    }
+  }
+
+  return FALSE;
+}
+
 /**
   NewReno fast recovery defined in RFC3782.
 
@@ -53,9 +211,7 @@ TcpFastRecover (
     //
     // Step 1A: Invoking fast retransmission.
     //
-    FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-
-    Tcb->Ssthresh     = MAX (FlightSize >> 1, (UINT32) (2 * Tcb->SndMss));
+    Tcb->Ssthresh     = Tcb->CongestionOps->Ssthresh (Tcb);
     Tcb->Recover      = Tcb->SndNxt;
 
     Tcb->CongestState = TCP_CONGEST_RECOVER;
@@ -65,7 +221,8 @@ TcpFastRecover (
     // Step 2: Entering fast retransmission
     //
     TcpRetransmit (Tcb, Tcb->SndUna);
-    Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    Tcb->CWnd    = Tcb->Ssthresh + 3 * Tcb->SndMss;
+    Tcb->HighRxt = Tcb->SndUna + TcpGetSegmentMss (Tcb);
 
     DEBUG (
       (EFI_D_NET,
@@ -84,12 +241,19 @@ TcpFastRecover (
     //
     // Step 3: Fast Recovery,
     // If this is a duplicated ACK, increse Cwnd by SMSS.
+    // With SACK, retransmit the next hole instead. The
+    // duplicated ACK means one segment has left the network,
+    // the retransmission takes its place.
     //
 
     // Step 4 is skipped here only to be executed later
     // by TcpToSendData
     //
-    Tcb->CWnd += Tcb->SndMss;
+    if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) ||
+        !TcpSackRetransmit (Tcb, Tcb->SndUna)) {
+
+      Tcb->CWnd += Tcb->SndMss;
+    }
     DEBUG (
       (EFI_D_NET,
       "TcpFastRecover: received another duplicated ACK (%d) for TCB %p\n",
@@ -126,9 +290,20 @@ TcpFastRecover (
       //
       // Step 5 - Partial ACK:
       // fast retransmit the first unacknowledge field
-      // , then deflate the CWnd
+      // , then deflate the CWnd. With SACK, if the first
+      // unacknowledged field is already retransmitted,
+      // retransmit the next hole instead.
       //
-      TcpRetransmit (Tcb, Seg->Ack);
+      if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) &&
+          TCP_SEQ_LT (Seg->Ack, Tcb->HighRxt)) {
+
+        TcpSackRetransmit (Tcb, Seg->Ack);
+      } else {
+
+        TcpRetransmit (Tcb, Seg->Ack);
+        Tcb->HighRxt = Seg->Ack + TcpGetSegmentMss (Tcb);
+      }
+
       Acked = TCP_SUB_SEQ (Seg->Ack, Tcb->SndUna);
 
       //
@@ -593,6 +768,14 @@ TcpQueueData (
   Seg   = TCPSEG_NETBUF (Nbuf);
   Head  = &Tcb->RcvQue;
 
+  //
+  // Remember the last segment received out of order, its
+  // block is the first one reported in the SACK option.
+  //
+  if (TCP_SEQ_GT (Seg->Seq, Tcb->RcvNxt)) {
+    Tcb->RcvSackSeq = Seg->Seq;
+  }
+
   //
   // Fast path to process normal case. That is,
   // no out-of-order segments are received.
@@ -1230,6 +1413,10 @@ TcpInput (
   //
   // From now on: SND.UNA <= SEG.ACK <= SND.NXT.
   //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK)) {
+    TcpSackUpdate (Tcb, Seg->Ack, &Option);
+  }
+
   if (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_TS)) {
     //
     // update TsRecent as specified in page 16 RFC1323.
@@ -1291,7 +1478,7 @@ TcpInput (
         Tcb->CWnd += Tcb->SndMss;
       } else {
 
-        Tcb->CWnd += MAX (Tcb->SndMss * Tcb->SndMss / Tcb->CWnd, 1);
+        Tcb->CongestionOps->CongestionAvoid (Tcb, TCP_SUB_SEQ (Seg->Ack, Tcb->SndUna));
       }
 
       Tcb->CWnd = MIN (Tcb->CWnd, TCP_MAX_WIN << Tcb->SndWndScale);
@@ -159,6 +159,28 @@ TcpSynBuildOption (
     TcpPutUint32 (Data, TCP_OPTION_WS_FAST | TcpComputeScale (Tcb));
   }
 
+  //
+  // Build SACK permitted option, only when configured
+  // to send SACK option, and either we are doing active
+  // open or we have received SACK permitted option from peer.
+  //
+  if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK) &&
+      (!TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_ACK) ||
+        TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK))
+      ) {
+
+    Data = NetbufAllocSpace (
+             Nbuf,
+             TCP_OPTION_SACK_PERM_ALIGNED_LEN,
+             NET_BUF_HEAD
+             );
+
+    ASSERT (Data != NULL);
+
+    Len += TCP_OPTION_SACK_PERM_ALIGNED_LEN;
+    TcpPutUint32 (Data, TCP_OPTION_SACK_PERM_FAST);
+  }
+
   //
   // Build the MSS option.
   //
@@ -171,6 +193,182 @@ TcpSynBuildOption (
   return Len;
 }
 
+/**
+  Get the next block of contiguous data in the reassemble queue.
+
+  @param[in]       Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in, out]  Entry   On input, the last entry of the previous block, or
+                           the head of the RcvQue to get the first block. On
+                           output, the last entry of the block found.
+  @param[out]      Block   Pointer to the block found.
+
+  @retval TRUE             A block is found.
+  @retval FALSE            There is no more block in the RcvQue.
+
+**/
+BOOLEAN
+TcpGetRcvBlock (
+  IN     TCP_CB         *Tcb,
+  IN OUT LIST_ENTRY     **Entry,
+     OUT TCP_SACK_BLOCK *Block
+  )
+{
+  LIST_ENTRY  *Cur;
+  TCP_SEG     *Seg;
+
+  Cur = (*Entry)->ForwardLink;
+  if (Cur == &Tcb->RcvQue) {
+    return FALSE;
+  }
+
+  Seg          = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Cur, NET_BUF, List));
+  Block->Left  = Seg->Seq;
+  Block->Right = Seg->End;
+
+  //
+  // The segments in the RcvQue are sorted and don't overlap,
+  // merge the ones that are adjacent.
+  //
+  while (Cur->ForwardLink != &Tcb->RcvQue) {
+    Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Cur->ForwardLink, NET_BUF, List));
+
+    if (TCP_SEQ_GT (Seg->Seq, Block->Right)) {
+      break;
+    }
+
+    if (TCP_SEQ_GT (Seg->End, Block->Right)) {
+      Block->Right = Seg->End;
+    }
+
+    Cur = Cur->ForwardLink;
+  }
+
+  *Entry = Cur;
+  return TRUE;
+}
+
+/**
+  Get the SACK blocks to report the data received out of order. As required
+  by RFC2018, the first block contains the last segment received, and the
+  other blocks follow in sequence order.
+
+  @param[in]   Tcb       Pointer to the TCP_CB of this TCP instance.
+  @param[out]  Blocks    Pointer to the array to store the blocks.
+  @param[in]   MaxCount  The maximum number of blocks to get.
+
+  @return The number of blocks stored in Blocks.
+
+**/
+UINT8
+TcpGetSackBlocks (
+  IN     TCP_CB         *Tcb,
+     OUT TCP_SACK_BLOCK *Blocks,
+  IN     UINT8          MaxCount
+  )
+{
+  LIST_ENTRY      *Entry;
+  TCP_SACK_BLOCK  Block;
+  UINT8           Count;
+  BOOLEAN         First;
+
+  Count = 0;
+  First = FALSE;
+
+  if (MaxCount == 0) {
+    return 0;
+  }
+
+  Entry = &Tcb->RcvQue;
+  while (TcpGetRcvBlock (Tcb, &Entry, &Block)) {
+    if (TCP_SEQ_LEQ (Block.Left, Tcb->RcvSackSeq) && TCP_SEQ_LT (Tcb->RcvSackSeq, Block.Right)) {
+      if (TCP_SEQ_GT (Block.Right, Tcb->RcvNxt)) {
+        Blocks[Count++] = Block;
+        First           = TRUE;
+      }
+
+      break;
+    }
+  }
+
+  Entry = &Tcb->RcvQue;
+  while ((Count < MaxCount) && TcpGetRcvBlock (Tcb, &Entry, &Block)) {
+    if (TCP_SEQ_LEQ (Block.Right, Tcb->RcvNxt) ||
+        (First && (Block.Left == Blocks[0].Left))) {
+      continue;
+    }
+
+    Blocks[Count++] = Block;
+  }
+
+  return Count;
+}
+
+/**
+  Get the number of SACK blocks that fit in a segment. Besides the option
+  space left by the other options, the SndMss limits it, as the data and the
+  options other than the timestamp must fit in the SndMss together (RFC6691).
+
+  @param[in]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]  OptLen   The length of the other options of the segment.
+  @param[in]  DataLen  The length of the data in the segment.
+
+  @return The maximum number of SACK blocks to put in the segment.
+
+**/
+UINT8
+TcpGetSackRoom (
+  IN TCP_CB  *Tcb,
+  IN UINT16  OptLen,
+  IN UINT32  DataLen
+  )
+{
+  UINT32  Room;
+
+  if (DataLen + TCP_OPTION_SACK_ALIGNED_LEN + TCP_OPTION_SACK_BLOCK_LEN > Tcb->SndMss) {
+    return 0;
+  }
+
+  Room = MIN ((UINT32) (TCP_OPTION_MAX_LEN - OptLen), Tcb->SndMss - DataLen);
+  Room = (Room - TCP_OPTION_SACK_ALIGNED_LEN) / TCP_OPTION_SACK_BLOCK_LEN;
+
+  return (UINT8) MIN (TCP_OPTION_MAX_SACK_BLOCK, Room);
+}
+
+/**
+  Get the length of the SACK option that a full sized segment carries, so the
+  sender can leave room for it in the data.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+
+  @return             The length of the SACK option, or 0 if none is sent.
+
+**/
+UINT16
+TcpSackOptionLen (
+  IN TCP_CB  *Tcb
+  )
+{
+  TCP_SACK_BLOCK  Blocks[TCP_OPTION_MAX_SACK_BLOCK];
+  UINT16          OptLen;
+  UINT8           Count;
+
+  if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) || IsListEmpty (&Tcb->RcvQue)) {
+    return 0;
+  }
+
+  OptLen = 0;
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_TS)) {
+    OptLen = TCP_OPTION_TS_ALIGNED_LEN;
+  }
+
+  Count = TcpGetSackBlocks (Tcb, Blocks, TcpGetSackRoom (Tcb, OptLen, 0));
+  if (Count == 0) {
+    return 0;
+  }
+
+  return (UINT16) (TCP_OPTION_SACK_ALIGNED_LEN + Count * TCP_OPTION_SACK_BLOCK_LEN);
+}
+
 /**
   Build the TCP option in synchronized states.
 
@@ -186,11 +384,16 @@ TcpBuildOption (
   IN NET_BUF *Nbuf
   )
 {
-  UINT8   *Data;
-  UINT16  Len;
+  UINT8           *Data;
+  UINT16          Len;
+  TCP_SACK_BLOCK  Blocks[TCP_OPTION_MAX_SACK_BLOCK];
+  UINT8           Count;
+  UINT8           Index;
+  UINT32          DataLen;
 
   ASSERT ((Tcb != NULL) && (Nbuf != NULL) && (Nbuf->Tcp == NULL));
-  Len = 0;
+  Len     = 0;
+  DataLen = Nbuf->TotalSize;
 
   //
   // Build the Timestamp option.
@@ -213,6 +416,40 @@ TcpBuildOption (
     TcpPutUint32 (Data + 8, Tcb->TsRecent);
   }
 
+  //
+  // Build the SACK option if some data is received out of order.
+  // With the timestamp option, there is room for three blocks, and
+  // a full sized segment only carries the blocks the sender left room
+  // for, so the segment never exceeds the SndMss.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) &&
+      !TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_RST) &&
+      !IsListEmpty (&Tcb->RcvQue)
+      ) {
+
+    Count = TcpGetSackBlocks (Tcb, Blocks, TcpGetSackRoom (Tcb, Len, DataLen));
+
+    if (Count != 0) {
+      Data = NetbufAllocSpace (
+              Nbuf,
+              TCP_OPTION_SACK_ALIGNED_LEN + Count * TCP_OPTION_SACK_BLOCK_LEN,
+              NET_BUF_HEAD
+              );
+
+      ASSERT (Data != NULL);
+      Len = (UINT16) (Len + TCP_OPTION_SACK_ALIGNED_LEN + Count * TCP_OPTION_SACK_BLOCK_LEN);
+
+      TcpPutUint32 (Data, TCP_OPTION_SACK_FAST | (2 + Count * TCP_OPTION_SACK_BLOCK_LEN));
+      Data += TCP_OPTION_SACK_ALIGNED_LEN;
+
+      for (Index = 0; Index < Count; Index++) {
+        TcpPutUint32 (Data, Blocks[Index].Left);
+        TcpPutUint32 (Data + 4, Blocks[Index].Right);
+        Data += TCP_OPTION_SACK_BLOCK_LEN;
+      }
+    }
+  }
+
   return Len;
 }
 
@@ -238,10 +475,12 @@ TcpParseOption (
   UINT8 Cur;
   UINT8 Type;
   UINT8 Len;
+  UINT8 Index;
 
   ASSERT ((Tcp != NULL) && (Option != NULL));
 
-  Option->Flag  = 0;
+  Option->Flag      = 0;
+  Option->SackCount = 0;
 
   TotalLen      = (UINT8) ((Tcp->HeadLen << 2) - sizeof (TCP_HEAD));
   if (TotalLen <= 0) {
@@ -313,6 +552,40 @@ TcpParseOption (
       Cur += TCP_OPTION_TS_LEN;
       break;
 
+    case TCP_OPTION_SACK_PERM:
+      Len = Head[Cur + 1];
+
+      if ((Len != TCP_OPTION_SACK_PERM_LEN) || (TotalLen - Cur < TCP_OPTION_SACK_PERM_LEN)) {
+
+        return -1;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK_PERM);
+
+      Cur += TCP_OPTION_SACK_PERM_LEN;
+      break;
+
+    case TCP_OPTION_SACK:
+      Len = Head[Cur + 1];
+
+      if ((Len < 2 + TCP_OPTION_SACK_BLOCK_LEN) ||
+          ((Len - 2) % TCP_OPTION_SACK_BLOCK_LEN != 0) ||
+          (TotalLen - Cur < Len)) {
+
+        return -1;
+      }
+
+      for (Index = 0; (Index < (Len - 2) / TCP_OPTION_SACK_BLOCK_LEN) && (Index < TCP_OPTION_MAX_SACK_BLOCK); Index++) {
+        Option->Sack[Index].Left  = TcpGetUint32 (&Head[Cur + 2 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        Option->Sack[Index].Right = TcpGetUint32 (&Head[Cur + 6 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+      }
+
+      Option->SackCount = Index;
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK);
+
+      Cur = (UINT8) (Cur + Len);
+      break;
+
     case TCP_OPTION_NOP:
       Cur++;
       break;
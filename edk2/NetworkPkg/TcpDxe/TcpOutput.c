@@ -156,6 +156,23 @@ TcpGetMaxSndNxt (
   return TCPSEG_NETBUF (Nbuf)->End;
 }
 
+/**
+  Get the maximum length of data to put in a segment. This is the SndMss,
+  less the SACK option the segment carries.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+
+  @return The maximum length of data in a segment.
+
+**/
+UINT32
+TcpGetSegmentMss (
+  IN TCP_CB *Tcb
+  )
+{
+  return Tcb->SndMss - TcpSackOptionLen (Tcb);
+}
+
 /**
   Compute how much data to send.
 
@@ -177,6 +194,7 @@ TcpDataToSend (
   UINT32  Len;
   UINT32  Left;
   UINT32  Limit;
+  UINT32  Mss;
 
   Sk = Tcb->Sk;
   ASSERT (Sk != NULL);
@@ -209,9 +227,10 @@ TcpDataToSend (
   Left  = GET_SND_DATASIZE (Sk) + TCP_SUB_SEQ (TcpGetMaxSndNxt (Tcb), Tcb->SndNxt);
 
   Len   = MIN (Win, Left);
+  Mss   = TcpGetSegmentMss (Tcb);
 
-  if (Len > Tcb->SndMss) {
-    Len = Tcb->SndMss;
+  if (Len > Mss) {
+    Len = Mss;
   }
 
   if ((Force != 0)|| (Len == 0 && Left == 0)) {
@@ -230,7 +249,7 @@ TcpDataToSend (
   // c)It can send everything it has, and either it isn't
   // expecting an ACK, or the Nagle algorithm is disabled.
   //
-  if ((Len == Tcb->SndMss) || (2 * Len >= Tcb->SndWndMax)) {
+  if ((Len == Mss) || (2 * Len >= Tcb->SndWndMax)) {
 
     return Len;
   }
@@ -662,7 +681,7 @@ TcpRetransmit (
   //
   // Compute the maxium length of retransmission. It is
   // limited by three factors:
-  // 1. Less than SndMss
+  // 1. Less than SndMss, less the SACK option
   // 2. Must in the current send window
   // 3. Will not change the boundaries of queued segments.
   //
@@ -696,7 +715,7 @@ TcpRetransmit (
     return 0;
   }
 
-  Len = MIN (Len, Tcb->SndMss);
+  Len = MIN (Len, TcpGetSegmentMss (Tcb));
 
   Nbuf = TcpGetSegmentSndQue (Tcb, Seq, Len);
   if (Nbuf == NULL) {
@@ -970,7 +989,7 @@ TcpToSendData (
       Tcb->RttMeasure = 0;
     }
 
-  } while (Len == Tcb->SndMss);
+  } while (Len == TcpGetSegmentMss (Tcb));
 
   return Sent;
 
@@ -72,6 +72,8 @@
 #define TCP_CTRL_TIMER_ON        0x1000 ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON          0x2000 ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW         0x4000 ///< Send the ACK now, don't delay.
+#define TCP_CTRL_NO_SACK         0x8000 ///< Disable SACK option.
+#define TCP_CTRL_RCVD_SACK      0x10000 ///< Received a SACK permitted option in syn.
 
 //
 // Timer related values
@@ -207,6 +209,17 @@
 
 #define TCP_MAX_WIN                   0xFFFFU
 
+//
+// The number of SACK blocks the sender keeps in its scoreboard.
+//
+#define TCP_SND_SACK_BLOCKS           8
+
+//
+// Congestion control selected by PcdTcpCongestionControl.
+//
+#define TCP_CONGESTION_RENO           0
+#define TCP_CONGESTION_CUBIC          1
+
 ///
 /// TCP segmentation data.
 ///
@@ -219,6 +232,14 @@ typedef struct _TCP_SEG {
   UINT32    Wnd;  ///< TCP window size field.
 } TCP_SEG;
 
+///
+/// A block of contiguous sequence space, as reported by the SACK option.
+///
+typedef struct _TCP_SACK_BLOCK {
+  TCP_SEQNO Left;  ///< The first sequence number of the block.
+  TCP_SEQNO Right; ///< The sequence number following the last byte of the block.
+} TCP_SACK_BLOCK;
+
 ///
 /// Network endpoint, IP plus Port structure.
 ///
@@ -229,6 +250,70 @@ typedef struct _TCP_PEER {
 
 typedef struct _TCP_CONTROL_BLOCK  TCP_CB;
 
+/**
+  Initialize the congestion control state of a new connection.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+typedef
+VOID
+(*TCP_CONGESTION_INIT) (
+  IN OUT TCP_CB *Tcb
+  );
+
+/**
+  Open the congestion window when new data is ACKed in congestion avoidance,
+  that is when CWnd is not less than Ssthresh.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Acked    The number of bytes newly ACKed.
+
+**/
+typedef
+VOID
+(*TCP_CONGESTION_AVOID) (
+  IN OUT TCP_CB *Tcb,
+  IN     UINT32 Acked
+  );
+
+/**
+  Compute the slow start threshold when a loss is detected, either by
+  duplicate ACKs or by the retransmission timeout.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+  @return The new slow start threshold.
+
+**/
+typedef
+UINT32
+(*TCP_CONGESTION_SSTHRESH) (
+  IN OUT TCP_CB *Tcb
+  );
+
+///
+/// Congestion control algorithm. Slow start, fast retransmission and
+/// fast recovery are common to all of them.
+///
+typedef struct _TCP_CONGESTION_OPS {
+  TCP_CONGESTION_INIT      Init;
+  TCP_CONGESTION_AVOID     CongestionAvoid;
+  TCP_CONGESTION_SSTHRESH  Ssthresh;
+} TCP_CONGESTION_OPS;
+
+///
+/// CUBIC congestion control state, RFC8312. Times are in TCP ticks.
+///
+typedef struct _TCP_CUBIC {
+  BOOLEAN           EpochOn;    ///< TRUE if the congestion avoidance epoch started.
+  UINT32            EpochStart; ///< When the current epoch started.
+  UINT32            K;          ///< Time for the window to grow back to Origin.
+  UINT32            Origin;     ///< Window at the plateau of the cubic function.
+  UINT32            WMax;       ///< Window before the last window reduction.
+  UINT32            WEst;       ///< Window of standard TCP in the same conditions.
+} TCP_CUBIC;
+
 ///
 /// TCP control block: it includes various states.
 ///
@@ -315,6 +400,21 @@ struct _TCP_CONTROL_BLOCK {
   //
   TCP_SEQNO         RetxmitSeqMax;       ///< Max Seq number in previous retransmission.
 
+  //
+  // RFC2018 and RFC6675 variables.
+  // Selective acknowledgment and SACK based loss recovery.
+  //
+  TCP_SEQNO         RcvSackSeq;                   ///< Seq of the last segment queued to RcvQue.
+  TCP_SACK_BLOCK    SndSack[TCP_SND_SACK_BLOCKS]; ///< Data SACKed by the peer, in sequence order.
+  UINT8             SndSackCount;                 ///< Number of blocks in SndSack.
+  TCP_SEQNO         HighRxt;                      ///< End of the last retransmission in fast recovery.
+
+  //
+  // Congestion control algorithm, and its state.
+  //
+  CONST TCP_CONGESTION_OPS  *CongestionOps;
+  TCP_CUBIC                 Cubic;
+
   //
   // configuration parameters, for EFI_TCP4_PROTOCOL specification
   //
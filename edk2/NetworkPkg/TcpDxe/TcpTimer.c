@@ -184,8 +184,6 @@ TcpRexmitTimeout (
   IN OUT TCP_CB *Tcb
   )
 {
-  UINT32  FlightSize;
-
   DEBUG (
     (EFI_D_WARN,
     "TcpRexmitTimeout: transmission timeout for TCB %p\n",
@@ -193,16 +191,19 @@ TcpRexmitTimeout (
     );
 
   //
-  // Set the congestion window. FlightSize is the
-  // amount of data that has been sent but not
-  // yet ACKed.
+  // Set the congestion window.
   //
-  FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
-  Tcb->Ssthresh     = MAX ((UINT32) (2 * Tcb->SndMss), FlightSize / 2);
+  Tcb->Ssthresh     = Tcb->CongestionOps->Ssthresh (Tcb);
 
   Tcb->CWnd         = Tcb->SndMss;
   Tcb->LossRecover  = Tcb->SndNxt;
 
+  //
+  // The peer may have discarded the data it SACKed, RFC2018
+  // requires to retransmit it after a timeout.
+  //
+  Tcb->SndSackCount = 0;
+
   Tcb->LossTimes++;
   if ((Tcb->LossTimes > Tcb->MaxRexmit) && !TCP_TIMER_ON (Tcb->EnabledTimer, TCP_TIMER_CONNECT)) {
 
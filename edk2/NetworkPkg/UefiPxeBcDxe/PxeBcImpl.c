@@ -219,6 +219,11 @@ EfiPxeBcStart (
     Private->BlockSize   = (UINTN) PcdGet64 (PcdTftpBlockSize);
   }
 
+  //
+  // Start the TFTP windowsize over from PcdPxeTftpWindowSize on this network.
+  //
+  Private->TftpWindowSize = 0;
+
   //
   // Create event for UdpRead/UdpWrite timeout since they are both blocking API.
   //
@@ -868,9 +873,13 @@ EfiPxeBcMtftp (
   Mode      = Private->PxeBc.Mode;
 
   //
-  // Get PcdPxeTftpWindowSize.
+  // Get PcdPxeTftpWindowSize. It is the windowsize of the first read; the
+  // next ones use the windowsize adapted to the losses of the previous one.
   //
   WindowSize = (UINTN) PcdGet64 (PcdPxeTftpWindowSize);
+  if ((WindowSize > 1) && (Private->TftpWindowSize != 0)) {
+    WindowSize = Private->TftpWindowSize;
+  }
 
   if (Mode->UsingIpv6) {
     if (!NetIp6IsValidUnicast (&ServerIp->v6)) {
@@ -917,6 +926,8 @@ EfiPxeBcMtftp (
 
   Mode->TftpErrorReceived = FALSE;
   Mode->IcmpErrorReceived = FALSE;
+  Private->TftpLastBlock  = 0;
+  Private->TftpBlockLost  = FALSE;
 
   switch (Operation) {
 
@@ -998,6 +1009,20 @@ EfiPxeBcMtftp (
     break;
   }
 
+  if ((WindowSize > 1) &&
+      ((Operation == EFI_PXE_BASE_CODE_TFTP_READ_FILE) ||
+       (Operation == EFI_PXE_BASE_CODE_TFTP_READ_DIRECTORY))) {
+    //
+    // Halve the windowsize after a read that lost blocks, as the path
+    // can't take that many in flight, and double it after a clean one.
+    //
+    if (Private->TftpBlockLost || (Status == EFI_TIMEOUT)) {
+      Private->TftpWindowSize = MAX (WindowSize / 2, 2);
+    } else if (!EFI_ERROR (Status) && (WindowSize < PXEBC_MTFTP_MAX_WINDOWSIZE)) {
+      Private->TftpWindowSize = MIN (WindowSize * 2, PXEBC_MTFTP_MAX_WINDOWSIZE);
+    }
+  }
+
   if (Status == EFI_ICMP_ERROR) {
     Mode->IcmpErrorReceived = TRUE;
   }
@@ -66,6 +66,7 @@ typedef struct _PXEBC_VIRTUAL_NIC   PXEBC_VIRTUAL_NIC;
 #define PXEBC_DAD_ADDITIONAL_DELAY    30000000 // 3 seconds
 #define PXEBC_MTFTP_TIMEOUT           4
 #define PXEBC_MTFTP_RETRIES           6
+#define PXEBC_MTFTP_MAX_WINDOWSIZE    64
 #define PXEBC_DHCP_RETRIES            4        // refers to mPxeDhcpTimeout, also by PXE2.1 spec.
 #define PXEBC_MENU_MAX_NUM            24
 #define PXEBC_OFFER_MAX_NUM           16
@@ -180,6 +181,14 @@ struct _PXEBC_PRIVATE_DATA {
   UINTN                                     BootFileSize;
   UINTN                                     BlockSize;
 
+  //
+  // The TFTP windowsize for the next read, adapted to the losses of the
+  // previous ones, and the loss tracking of the current read.
+  //
+  UINTN                                     TftpWindowSize;
+  UINT16                                    TftpLastBlock;
+  BOOLEAN                                   TftpBlockLost;
+
   PXEBC_DHCP_PACKET_CACHE                   ProxyOffer;
   PXEBC_DHCP_PACKET_CACHE                   DhcpAck;
   PXEBC_DHCP_PACKET_CACHE                   PxeReply;
@@ -68,6 +68,16 @@ PxeBcMtftp6CheckPacket (
     Private->Mode.TftpError.ErrorString[PXE_MTFTP_ERROR_STRING_LENGTH - 1] = '\0';
   }
 
+  if (NTOHS (Packet->OpCode) == EFI_MTFTP6_OPCODE_DATA) {
+    //
+    // Mtftp checks each block once, out of order if one before it was lost.
+    //
+    if (NTOHS (Packet->Data.Block) != (UINT16) (Private->TftpLastBlock + 1)) {
+      Private->TftpBlockLost = TRUE;
+    }
+    Private->TftpLastBlock = NTOHS (Packet->Data.Block);
+  }
+
   if (Callback != NULL) {
     //
     // Callback to user if has when received any tftp packet.
@@ -548,6 +558,16 @@ PxeBcMtftp4CheckPacket (
     Private->Mode.TftpError.ErrorString[PXE_MTFTP_ERROR_STRING_LENGTH - 1] = '\0';
   }
 
+  if (NTOHS (Packet->OpCode) == EFI_MTFTP4_OPCODE_DATA) {
+    //
+    // Mtftp checks each block once, out of order if one before it was lost.
+    //
+    if (NTOHS (Packet->Data.Block) != (UINT16) (Private->TftpLastBlock + 1)) {
+      Private->TftpBlockLost = TRUE;
+    }
+    Private->TftpLastBlock = NTOHS (Packet->Data.Block);
+  }
+
   if (Callback != NULL) {
     //
     // Callback to user if has when received any tftp packet.
@@ -101,7 +101,7 @@ typedef struct {
   volatile UINT16 *Idx;
 
   volatile UINT16 *Ring;      // QueueSize elements
-  volatile UINT16 *UsedEvent; // unused as per negotiation
+  volatile UINT16 *UsedEvent; // only with VIRTIO_F_RING_EVENT_IDX
 } VRING_AVAIL;
 
 
@@ -121,7 +121,7 @@ typedef struct {
   volatile UINT16          *Flags;
   volatile UINT16          *Idx;
   volatile VRING_USED_ELEM *UsedElem;   // QueueSize elements
-  volatile UINT16          *AvailEvent; // unused as per negotiation
+  volatile UINT16          *AvailEvent; // only with VIRTIO_F_RING_EVENT_IDX
 } VRING_USED;
 
 
@@ -18,17 +18,36 @@
 #define CLEAR_STATUS_CMD         0x50
 #define READ_STATUS_CMD          0x70
 #define READ_DEVID_CMD           0x90
+#define CFI_QUERY_CMD            0x98
 #define BLOCK_ERASE_CONFIRM_CMD  0xd0
+#define WRITE_BUFFER_CONFIRM_CMD 0xd0
+#define WRITE_BUFFER_CMD         0xe8
 #define READ_ARRAY_CMD           0xff
 
 #define CLEARED_ARRAY_STATUS  0x00
 
+//
+// CFI query offsets, for a device of byte width.
+//
+#define CFI_QUERY_ADDRESS             0x55
+#define CFI_QUERY_STRING_OFFSET       0x10
+#define CFI_PRIMARY_COMMAND_SET       0x13
+#define CFI_MAX_WRITE_BUFFER_OFFSET   0x2a
+
+#define CFI_INTEL_COMMAND_SET         0x0001
+
 
 UINT8 *mFlashBase;
 
 STATIC UINTN       mFdBlockSize = 0;
 STATIC UINTN       mFdBlockCount = 0;
 
+//
+// Size of the write buffer of the device, 0 if writes must be programmed one
+// byte at a time.
+//
+STATIC UINTN       mWriteBufferSize = 0;
+
 STATIC
 volatile UINT8*
 QemuFlashPtr (
@@ -108,6 +127,82 @@ QemuFlashDetected (
 }
 
 
+/**
+  Get the size of the write buffer of the QEMU flash device.
+
+  The device must be in read array mode, and is left in read array mode.
+
+  @return The size of the write buffer in bytes, or 0 if the device does not
+          support the Intel/Sharp write to buffer command.
+
+**/
+STATIC
+UINTN
+QemuFlashGetWriteBufferSize (
+  VOID
+  )
+{
+  volatile UINT8  *Ptr;
+  UINT16          CommandSet;
+  UINT8           BufferShift;
+
+  Ptr = QemuFlashPtr (0, 0);
+  Ptr[CFI_QUERY_ADDRESS] = CFI_QUERY_CMD;
+
+  if (Ptr[CFI_QUERY_STRING_OFFSET] != 'Q' ||
+      Ptr[CFI_QUERY_STRING_OFFSET + 1] != 'R' ||
+      Ptr[CFI_QUERY_STRING_OFFSET + 2] != 'Y') {
+    *Ptr = READ_ARRAY_CMD;
+    return 0;
+  }
+
+  CommandSet  = (UINT16) (Ptr[CFI_PRIMARY_COMMAND_SET] | (Ptr[CFI_PRIMARY_COMMAND_SET + 1] << 8));
+  BufferShift = Ptr[CFI_MAX_WRITE_BUFFER_OFFSET];
+  *Ptr = READ_ARRAY_CMD;
+
+  //
+  // The buffer size is 2^N bytes, and the byte count of the command is 8-bit.
+  //
+  if (CommandSet != CFI_INTEL_COMMAND_SET || BufferShift == 0 || BufferShift > 8) {
+    return 0;
+  }
+  return (UINTN) 1 << BufferShift;
+}
+
+
+/**
+  Program a range of QEMU Flash with one write to buffer command.
+
+  The range must not cross a boundary of the write buffer size. The device is
+  left in read array mode.
+
+  @param[in] Ptr      The flash address to program.
+  @param[in] Buffer   The data to program.
+  @param[in] Count    The number of bytes to program, at least 1.
+
+**/
+STATIC
+VOID
+QemuFlashProgramBuffer (
+  IN  volatile UINT8    *Ptr,
+  IN  UINT8             *Buffer,
+  IN  UINTN             Count
+  )
+{
+  UINTN           Loop;
+
+  ASSERT (Count > 0 && Count <= mWriteBufferSize);
+
+  *Ptr = WRITE_BUFFER_CMD;
+  *Ptr = (UINT8) (Count - 1);
+  for (Loop = 0; Loop < Count; Loop++) {
+    Ptr[Loop] = Buffer[Loop];
+  }
+  *Ptr = WRITE_BUFFER_CONFIRM_CMD;
+  *Ptr = READ_ARRAY_CMD;
+}
+
+
 /**
   Read from QEMU Flash
 
@@ -167,6 +262,8 @@ QemuFlashWrite (
 {
   volatile UINT8  *Ptr;
   UINTN           Loop;
+  UINTN           Start;
+  UINTN           End;
 
   //
   // Only write to the first 64k. We don't bother saving the FTW Spare
@@ -177,20 +274,60 @@ QemuFlashWrite (
   }
 
   //
-  // Program flash
+  // Every access to the device in command mode is trapped, while the flash
+  // reads directly in read array mode. Bytes that already hold the data are
+  // not programmed, which leaves them unchanged.
   //
   Ptr = QemuFlashPtr (Lba, Offset);
-  for (Loop = 0; Loop < *NumBytes; Loop++) {
-    *Ptr = WRITE_BYTE_CMD;
-    *Ptr = Buffer[Loop];
-    Ptr++;
+
+  if (mWriteBufferSize == 0) {
+    //
+    // Program flash from the first to the last byte that changes.
+    //
+    Start = 0;
+    End   = *NumBytes;
+    while (Start < End && Ptr[Start] == Buffer[Start]) {
+      Start++;
+    }
+    while (End > Start && Ptr[End - 1] == Buffer[End - 1]) {
+      End--;
+    }
+
+    for (Loop = Start; Loop < End; Loop++) {
+      Ptr[Loop] = WRITE_BYTE_CMD;
+      Ptr[Loop] = Buffer[Loop];
+    }
+
+    //
+    // Restore flash to read mode
+    //
+    if (End > Start) {
+      Ptr[End - 1] = READ_ARRAY_CMD;
+    }
+
+    return EFI_SUCCESS;
   }
 
   //
-  // Restore flash to read mode
+  // Program flash one write buffer at a time, from the first to the last
+  // byte that changes in the range of each buffer. The device returns to read
+  // array mode after each buffer, for the next comparison.
   //
-  if (*NumBytes > 0) {
-    *(Ptr - 1) = READ_ARRAY_CMD;
+  Start = 0;
+  while (Start < *NumBytes) {
+    if (Ptr[Start] == Buffer[Start]) {
+      Start++;
+      continue;
+    }
+
+    End = Start + mWriteBufferSize - ((UINTN) (Ptr + Start - mFlashBase) & (mWriteBufferSize - 1));
+    End = MIN (End, *NumBytes);
+    while (Ptr[End - 1] == Buffer[End - 1]) {
+      End--;
+    }
+
+    QemuFlashProgramBuffer (Ptr + Start, Buffer + Start, End - Start);
+    Start = End;
   }
 
   return EFI_SUCCESS;
@@ -209,14 +346,32 @@ QemuFlashEraseBlock (
   )
 {
   volatile UINT8  *Ptr;
+  UINTN           Offset;
 
   if (Lba >= mFdBlockCount) {
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // A block that is already erased is not erased again.
+  //
   Ptr = QemuFlashPtr (Lba, 0);
+  for (Offset = 0; Offset < mFdBlockSize; Offset++) {
+    if (Ptr[Offset] != 0xff) {
+      break;
+    }
+  }
+  if (Offset == mFdBlockSize) {
+    return EFI_SUCCESS;
+  }
+
   *Ptr = BLOCK_ERASE_CMD;
   *Ptr = BLOCK_ERASE_CONFIRM_CMD;
+
+  //
+  // Restore flash to read mode, the next write compares with the array.
+  //
+  *Ptr = READ_ARRAY_CMD;
   return EFI_SUCCESS;
 }
 
@@ -252,6 +407,9 @@ QemuFlashInitialize (
     return EFI_WRITE_PROTECTED;
   }
 
+  mWriteBufferSize = QemuFlashGetWriteBufferSize ();
+  DEBUG ((EFI_D_INFO, "QEMU Flash: write buffer size %d\n", mWriteBufferSize));
+
   return EFI_SUCCESS;
 }
 
@@ -13,6 +13,7 @@
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Protocol/IoMmu.h>
 
 #include "VirtioNet.h"
 
@@ -199,6 +200,10 @@ VirtioNetSnpPopulate (
   Dev->Snp.Receive        = &VirtioNetReceive;
   Dev->Snp.Mode           = &Dev->Snm;
 
+  Dev->RxLoan.Receive     = &VirtioNetRxLoanReceive;
+  Dev->RxLoan.Recycle     = &VirtioNetRxLoanRecycle;
+  Dev->RxLoan.MaxLoans    = 0;
+
   Dev->Snm.State                 = EfiSimpleNetworkStopped;
   Dev->Snm.HwAddressSize         = SIZE_OF_VNET (Mac);
   Dev->Snm.MediaHeaderSize       = SIZE_OF_VNET (Mac) + // dst MAC
@@ -437,6 +442,7 @@ VirtioNetDriverBindingStart (
   EFI_DEVICE_PATH_PROTOCOL *DevicePath;
   MAC_ADDR_DEVICE_PATH     MacNode;
   VOID                     *ChildVirtIo;
+  VOID                     *Interface;
 
   //
   // allocate space for the driver instance
@@ -501,6 +507,18 @@ VirtioNetDriverBindingStart (
     goto FreeMacDevicePath;
   }
 
+  //
+  // Lend the receive buffers to the protocol stack, unless they are bounce
+  // buffers shared with the host because of an IOMMU, such as with SEV: the
+  // host could modify the packets while the protocol stack parses them. This
+  // is an optional optimization, ignore errors.
+  //
+  if (EFI_ERROR (gBS->LocateProtocol (&gEdkiiIoMmuProtocolGuid, NULL, &Interface))) {
+    gBS->InstallProtocolInterface (&Dev->MacHandle,
+           &gEdkiiSimpleNetworkRxLoanProtocolGuid, EFI_NATIVE_INTERFACE,
+           &Dev->RxLoan);
+  }
+
   //
   // make a note that we keep this device open with VirtIo for the sake of this
   // child
@@ -515,6 +533,8 @@ VirtioNetDriverBindingStart (
   return EFI_SUCCESS;
 
 UninstallMultiple:
+  gBS->UninstallProtocolInterface (Dev->MacHandle,
+         &gEdkiiSimpleNetworkRxLoanProtocolGuid, &Dev->RxLoan);
   gBS->UninstallMultipleProtocolInterfaces (Dev->MacHandle,
          &gEfiDevicePathProtocolGuid,    Dev->MacDevicePath,
          &gEfiSimpleNetworkProtocolGuid, &Dev->Snp,
@@ -614,6 +634,8 @@ VirtioNetDriverBindingStop (
     else {
       gBS->CloseProtocol (DeviceHandle, &gVirtioDeviceProtocolGuid,
              This->DriverBindingHandle, Dev->MacHandle);
+      gBS->UninstallProtocolInterface (Dev->MacHandle,
+             &gEdkiiSimpleNetworkRxLoanProtocolGuid, &Dev->RxLoan);
       gBS->UninstallMultipleProtocolInterfaces (Dev->MacHandle,
              &gEfiDevicePathProtocolGuid,    Dev->MacDevicePath,
              &gEfiSimpleNetworkProtocolGuid, &Dev->Snp,
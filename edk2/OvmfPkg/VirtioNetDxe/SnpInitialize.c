@@ -259,9 +259,11 @@ VirtioNetInitTx (
   ASSERT (Dev->TxLastUsed == 0);
 
   //
-  // want no interrupt when a transmit completes
+  // want no interrupt when a transmit completes; with the event index, the
+  // device ignores the flag, so put the used event as far as possible
   //
   *Dev->TxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  *Dev->TxRing.Avail.UsedEvent = MAX_UINT16;
 
   return EFI_SUCCESS;
 
@@ -315,6 +317,7 @@ VirtioNetInitRx (
   EFI_STATUS            Status;
   UINTN                 VirtioNetReqSize;
   UINTN                 RxBufSize;
+  UINTN                 RxDataOffset;
   UINT16                RxAlwaysPending;
   UINTN                 PktIdx;
   UINT16                DescIdx;
@@ -336,8 +339,17 @@ VirtioNetInitRx (
   // - the recipient for the network data (which consists of Ethernet header
   //   and Ethernet payload).
   //
-  RxBufSize = VirtioNetReqSize +
-              (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize);
+  // The network data is placed so that the Ethernet payload is 4-byte
+  // aligned, as the RX buffers may be lent to the protocol stack, which
+  // parses the packets in place.
+  //
+  RxDataOffset = ALIGN_VALUE (VirtioNetReqSize + Dev->Snm.MediaHeaderSize, 4) -
+                 Dev->Snm.MediaHeaderSize;
+  RxBufSize    = ALIGN_VALUE (
+                   RxDataOffset +
+                   (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize),
+                   4
+                   );
 
   //
   // Limit the number of pending RX packets if the queue is big. The division
@@ -345,6 +357,13 @@ VirtioNetInitRx (
   //
   RxAlwaysPending = (UINT16) MIN (Dev->RxRing.QueueSize / 2, VNET_MAX_PENDING);
 
+  //
+  // Lend at most half of the RX buffers, so that the device can still receive
+  // packets when the protocol stack holds the lent ones.
+  //
+  Dev->RxLoan.MaxLoans = RxAlwaysPending / 2;
+  Dev->RxLoanCount     = 0;
+
   //
   // The RxBuf is shared between guest and hypervisor, use
   // AllocateSharedPages() to allocate this memory region and map it with
@@ -391,6 +410,7 @@ VirtioNetInitRx (
   // and VirtioNetIsPacketAvailable().
   //
   *Dev->RxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  *Dev->RxRing.Avail.UsedEvent = MAX_UINT16;
 
   //
   // now set up a separate, two-part descriptor chain for each RX packet, and
@@ -412,12 +432,15 @@ VirtioNetInitRx (
     Dev->RxRing.Desc[DescIdx].Len   = (UINT32) VirtioNetReqSize;
     Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
     Dev->RxRing.Desc[DescIdx].Next  = (UINT16) (DescIdx + 1);
-    RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
+    DescIdx++;
 
-    Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
-    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) (RxBufSize - VirtioNetReqSize);
+    Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress + RxDataOffset;
+    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) (Dev->Snm.MediaHeaderSize +
+                                                Dev->Snm.MaxPacketSize);
     Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
-    RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
+    DescIdx++;
+
+    RxBufDeviceAddress += RxBufSize;
   }
 
   //
@@ -557,7 +580,13 @@ VirtioNetInitialize (
     !!(Features & VIRTIO_NET_F_STATUS));
 
   Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+              VIRTIO_F_IOMMU_PLATFORM | VIRTIO_F_RING_EVENT_IDX;
+
+  //
+  // With the event index, the device tells exactly from which available
+  // index it needs a notification; see VirtioNetPublishAvail().
+  //
+  Dev->RingEventIdx = (BOOLEAN) ((Features & VIRTIO_F_RING_EVENT_IDX) != 0);
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -0,0 +1,181 @@
+/** @file
+
+  Implementation of the Simple Network Receive Loan protocol, which lends the
+  packet sub-slices of the Receive Destination Area instead of copying them.
+
+  Copyright (C) 2013, Red Hat, Inc.
+  Copyright (c) 2019, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "VirtioNet.h"
+
+//
+// The token of a lent buffer is the head descriptor index of its slice, and
+// the generation of the receive area it belongs to in the bits above it.
+//
+#define RX_LOAN_TOKEN(Generation, DescIdx) \
+          ((VOID *)(UINTN)(((UINTN)(Generation) << 16) | (DescIdx)))
+#define RX_LOAN_TOKEN_GENERATION(Token)   ((UINT16)((UINTN)(Token) >> 16))
+#define RX_LOAN_TOKEN_DESC_IDX(Token)     ((UINT16)(UINTN)(Token))
+
+/**
+  Receives a packet from the network interface, in a buffer lent by the network
+  interface. The buffer must be given back with VirtioNetRxLoanRecycle().
+
+  @param[in]  This              The pointer to this protocol instance.
+  @param[out] HeaderSize        The size, in bytes, of the media header received
+                                on the network interface.
+  @param[out] BufferSize        The size, in bytes, of the packet received on the
+                                network interface, media header included.
+  @param[out] Buffer            The lent buffer that holds both the media header
+                                and the data.
+  @param[out] Token             The token to give to VirtioNetRxLoanRecycle() to
+                                return the buffer.
+
+  @retval EFI_SUCCESS           A packet was received in the lent buffer.
+  @retval EFI_NOT_STARTED       The network interface has not been started.
+  @retval EFI_NOT_READY         No packet has been received on the network
+                                interface.
+  @retval EFI_OUT_OF_RESOURCES  MaxLoans buffers are lent already.
+  @retval EFI_INVALID_PARAMETER One or more of the parameters is NULL.
+  @retval EFI_DEVICE_ERROR      The command could not be sent to the network
+                                interface.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioNetRxLoanReceive (
+  IN  EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL *This,
+  OUT UINTN                                 *HeaderSize,
+  OUT UINTN                                 *BufferSize,
+  OUT VOID                                  **Buffer,
+  OUT VOID                                  **Token
+  )
+{
+  VNET_DEV   *Dev;
+  EFI_TPL    OldTpl;
+  EFI_STATUS Status;
+  UINT16     RxCurUsed;
+  UINT16     UsedElemIdx;
+  UINT32     DescIdx;
+  UINT32     RxLen;
+  UINTN      RxBufOffset;
+
+  if (This == NULL || HeaderSize == NULL || BufferSize == NULL ||
+      Buffer == NULL || Token == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Dev = VIRTIO_NET_FROM_RX_LOAN (This);
+
+  //
+  // VirtioNetRxLoanRecycle() updates RxLoanCount at TPL_NOTIFY.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  switch (Dev->Snm.State) {
+  case EfiSimpleNetworkStopped:
+    Status = EFI_NOT_STARTED;
+    goto Exit;
+  case EfiSimpleNetworkStarted:
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
+  default:
+    break;
+  }
+
+  if (Dev->RxLoanCount >= This->MaxLoans) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  MemoryFence ();
+  RxCurUsed = *Dev->RxRing.Used.Idx;
+  MemoryFence ();
+
+  if (Dev->RxLastUsed == RxCurUsed) {
+    Status = EFI_NOT_READY;
+    goto Exit;
+  }
+
+  UsedElemIdx = Dev->RxLastUsed % Dev->RxRing.QueueSize;
+  DescIdx = Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
+  RxLen   = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
+
+  //
+  // the virtio-net request header must be complete; we skip it
+  //
+  ASSERT (RxLen >= Dev->RxRing.Desc[DescIdx].Len);
+  RxLen -= Dev->RxRing.Desc[DescIdx].Len;
+  //
+  // the host must not have filled in more data than requested
+  //
+  ASSERT (RxLen <= Dev->RxRing.Desc[DescIdx + 1].Len);
+
+  ++Dev->RxLastUsed;
+
+  if (RxLen < Dev->Snm.MediaHeaderSize) {
+    //
+    // drop useless short packet
+    //
+    VirtioNetRecycleRxDesc (Dev, (UINT16) DescIdx);
+    Status = EFI_DEVICE_ERROR;
+    goto Exit;
+  }
+
+  RxBufOffset = (UINTN)(Dev->RxRing.Desc[DescIdx + 1].Addr -
+                        Dev->RxBufDeviceBase);
+
+  *HeaderSize = Dev->Snm.MediaHeaderSize;
+  *BufferSize = RxLen;
+  *Buffer     = Dev->RxBuf + RxBufOffset;
+  *Token      = RX_LOAN_TOKEN (Dev->RxLoanGeneration, DescIdx);
+
+  ++Dev->RxLoanCount;
+  Status = EFI_SUCCESS;
+
+Exit:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Gives back to the network interface a buffer lent by VirtioNetRxLoanReceive().
+
+  The buffers lent before the network interface was last shut down are not
+  part of its current Receive Destination Area, and are ignored.
+
+  @param[in]  This              The pointer to this protocol instance.
+  @param[in]  Token             The token returned by VirtioNetRxLoanReceive()
+                                with the buffer.
+
+**/
+VOID
+EFIAPI
+VirtioNetRxLoanRecycle (
+  IN EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL  *This,
+  IN VOID                                   *Token
+  )
+{
+  VNET_DEV   *Dev;
+  EFI_TPL    OldTpl;
+
+  Dev = VIRTIO_NET_FROM_RX_LOAN (This);
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Dev->Snm.State == EfiSimpleNetworkInitialized &&
+      RX_LOAN_TOKEN_GENERATION (Token) == Dev->RxLoanGeneration) {
+    ASSERT (Dev->RxLoanCount > 0);
+    --Dev->RxLoanCount;
+    VirtioNetRecycleRxDesc (Dev, RX_LOAN_TOKEN_DESC_IDX (Token));
+  }
+  gBS->RestoreTPL (OldTpl);
+}
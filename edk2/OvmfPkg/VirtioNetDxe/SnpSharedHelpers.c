@@ -8,7 +8,10 @@
 
 **/
 
+#include <Library/BaseLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
 
 #include "VirtioNet.h"
 
@@ -43,6 +46,29 @@ VirtioNetShutdownRx (
   IN OUT VNET_DEV *Dev
   )
 {
+  EFI_TPL OldTpl;
+  UINT16  RxLoanCount;
+
+  //
+  // Make the tokens of the RX buffers still lent stale, so that recycling
+  // them doesn't touch the ring being torn down.
+  //
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  RxLoanCount = Dev->RxLoanCount;
+  Dev->RxLoanCount = 0;
+  ++Dev->RxLoanGeneration;
+  gBS->RestoreTPL (OldTpl);
+
+  if (RxLoanCount > 0) {
+    //
+    // The lent buffers must remain valid until they are recycled, so we can
+    // only leak the RX buffer.
+    //
+    DEBUG ((DEBUG_WARN, "%a: leaking RX buffer with %d lent packets\n",
+      __FUNCTION__, RxLoanCount));
+    return;
+  }
+
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RxBufMap);
   Dev->VirtIo->FreeSharedPages (
                  Dev->VirtIo,
@@ -83,6 +109,110 @@ VirtioNetShutdownTx (
   FreePool (Dev->TxFreeStack);
 }
 
+
+/**
+  Publish the descriptor chains linked into the available ring of a queue, and
+  notify the device unless it doesn't need the notification.
+
+  The device suppresses the notifications while it is processing the queue
+  anyway, either with the event index or with VRING_USED_F_NO_NOTIFY, so that a
+  burst of packets costs a single notification (VM exit) instead of one per
+  packet.
+
+  @param[in,out] Dev          The VNET_DEV driver instance.
+  @param[in,out] Ring         The ring of the queue.
+  @param[in]     Queue        The index of the queue.
+  @param[in]     NewAvailIdx  The available index after the descriptor chains
+                              linked into the available ring.
+
+  @return  Status codes from VIRTIO_DEVICE_PROTOCOL.SetQueueNotify().
+*/
+EFI_STATUS
+EFIAPI
+VirtioNetPublishAvail (
+  IN OUT VNET_DEV *Dev,
+  IN OUT VRING    *Ring,
+  IN     UINT16   Queue,
+  IN     UINT16   NewAvailIdx
+  )
+{
+  UINT16 OldAvailIdx;
+  UINT16 AvailEvent;
+
+  //
+  // the available index is never written by the host, we can read it back
+  // without a barrier
+  //
+  OldAvailIdx = *Ring->Avail.Idx;
+
+  //
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field: the ring entries must be
+  // visible before the index. The index is written with an interlocked
+  // operation, which is a full barrier: the device may enable notifications
+  // right before we read whether they are suppressed, but then it reads the
+  // new index after it enabled them.
+  //
+  MemoryFence ();
+  InterlockedCompareExchange16 (Ring->Avail.Idx, OldAvailIdx, NewAvailIdx);
+
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying The Device
+  //
+  if (Dev->RingEventIdx) {
+    //
+    // notify only if the event index is among the entries just published
+    //
+    AvailEvent = *Ring->Used.AvailEvent;
+    if ((UINT16) (NewAvailIdx - AvailEvent - 1) >=
+        (UINT16) (NewAvailIdx - OldAvailIdx)) {
+      return EFI_SUCCESS;
+    }
+  } else if ((*Ring->Used.Flags & VRING_USED_F_NO_NOTIFY) != 0) {
+    return EFI_SUCCESS;
+  }
+
+  return Dev->VirtIo->SetQueueNotify (Dev->VirtIo, Queue);
+}
+
+
+/**
+  Give an RX buffer back to the device, by linking its descriptor chain into
+  the available ring.
+
+  The available ring is updated at TPL_NOTIFY, because the RX buffers lent
+  through the Simple Network Receive Loan Protocol may be recycled at that
+  TPL.
+
+  @param[in,out] Dev      The VNET_DEV driver instance.
+  @param[in]     DescIdx  The head of the descriptor chain of the RX buffer.
+
+  @return  Status codes from VIRTIO_DEVICE_PROTOCOL.SetQueueNotify().
+*/
+EFI_STATUS
+EFIAPI
+VirtioNetRecycleRxDesc (
+  IN OUT VNET_DEV *Dev,
+  IN     UINT16   DescIdx
+  )
+{
+  EFI_TPL    OldTpl;
+  UINT16     AvailIdx;
+  EFI_STATUS Status;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+
+  //
+  // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
+  //
+  AvailIdx = *Dev->RxRing.Avail.Idx;
+  Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] = DescIdx;
+
+  Status = VirtioNetPublishAvail (Dev, &Dev->RxRing, VIRTIO_NET_Q_RX, AvailIdx);
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
 /**
   Release TX and RX VRING resources.
 
@@ -20,6 +20,7 @@
 #include <Protocol/DevicePath.h>
 #include <Protocol/DriverBinding.h>
 #include <Protocol/SimpleNetwork.h>
+#include <Protocol/SimpleNetworkRxLoan.h>
 #include <Library/OrderedCollectionLib.h>
 
 #define VNET_SIG SIGNATURE_32 ('V', 'N', 'E', 'T')
@@ -76,6 +77,10 @@ typedef struct {
   EFI_EVENT                   ExitBoot;          // VirtioNetSnpPopulate
   EFI_DEVICE_PATH_PROTOCOL    *MacDevicePath;    // VirtioNetDriverBindingStart
   EFI_HANDLE                  MacHandle;         // VirtioNetDriverBindingStart
+  EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL RxLoan;   // VirtioNetSnpPopulate
+                                                 // and VirtioNetInitRx
+
+  BOOLEAN                     RingEventIdx;      // VirtioNetInitialize
 
   VRING                       RxRing;            // VirtioNetInitRing
   VOID                        *RxRingMap;        // VirtioRingMap and
@@ -85,6 +90,8 @@ typedef struct {
   UINTN                       RxBufNrPages;      // VirtioNetInitRx
   EFI_PHYSICAL_ADDRESS        RxBufDeviceBase;   // VirtioNetInitRx
   VOID                        *RxBufMap;         // VirtioNetInitRx
+  UINT16                      RxLoanCount;       // VirtioNetInitRx
+  UINT16                      RxLoanGeneration;  // VirtioNetShutdownRx
 
   VRING                       TxRing;            // VirtioNetInitRing
   VOID                        *TxRingMap;        // VirtioRingMap and
@@ -112,6 +119,9 @@ typedef struct {
 #define VIRTIO_NET_FROM_SNP(SnpPointer) \
         CR (SnpPointer, VNET_DEV, Snp, VNET_SIG)
 
+#define VIRTIO_NET_FROM_RX_LOAN(RxLoanPointer) \
+        CR (RxLoanPointer, VNET_DEV, RxLoan, VNET_SIG)
+
 #define VIRTIO_CFG_WRITE(Dev, Field, Value)  ((Dev)->VirtIo->WriteDevice (  \
                                                 (Dev)->VirtIo,              \
                                                 OFFSET_OF_VNET (Field),     \
@@ -253,6 +263,26 @@ VirtioNetReceive (
   OUT UINT16                     *Protocol   OPTIONAL
   );
 
+//
+// member functions implementing the Simple Network Receive Loan Protocol
+//
+EFI_STATUS
+EFIAPI
+VirtioNetRxLoanReceive (
+  IN  EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL *This,
+  OUT UINTN                                 *HeaderSize,
+  OUT UINTN                                 *BufferSize,
+  OUT VOID                                  **Buffer,
+  OUT VOID                                  **Token
+  );
+
+VOID
+EFIAPI
+VirtioNetRxLoanRecycle (
+  IN EDKII_SIMPLE_NETWORK_RX_LOAN_PROTOCOL  *This,
+  IN VOID                                   *Token
+  );
+
 //
 // utility functions shared by various SNP member functions
 //
@@ -268,6 +298,22 @@ VirtioNetShutdownTx (
   IN OUT VNET_DEV *Dev
   );
 
+EFI_STATUS
+EFIAPI
+VirtioNetPublishAvail (
+  IN OUT VNET_DEV *Dev,
+  IN OUT VRING    *Ring,
+  IN     UINT16   Queue,
+  IN     UINT16   NewAvailIdx
+  );
+
+EFI_STATUS
+EFIAPI
+VirtioNetRecycleRxDesc (
+  IN OUT VNET_DEV *Dev,
+  IN     UINT16   DescIdx
+  );
+
 VOID
 EFIAPI
 VirtioNetUninitRing (